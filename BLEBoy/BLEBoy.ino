@@ -4,6 +4,7 @@
 #include <Wire.h>
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
+#include <SSD1306_Marquee.h>
 #include <Arduino.h>
 #include <bluefruit.h>
 #include <stdio.h>
@@ -12,6 +13,11 @@
 #include <string.h>
 #include <MenuSystem.h>
 #include <math.h>
+#include "JoyWingInput.h"
+#include "EventLoop.h"
+#include "LatencyLog.h"
+//menu tree and renderer, also built on the host (Scripts/host)
+#include "MenuScreens.h"
 
 
  
@@ -35,8 +41,6 @@
 #define BUTTON_LEFT  9
 #define BUTTON_UP    10
 #define BUTTON_SEL   14
-uint32_t button_mask = (1 << BUTTON_RIGHT) | (1 << BUTTON_DOWN) | 
-                (1 << BUTTON_LEFT) | (1 << BUTTON_UP) | (1 << BUTTON_SEL);
 
 #define IRQ_PIN   27
 
@@ -44,6 +48,16 @@ uint32_t button_mask = (1 << BUTTON_RIGHT) | (1 << BUTTON_DOWN) |
 Adafruit_SSD1306 display = Adafruit_SSD1306();
 //Adafruit_SSD1306 ssd1306 = display;
 Adafruit_seesaw ss;
+//JoyWing buttons and joystick, read by the seesaw bus task. The OLED shares
+//the I2C bus with it, hold input.BusGuard around display pushes once it runs
+JoyWingInput input(ss, IRQ_PIN);
+//loop() sleeps on this until input, BLE or a timer needs it
+EventLoop events;
+#define TIMER_MARQUEE 0
+#define TIMER_STATS   1
+#define MARQUEE_TICK_MS 33
+//key press to pixels timing, see Status > Latency
+LatencyLog latency;
 
 
 #if (SSD1306_LCDHEIGHT != 32)
@@ -53,6 +67,12 @@ Adafruit_seesaw ss;
 
 /******** CONFIG VALUES (Change if needed)********/
 char* bleDeviceName = "BLEBoy";
+//1 = at startup render the menus into an off-screen canvas and dump
+//them on Serial, see Scripts/BLEBoy_checkScreensFromSerial.py
+#define RENDER_CHECK 0
+//print loop wakes, idle time and the current estimate (and the input
+//latency report, if there were key presses) this often on Serial, 0 = never
+#define POWER_STATS_MS 60000
 /*******************************/
 
 /*** OTHER BLE CONFIGURATIONS ***/
@@ -73,7 +93,6 @@ void terminateAllConnections();
 #define fontX 5
 #define fontY 11
 #define MAX_DEPTH 4
-#define textScale 1
 
 void copyCurrentAddrToAddrString(uint8_t* addr);
 
@@ -82,6 +101,12 @@ int ledCtrl=LOW;
 int advertiseControl = 0;
 bool passkeyTriggered = false;
 bool passkeyDismissed = false;
+//OOB key type prompt shown, loop() hands it the key presses
+bool oobPrompt = false;
+//a passkey callback (BLE task) is blocked on promptKeys, loop() forwards
+//key presses to it
+volatile bool promptWaiting = false;
+QueueHandle_t promptKeys;
 
 bool lescStatus;
 bool bondedStatus;
@@ -92,155 +117,8 @@ uint8_t secModeStatus;
 uint8_t secLevelStatus;
 char* addrString = (char*)malloc(18*sizeof(char));//hex string separated by : (ie 00:11:22:33:44:55)
 
-void setBonding(MenuComponent* p_menu_component);
-void setLed(MenuComponent* p_menu_component);
-void setAdv(MenuComponent* p_menu_component);
-void terminateConnections(MenuComponent* p_menu_component);
 void updateStatus();
-void setStatus(MenuComponent* p_menu_component);
-void setLesc(MenuComponent* p_menu_component);
-void setKeypress(MenuComponent* p_menu_component);
-void setIO(MenuComponent* p_menu_component);
-void setOOB(MenuComponent* p_menu_component);
-void setMitm(MenuComponent* p_menu_component);
-void clearBonds(MenuComponent* p_menu_component);
 void on_item1_selected(MenuComponent* p_menu_component);
-void genOOBData(MenuComponent* p_menu_component);
-
-
-
-class CustomRenderer : public MenuComponentRenderer {
-public:
-    const int MAX_VIEWABLE = 2; // number of items that can be viewed at once
-    //2 allows one of the displayed items to line wrap
-    void render(Menu const& menu) const {
-      display.clearDisplay();
-      display.setCursor(0,0);
-      //display.print("\nCurrent menu name: ");
-      if(strlen(menu.get_name()) != 0){
-        display.print(menu.get_name());
-        display.println(":");
-      }
-      else{
-        display.println("   BLEBoy   ");
-        display.println("Press [select] to");
-        display.println("to the menu");
-      }
-      String buffer;
-      int start = 0;
-      for (int i = 0; i < menu.get_num_components(); ++i) {
-          MenuComponent const* cp_m_comp = menu.get_menu_component(i);
-          
-    
-          if (cp_m_comp->is_current()){
-            start = i;
-          }
-      }
-      int group;
-      if ( start == 0){
-            group = 0;
-          }
-      else{
-        group = floor(start/MAX_VIEWABLE);
-      }
-      int curGroup = 0;
-      for (int i = 0; i < menu.get_num_components(); ++i) {
-          MenuComponent const* cp_m_comp = menu.get_menu_component(i);
-          if ( i == 0){
-            curGroup = 0;
-          }
-          else{
-            curGroup = floor(i/MAX_VIEWABLE);
-          }
-          if (curGroup != group){
-            continue;
-          }
-    
-          if (cp_m_comp->is_current()){
-              display.print(">");
-          }
-            display.print(" ");
-            cp_m_comp->render(*this);
-            display.println("");
-          
-      }
-      display.display();
-    }
-
-    void render_menu_item(MenuItem const& menu_item) const {
-        
-        display.print(menu_item.get_name());
-        display.display();
-    }
-
-    void render_config_menu_item(ConfigMenuItem const& menu_item) const {
-        
-        display.print(menu_item.get_name());
-        display.print(":");
-        display.print(menu_item.get_value());
-        display.display();
-    }
-
-    void render_back_menu_item(BackMenuItem const& menu_item) const {
-        display.print(menu_item.get_name());
-        display.display();
-    }
-
-    void render_numeric_menu_item(NumericMenuItem const& menu_item) const {
-      String buffer;
-
-      buffer = menu_item.get_name();
-      buffer += menu_item.has_focus() ? '<' : '=';
-      buffer += menu_item.get_formatted_value();
-  
-      if (menu_item.has_focus())
-          buffer += '>';
-  
-      display.print(buffer);
-      display.display();
-    }
-
-
-    void render_menu(Menu const& menu) const {
-        display.print(menu.get_name());
-        display.display();
-    }
-};
-
-
-
-
-
-// Menu variables
-CustomRenderer my_renderer;
-MenuSystem ms(my_renderer);
-Menu mm("Main Menu");
-
-ConfigMenuItem muLed("Off","LED",&setLed);
-ConfigMenuItem muAdv("Off","Advertising",&setAdv);
-
-MenuItem mu_terminate("Terminate Connections",&terminateConnections);
-
-Menu muStatus("Status");
-//TODO need to do an update check each loop and update these config values (for status)
-ConfigMenuItem muStatus_miAddr("00:00:00:00:00:00", "Addr", &setStatus);
-ConfigMenuItem muStatus_miConn("False", "Connected", &setStatus);
-ConfigMenuItem muStatus_miLesc("False", "LESC", &setStatus);
-ConfigMenuItem muStatus_miAM("None", "Asc.Model", &setStatus);
-ConfigMenuItem muStatus_miBond("False", "Bonded", &setStatus);
-ConfigMenuItem muStatus_miSecMode("None", "SecMode", &setStatus);
-ConfigMenuItem muStatus_miSecLevel("None", "SecLevel", &setStatus);
-
-
-Menu muSettings("Settings");
-ConfigMenuItem muSettings_miBond("1","Bonding",&setBonding);
-ConfigMenuItem muSettings_miLesc("1","LESC",&setLesc);
-ConfigMenuItem muSettings_miMitm("1","MitM",&setMitm);
-ConfigMenuItem muSettings_miKeypress("1","Keypress",&setKeypress);
-ConfigMenuItem muSettings_miIO("DisplayOnly","IO",&setIO);
-ConfigMenuItem muSettings_miOOB("0","OOB",&setOOB);
-MenuItem muSettings_miClearBonds("Clear Bonds",&clearBonds);
-MenuItem mu_genoob("GenOOBData",&genOOBData);
 
 
 
@@ -249,154 +127,53 @@ MenuItem mu_genoob("GenOOBData",&genOOBData);
 
 /****************** MENU EVENTS *************************/
 
+//selecting a latency row refreshes it and prints the full report
+void printLatency(MenuComponent* p_menu_component){
+  latency.printReport(Serial);
+}
+
+//the items have already toggled/stepped their value when these are called
 void setBonding(MenuComponent* p_menu_component) {
-    char* temp = (char*)malloc(2*sizeof(char));
-    if (bond == 0){
-      bond = 1;
-      strncpy(temp,"1",2);
-      *(temp+2) = '\0'; 
-    }
-    else{
-      bond = 0;
-      strncpy(temp,"0",2);
-      *(temp+2) = '\0'; 
-    }
+    bond = muSettings_miBond.get_value();
     updateSecurityParameters();
-    muSettings_miBond.set_value(temp);
 }
 
 void setLed(MenuComponent* p_menu_component){
-    char* temp = (char*)malloc(4*sizeof(char));
-    if (ledCtrl == HIGH){
-      ledCtrl = LOW;
-      strncpy(temp,"Off",4);
-      *(temp+4) = '\0'; 
-    }
-    else{
-      ledCtrl = HIGH;
-      strncpy(temp,"On",3);
-      *(temp+3) = '\0'; 
-    }
-    muLed.set_value(temp);
+    ledCtrl = muLed.get_value() ? HIGH : LOW;
 }
 void setAdv(MenuComponent* p_menu_component){
-  char* temp = (char*)malloc(4*sizeof(char));
-  if (advertising == false){
-    advertising = true;
-    strncpy(temp,"On",3);
-    *(temp+3) = '\0'; 
+  advertising = muAdv.get_value();
+  if (advertising){
     beginAdvertising();
   }
   else{
-    advertising = false;
-    strncpy(temp,"Off",4);
-    *(temp+4) = '\0'; 
     endAdvertising();
   }
-  muAdv.set_value(temp);
 }
 void terminateConnections(MenuComponent* p_menu_component){
   terminateAllConnections();
 }
 
 void setLesc(MenuComponent* p_menu_component){
-  char* temp = (char*)malloc(2*sizeof(char));
-  if (lesc == 0){
-    lesc = 1;
-    strncpy(temp,"1",2);
-    *(temp+2) = '\0'; 
-  }
-  else{
-    lesc = 0;
-    strncpy(temp,"0",2);
-    *(temp+2) = '\0'; 
-  }
+  lesc = muSettings_miLesc.get_value();
   updateSecurityParameters();
-  muSettings_miLesc.set_value(temp);
 }
 
 void setMitm(MenuComponent* p_menu_component){
-  char* temp = (char*)malloc(2*sizeof(char));
-  if (mitm == 0){
-    mitm = 1;
-    strncpy(temp,"1",2);
-    *(temp+2) = '\0'; 
-  }
-  else{
-    mitm = 0;
-    strncpy(temp,"0",2);
-    *(temp+2) = '\0'; 
-  }
+  mitm = muSettings_miMitm.get_value();
   updateSecurityParameters();
-  muSettings_miMitm.set_value(temp);
 }
 void setKeypress(MenuComponent* p_menu_component){
-  char* temp = (char*)malloc(2*sizeof(char));
-  if (keypress == 0){
-    keypress = 1;
-    strncpy(temp,"1",2);
-    *(temp+2) = '\0'; 
-  }
-  else{
-    keypress = 0;
-    strncpy(temp,"0",2);
-    *(temp+2) = '\0'; 
-  }
+  keypress = muSettings_miKeypress.get_value();
   updateSecurityParameters();
-  muSettings_miKeypress.set_value(temp);
 }
 void setIO(MenuComponent* p_menu_component){
-  char* temp = (char*)malloc(16*sizeof(char));
-  /*,VALUE("DisplayOnly",0,setIO0,noEvent)
-  ,VALUE("DisplayYesNo",1,setIO1,noEvent)
-  ,VALUE("KeyboardOnly",2,setIO2,noEvent)
-  ,VALUE("NoInputNoOutput",3,setIO3,noEvent)
-  ,VALUE("KeyboardDisplay",4,setIO4,noEvent)
-  */
-  switch(io){
-    case 0:
-      io = 1;
-      strncpy(temp,"DisplayYesNo",13);
-      *(temp+13) = '\0';
-      break;
-    case 1:
-      io = 2;
-      strncpy(temp,"KeyboardOnly",13);
-      *(temp+13) = '\0';
-      break;
-    case 2:
-      io = 3;
-      strncpy(temp,"NoInputNoOutput",16);
-      *(temp+16) = '\0';
-      break;
-    case 3:
-      io = 4;
-      strncpy(temp,"KeyboardDisplay",16);
-      *(temp+16) = '\0';
-      break;
-    case 4:
-      io = 0;
-      strncpy(temp,"DisplayOnly",12);
-      *(temp+12) = '\0';
-      break;
-  }
+  io = muSettings_miIO.get_value();
   updateSecurityParameters();
-  muSettings_miIO.set_value(temp);
 }
 void setOOB(MenuComponent* p_menu_component){
-  char* temp = (char*)malloc(2*sizeof(char));
-  if (oob == 0){
-    oob = 1;
-    strncpy(temp,"1",2);
-    *(temp+2) = '\0'; 
-  }
-  else{
-    oob = 0;
-    strncpy(temp,"0",2);
-    *(temp+2) = '\0'; 
-  }
+  oob = muSettings_miOOB.get_value();
   updateSecurityParameters();
-  muSettings_miOOB.set_value(temp);
 }
 
 void clearBonds(MenuComponent* p_menu_component){
@@ -446,15 +223,23 @@ void genOOBData(MenuComponent* p_menu_component){
   Bluefruit.generateOOBData(connHandle);
 
   // need to choose Legacy vs SC (up SC, down Legacy)
+  my_renderer.marquee.end();
+  ms.invalidate();
+  display.beginFrame();
   display.clearDisplay();
   display.setCursor(0,0);
-  //display.display();
-  display.println("Generated OOB Data.");
-  display.println("Select a key type");
-  //display.println(":");
-  display.println("<Up> SC to Serial");
-  display.println("<Down> Legacy to Serial");
-  display.display();
+  display.printWrapped("Generated OOB Data. Select a key type", 0, 0);
+  display.printWrapped("<Up> SC, <Down> Legacy to Serial", 0, display.getCursorY());
+  {
+    JoyWingInput::BusGuard bus(input);
+    display.endFrame();
+  }
+  //loop() passes the key presses to oobPromptKey() from here on
+  oobPrompt = true;
+}
+
+//Handles a key press on the OOB key type prompt
+void oobPromptKey(uint8_t pressed){
   const int ADDRESS_DATA_TYPE = 0x1B;
   const int LE_ROLE_DATA_TYPE = 0x1C;
   const int APPEARANCE_DATA_TYPE = 0x19;
@@ -477,156 +262,149 @@ void genOOBData(MenuComponent* p_menu_component){
   int nameLen;
   int index = 0;
   int buffLen = 0;
-  //Block until user exits. 
-  while(true){
-          if(!digitalRead(IRQ_PIN)){
-            uint32_t buttons = ss.digitalReadBulk(button_mask);
-            if(! (buttons & (1 << BUTTON_DOWN))){
-              //Legacy
-              key = Bluefruit.getLegacyOOBKey();
-              periph_name = Bluefruit.getName();
-              addr = Bluefruit.getAddr();
-              nameLen = strlen(periph_name);
-              /*
-              * addrSize (1) + addrDataType (1) + addr (6) + addrType (1) + tkSize (1)+
-              * tkDataType (1) + tk (16) + 
-              * nameLength (1) + nameDataType (1) + name (sizeof name)
-              */
-              buffLen = (1+1+6+1+1+1+16+1+1+nameLen);
-              uint8_t oobNFCPayload[buffLen];
-              index = 0;
+  if(pressed == JOY_DOWN){
+    //Legacy
+    key = Bluefruit.getLegacyOOBKey();
+    periph_name = Bluefruit.getName();
+    addr = Bluefruit.getAddr();
+    nameLen = strlen(periph_name);
+    /*
+    * addrSize (1) + addrDataType (1) + addr (6) + addrType (1) + tkSize (1)+
+    * tkDataType (1) + tk (16) + 
+    * nameLength (1) + nameDataType (1) + name (sizeof name)
+    */
+    buffLen = (1+1+6+1+1+1+16+1+1+nameLen);
+    uint8_t oobNFCPayload[buffLen];
+    index = 0;
               
-              oobNFCPayload[index] = ADDRESS_SIZE;
-              index++;
-              oobNFCPayload[index] = ADDRESS_DATA_TYPE;
-              index++;
-              for( int i = 0; i < ADDRESS_SIZE; i++){
-              oobNFCPayload[index] = addr[i];
-              index++;
-              }
-              //TODO: we configured the device to use the public address type,
-              //later we can make this a dynamic option.
-              oobNFCPayload[index] = ADDRESS_TYPE_PUBLIC;
-              index++;
+    oobNFCPayload[index] = ADDRESS_SIZE;
+    index++;
+    oobNFCPayload[index] = ADDRESS_DATA_TYPE;
+    index++;
+    for( int i = 0; i < ADDRESS_SIZE; i++){
+    oobNFCPayload[index] = addr[i];
+    index++;
+    }
+    //TODO: we configured the device to use the public address type,
+    //later we can make this a dynamic option.
+    oobNFCPayload[index] = ADDRESS_TYPE_PUBLIC;
+    index++;
               
-              oobNFCPayload[index] = SECURITY_KEY_SIZE;
-              index++;
-              oobNFCPayload[index] = SECURITY_KEY_DATA_TYPE;
-              index++;
-              for( int i = 0; i < SECURITY_KEY_SIZE; i++){
-              oobNFCPayload[index] = key[i];
-              index++;
-              }
+    oobNFCPayload[index] = SECURITY_KEY_SIZE;
+    index++;
+    oobNFCPayload[index] = SECURITY_KEY_DATA_TYPE;
+    index++;
+    for( int i = 0; i < SECURITY_KEY_SIZE; i++){
+    oobNFCPayload[index] = key[i];
+    index++;
+    }
               
-              oobNFCPayload[index] = nameLen;
-              index++;
-              oobNFCPayload[index] = LOCAL_NAME_DATA_TYPE;
-              index++;
-              for( int i = 0; i < nameLen; i++){
-              oobNFCPayload[index] = (uint8_t) periph_name[i];
-              index++;
-              }
+    oobNFCPayload[index] = nameLen;
+    index++;
+    oobNFCPayload[index] = LOCAL_NAME_DATA_TYPE;
+    index++;
+    for( int i = 0; i < nameLen; i++){
+    oobNFCPayload[index] = (uint8_t) periph_name[i];
+    index++;
+    }
               
-              Serial.println("Writing NFC Payload");
-              Serial.print("Len: ");
-              Serial.println(buffLen);
-              Serial.write(oobNFCPayload, buffLen);
-              Serial.println("");
-              Serial.println("Finished write");
-
-              Serial.println("Printing params:");
+    Serial.println("Writing NFC Payload");
+    Serial.print("Len: ");
+    Serial.println(buffLen);
+    Serial.write(oobNFCPayload, buffLen);
+    Serial.println("");
+    Serial.println("Finished write");
+
+    Serial.println("Printing params:");
               
-              Serial.print("Name: ");
-              Serial.println(periph_name);
-              Serial.print("Addr: ");
-              char* tempAddr = (char*)malloc(7);
-              int b = sprintf(tempAddr, "%02x:%02x:%02x:%02x:%02x:%02x", addr[5], addr[4], addr[3], addr[2], addr[1], addr[0]);
-              Serial.println(tempAddr);
-              Serial.print("Key: ");
-              Serial.println(uint8ToHex(key, SECURITY_KEY_SIZE));
-            }
-            if(! (buttons & (1 << BUTTON_UP))){
-              // SC
-             r = Bluefruit.getSCOOBRandom();
-             c = Bluefruit.getSCOOBConfirm();
-             periph_name = Bluefruit.getName();
-             addr = Bluefruit.getAddr();
-             nameLen = strlen(periph_name);
-             /*
-              * addrSize (1) + addrDataType (1) + addr (6) + addrType (1) + confirmSize (1)+
-              * confirmDataType (1) + confirm (16) + randomSize(1) + randomDataType(1) + 
-              * random (16) + nameLength (1) + nameDataType (1) + name (sizeof name)
-              */
-              buffLen = (1+1+1+6+1+1+16+1+1+16+1+1+nameLen);
-              uint8_t oobNFCPayload[buffLen];
-              index = 0;
+    Serial.print("Name: ");
+    Serial.println(periph_name);
+    Serial.print("Addr: ");
+    char* tempAddr = (char*)malloc(7);
+    int b = sprintf(tempAddr, "%02x:%02x:%02x:%02x:%02x:%02x", addr[5], addr[4], addr[3], addr[2], addr[1], addr[0]);
+    Serial.println(tempAddr);
+    Serial.print("Key: ");
+    Serial.println(uint8ToHex(key, SECURITY_KEY_SIZE));
+  }
+  if(pressed == JOY_UP){
+    // SC
+   r = Bluefruit.getSCOOBRandom();
+   c = Bluefruit.getSCOOBConfirm();
+   periph_name = Bluefruit.getName();
+   addr = Bluefruit.getAddr();
+   nameLen = strlen(periph_name);
+   /*
+    * addrSize (1) + addrDataType (1) + addr (6) + addrType (1) + confirmSize (1)+
+    * confirmDataType (1) + confirm (16) + randomSize(1) + randomDataType(1) + 
+    * random (16) + nameLength (1) + nameDataType (1) + name (sizeof name)
+    */
+    buffLen = (1+1+1+6+1+1+16+1+1+16+1+1+nameLen);
+    uint8_t oobNFCPayload[buffLen];
+    index = 0;
               
-              oobNFCPayload[index] = ADDRESS_SIZE;
-              index++;
-              oobNFCPayload[index] = ADDRESS_DATA_TYPE;
-              index++;
-              for( int i = 0; i < ADDRESS_SIZE; i++){
-              oobNFCPayload[index] = addr[i];
-              index++;
-              }
-              //TODO: we configured the device to use the public address type,
-              //later we can make this a dynamic option.
-              oobNFCPayload[index] = ADDRESS_TYPE_PUBLIC;
-              index++;
+    oobNFCPayload[index] = ADDRESS_SIZE;
+    index++;
+    oobNFCPayload[index] = ADDRESS_DATA_TYPE;
+    index++;
+    for( int i = 0; i < ADDRESS_SIZE; i++){
+    oobNFCPayload[index] = addr[i];
+    index++;
+    }
+    //TODO: we configured the device to use the public address type,
+    //later we can make this a dynamic option.
+    oobNFCPayload[index] = ADDRESS_TYPE_PUBLIC;
+    index++;
               
-              oobNFCPayload[index] = LESC_CONFIRM_SIZE;
-              index++;
-              oobNFCPayload[index] = LESC_CONFIRM_TYPE;
-              index++;
-              for( int i = 0; i < LESC_CONFIRM_SIZE; i++){
-              oobNFCPayload[index] = c[i];
-              index++;
-              }
+    oobNFCPayload[index] = LESC_CONFIRM_SIZE;
+    index++;
+    oobNFCPayload[index] = LESC_CONFIRM_TYPE;
+    index++;
+    for( int i = 0; i < LESC_CONFIRM_SIZE; i++){
+    oobNFCPayload[index] = c[i];
+    index++;
+    }
               
-              oobNFCPayload[index] = LESC_RANDOM_SIZE;
-              index++;
-              oobNFCPayload[index] = LESC_RANDOM_TYPE;
-              index++;
-              for( int i = 0; i < LESC_RANDOM_SIZE; i++){
-              oobNFCPayload[index] = r[i];
-              index++;
-              }
+    oobNFCPayload[index] = LESC_RANDOM_SIZE;
+    index++;
+    oobNFCPayload[index] = LESC_RANDOM_TYPE;
+    index++;
+    for( int i = 0; i < LESC_RANDOM_SIZE; i++){
+    oobNFCPayload[index] = r[i];
+    index++;
+    }
               
-              oobNFCPayload[index] = nameLen;
-              index++;
-              oobNFCPayload[index] = LOCAL_NAME_DATA_TYPE;
-              index++;
-              for( int i = 0; i < nameLen; i++){
-              oobNFCPayload[index] = (uint8_t) periph_name[i];
-              index++;
-              }
-              Serial.println("Writing NFC Payload");
-              Serial.print("Len: ");
-              Serial.println(buffLen);
-              Serial.write(oobNFCPayload, buffLen);
-              Serial.println("");
-              Serial.println("Finished write");
-
-              Serial.println("Printing params:");
+    oobNFCPayload[index] = nameLen;
+    index++;
+    oobNFCPayload[index] = LOCAL_NAME_DATA_TYPE;
+    index++;
+    for( int i = 0; i < nameLen; i++){
+    oobNFCPayload[index] = (uint8_t) periph_name[i];
+    index++;
+    }
+    Serial.println("Writing NFC Payload");
+    Serial.print("Len: ");
+    Serial.println(buffLen);
+    Serial.write(oobNFCPayload, buffLen);
+    Serial.println("");
+    Serial.println("Finished write");
+
+    Serial.println("Printing params:");
               
-              Serial.print("Name: ");
-              Serial.println(periph_name);
-              Serial.print("Addr: ");
-              char* tempAddr = (char*)malloc(7);
-              int b = sprintf(tempAddr, "%02x:%02x:%02x:%02x:%02x:%02x", addr[5], addr[4], addr[3], addr[2], addr[1], addr[0]);
-              Serial.println(tempAddr);
-              Serial.print("Confirm: ");
-              Serial.println(uint8ToHex(c, LESC_CONFIRM_SIZE));
-              Serial.print("Random: ");
-              Serial.println(uint8ToHex(r, LESC_RANDOM_SIZE));
-            }
-            if(! (buttons & (1 << BUTTON_LEFT))){
-              break;
-            }
-          }
+    Serial.print("Name: ");
+    Serial.println(periph_name);
+    Serial.print("Addr: ");
+    char* tempAddr = (char*)malloc(7);
+    int b = sprintf(tempAddr, "%02x:%02x:%02x:%02x:%02x:%02x", addr[5], addr[4], addr[3], addr[2], addr[1], addr[0]);
+    Serial.println(tempAddr);
+    Serial.print("Confirm: ");
+    Serial.println(uint8ToHex(c, LESC_CONFIRM_SIZE));
+    Serial.print("Random: ");
+    Serial.println(uint8ToHex(r, LESC_RANDOM_SIZE));
+  }
+  if(pressed == JOY_LEFT){
+    oobPrompt = false;
+    events.post(EVENT_REDRAW);
   }
-  passkeyDismissed = true;
-
 }
 /******************************************/
 
@@ -661,12 +439,30 @@ char* uint8ToHex(uint8_t* str, int size){
 void bleConnectCallback() {
   bleConnected = true;
   Serial.println("Successful connection.");
+  events.post(EVENT_CONNECT);
 }
 
 void bleDisconnectCallback(uint8_t reason) {
   bleConnected = false;
   Serial.print("Disconnect. Reason: ");
   Serial.println(reason, DEC);
+  events.post(EVENT_DISCONNECT, reason);
+}
+
+//JoyWing events, called in the seesaw bus task
+void onJoyWingEvent(const JoyWingEvent& ev, void* arg){
+  events.post(EVENT_INPUT, ev.key, ev.type, ev.at);
+}
+
+//Blocks the calling (BLE) task until loop() forwards an up or down press
+uint8_t waitPromptKey(){
+  uint8_t key = 0;
+  xQueueReset(promptKeys);
+  promptWaiting = true;
+  while(xQueueReceive(promptKeys, &key, portMAX_DELAY) != pdTRUE || (key != JOY_UP && key != JOY_DOWN)){
+  }
+  promptWaiting = false;
+  return key;
 }
 
 //Using serial read/write for peripheral passkey entry.
@@ -680,11 +476,15 @@ void blePasskeyEntryCallback(uint16_t connHandle, bool sendKeypressNotifications
      int inputCounter = 0;
      passkeyTriggered = true;
      Bluefruit.sendKeypressNotification(connHandle, BLE_GAP_KP_NOT_TYPE_PASSKEY_START);
+     my_renderer.marquee.end();
+     ms.invalidate();
+     display.beginFrame();
      display.clearDisplay();
-      display.setCursor(0,0);
-      display.println("Enter passkey");
-      display.println("using Serial1 conn");
-      display.display();
+      display.printWrapped("Enter passkey using Serial1 conn", 0, 0);
+      {
+        JoyWingInput::BusGuard bus(input);
+        display.endFrame();
+      }
      Serial.println("<UserInputRequired>Please enter passkey displayed on Central device");
      Serial.print("Timeout = ");
      Serial.print(timeout/1000,DEC);
@@ -692,8 +492,12 @@ void blePasskeyEntryCallback(uint16_t connHandle, bool sendKeypressNotifications
      Serial.print(">");
      //While loop configured for timeout (default 30 seconds) and a max passkey of 6 digits. Only
      //accepts numeric ascii values (0-9) and ignores all other input.
+     //Serial has no event to block on, sleep between polls.
      while(true){
-      if(Serial.available() > 0){
+      if(Serial.available() <= 0){
+        delay(20);
+      }
+      else{
         incomingByte = Serial.read();
         //input should only allow numbers, dec 48-57 (inclusive)
         if(incomingByte > 47 && incomingByte < 58){
@@ -718,6 +522,7 @@ void blePasskeyEntryCallback(uint16_t connHandle, bool sendKeypressNotifications
      Serial.print("User supplied passkey:");
      Serial.println((char*)passkey);
      passkeyDismissed = true;
+     events.post(EVENT_REDRAW);
   
 }
 
@@ -727,53 +532,39 @@ void blePasskeyDisplayCallback(int match_request, const uint8_t* passkey, int* r
   Serial.print("Match request: ");
   Serial.println(match_request, DEC);
   
+  my_renderer.marquee.end();
+  ms.invalidate();
+  display.beginFrame();
   display.clearDisplay();
   display.setCursor(0,0);
-  display.display();
   display.println("PASSKEY:");
   display.println((char*)passkey);
   
   if(match_request == 0){
-    display.println("Press up or down to continue.");
-    display.display();
-    *result = 1;
-    while(true){
-            if(!digitalRead(IRQ_PIN)){
-              uint32_t buttons = ss.digitalReadBulk(button_mask);
-              if(! (buttons & (1 << BUTTON_DOWN))){
-                //*result = 0;
-                break;
-              }
-              if(! (buttons & (1 << BUTTON_UP))){
-                //*result = 1;
-                break;
-              }
-            }
+    display.printWrapped("Press up or down to continue.", 0, display.getCursorY());
+    {
+      JoyWingInput::BusGuard bus(input);
+      display.endFrame();
     }
+    *result = 1;
+    waitPromptKey();
     passkeyDismissed = true;
+    events.post(EVENT_REDRAW);
   }
   if(match_request == 1){
     display.println("<Up> if match.");
     display.println("<Down> if no match.");
-    display.display();
+    {
+      JoyWingInput::BusGuard bus(input);
+      display.endFrame();
+    }
     
     //Block until we get confirmation from the user
     //This implements the user input requirement for numeric comparison.
     //When match_request == 1, we must report if there is a match
-    while(true){
-            if(!digitalRead(IRQ_PIN)){
-              uint32_t buttons = ss.digitalReadBulk(button_mask);
-              if(! (buttons & (1 << BUTTON_DOWN))){
-                *result = 0;
-                break;
-              }
-              if(! (buttons & (1 << BUTTON_UP))){
-                *result = 1;
-                break;
-              }
-            }
-    }
+    *result = (waitPromptKey() == JOY_UP) ? 1 : 0;
     passkeyDismissed = true;
+    events.post(EVENT_REDRAW);
     
      
   }
@@ -919,6 +710,11 @@ void setupCharacteristics() {
 void setup() {  
   Serial.begin(9600);
   Serial.println("Begin BLEBoy setup.");
+  if(!events.begin()){
+    Serial.println("ERROR! No memory for the event queue.");
+    while(1);
+  }
+  promptKeys = xQueueCreate(4, sizeof(uint8_t));
   
   /***** BUTTON SETUP ****/
   pinMode(BUTTON_UP, INPUT);
@@ -936,9 +732,6 @@ void setup() {
     Serial.print("version: ");
     Serial.println(ss.getVersion(), HEX);
   }
-  ss.pinModeBulk(button_mask, INPUT_PULLUP);
-  ss.setGPIOInterrupts(button_mask, 1);
-  pinMode(IRQ_PIN, INPUT);
   /***********************/
 
   /****** OLED Init ******/
@@ -970,6 +763,7 @@ void setup() {
   display.setTextSize(1);
   display.setTextColor(WHITE);
   display.setCursor(0,0);
+  display.enableTextCache(); //static screens are measured once
   display.display();
 
   /*******************************/
@@ -986,28 +780,7 @@ void setup() {
   display.clearDisplay();
   
   // Menu setup
-  ms.get_root_menu().add_menu(&mm);
-
-  mm.add_item(&muLed);
-  mm.add_item(&muAdv);
-  mm.add_item(&mu_terminate);
-  mm.add_item(&mu_genoob);
-  mm.add_menu(&muStatus);
-  muStatus.add_item(&muStatus_miAddr);
-  muStatus.add_item(&muStatus_miConn);
-  //muStatus.add_item(&muStatus_miLesc);
-  //muStatus.add_item(&muStatus_miAM);
-  muStatus.add_item(&muStatus_miBond);
-  muStatus.add_item(&muStatus_miSecMode);
-  muStatus.add_item(&muStatus_miSecLevel);
-  mm.add_menu(&muSettings);
-  muSettings.add_item(&muSettings_miBond);
-  muSettings.add_item(&muSettings_miLesc);
-  muSettings.add_item(&muSettings_miMitm);
-  muSettings.add_item(&muSettings_miKeypress);
-  muSettings.add_item(&muSettings_miIO);
-  muSettings.add_item(&muSettings_miOOB);
-  muSettings.add_item(&muSettings_miClearBonds);
+  setupMenus();
   
   /******************************************/
 
@@ -1039,8 +812,22 @@ void setup() {
   Serial.println(addrString);
   /*********************************/
   Serial.println("Initialization complete.");
+
+#if RENDER_CHECK
+  renderCheck();
+#endif
   
   ms.display();
+
+  //from here on the input task shares the I2C bus
+  input.setEventCallback(onJoyWingEvent);
+  if(!input.begin()){
+    Serial.println("JoyWing input task failed to start.");
+  }
+  if(POWER_STATS_MS){
+    events.startTimer(TIMER_STATS, POWER_STATS_MS);
+  }
+  events.resetStats();
 }
 
 /******************************************************************/
@@ -1065,189 +852,147 @@ void terminateAllConnections() {
   Serial.println("Connections terminated.");
 }
 /******************************************************************/
+#if RENDER_CHECK
+//prints everything written to it as hex on Serial
+class SerialHexPrint : public Print {
+public:
+    size_t write(uint8_t b) {
+      if (b < 0x10) Serial.print('0');
+      Serial.print(b, HEX);
+      return 1;
+    }
+};
+
+//Renders the menus into an off-screen canvas and prints for each
+//  SCREEN <name> <render us> <pixels> <glyph columns> <lines> <bus bytes>
+//  PBM <name> <P4 image as hex>
+void renderCheck(){
+  SSD1306_Canvas canvas;
+  if(!canvas.begin()){
+    Serial.println("RENDER_CHECK: no memory for the canvas");
+    return;
+  }
+  SerialHexPrint hex;
+  beginRenderCheck(canvas);
+  for(uint8_t i = 0; i < CHECK_SCREENS; i++){
+    renderCheckScreen(canvas, i, Serial);
+    Serial.print("PBM "); Serial.print(checkScreenNames[i]); Serial.print(" ");
+    canvas.writePBM(hex);
+    Serial.println("");
+  }
+  endRenderCheck();
+}
+#endif
+
 void updateMenu(){
   //OLED set up
-  display.display();    
   display.clearDisplay();
   display.setTextSize(1);
   display.setTextColor(WHITE);
   ms.display();
   //Serial.println("");
 }
-int last_x = 0, last_y = 0;
-void loop() {
-  bool change=false;
-//upCmd = down menu item
-//downCmd = up menu item
-/* Can enable buttons on OLED Featherwing, but for now I'm relying on Joy Featherwing
-  if (! digitalRead(BUTTON_A)){
-    delay(100);
-      while(digitalRead(BUTTON_A) == LOW);
-      nav.doNav(downCmd);
-      if(passkeyTriggered){
-        passkeyDismissed = true;
-      }
-  }
-  if (! digitalRead(BUTTON_B)){
-    delay(100);
-      while(digitalRead(BUTTON_B) == LOW);
-      nav.doNav(enterCmd);
-      if(passkeyTriggered){
-        passkeyDismissed = true;
-      }
+//Menu navigation, or the key for the prompt that is showing
+void handleInput(uint8_t key, uint8_t type){
+  if(type != JOY_PRESS && type != JOY_REPEAT){
+    return;
   }
-  if (! digitalRead(BUTTON_C)){
-    delay(100);
-      while(digitalRead(BUTTON_C) == LOW);
-      nav.doNav(upCmd);
-      if(passkeyTriggered){
-        passkeyDismissed = true;
-      }
-  }*/
-  //JoyWing Joystick
-  //only allowing up and down movement for now
-  int x = ss.analogRead(2);
-  int y = ss.analogRead(3);
-  //Serial.printf("X: %d, Y: %d\n", x, y);  a
-  
-  /*   Joystick Values
-   *        0
-   *        |
-   * 0------|-------1023   y
-   *        |
-   *       1023
-   *        x
-   *       
-   *       Center Point (where we don't register a move)
-   *       1024/2 and we'll add a tolerance of 12
-   *       500 - 524 , 500 - 524
-   *       
-   *       \     |     /  x = 1023 - y (eq1)
-             \   |   /
-               \ | /
-          -------|--------   y
-               / | \
-             /   |   \
-           /     |     \
-   *             x        x = y (eq2)
-   *       
-   *       take y coordinate and calculate x on each line
-   *       if y read > 512 then mid dir = right, else mid dir = left
-   *       if x read (from joystick) is greater than eq1 x and less than eq 2 x, then it's right
-   *        else if x read < eq1 and > eq2, then it's left
-   *        else if x read < eq1 x then use up
-   *        else if x read > eq2 x then use down
-   *       
-   *       
-   */
-  if ( ((abs(x - last_x) > 50)  ||  (abs(y - last_y) > 50))) {
-  //if ( (abs(x - last_x) > 50) ) {
-    //Serial.print(x); Serial.print(", "); Serial.println(y);
-    int eq1 = 1023 - y;
-    int eq2 = y;
-    if ( x > eq1 && x < eq2 ){
-      if ( y >= 550 && y <= 1024){
-        //move right
-        Serial.println("Analog right pressed");
-        //nav.doNav(enterCmd);
-        ms.select();
-        change=true;
-        if(passkeyTriggered){
-          passkeyDismissed = true;
-        }
-      }
-      
+  if(promptWaiting){
+    if(type == JOY_PRESS){
+      xQueueSend(promptKeys, &key, 0);
     }
-    else if ( x < eq1 && x > eq2 ){
-      //determine if left or right move
-      if ( y >= 0 && y <= 500){
-        //move left 
-        ms.back();
-        change=true;
-        if(passkeyTriggered){
-          passkeyDismissed = true;
-        }
-      }
-      
-    }
-    else if ( x <= eq1 && x >= 0 && x <= 500){
-      //move up
-      ms.prev();
-      change=true;
-      if(passkeyTriggered){
-        passkeyDismissed = true;
-      }
-    }
-    else if ( x >= eq2 && x >= 550 && x <= 1024) {
-      //move down
-      ms.next();
-      change=true;
-      if(passkeyTriggered){
-        passkeyDismissed = true;
-      }
+    return;
+  }
+  if(oobPrompt){
+    if(type == JOY_PRESS){
+      oobPromptKey(key);
     }
-    delay(10);
-    last_x = x;
-    last_y = y;
+    return;
+  }
+  //passkey entry on Serial, keys don't do anything meanwhile
+  if(passkeyTriggered && !passkeyDismissed){
+    return;
   }
-  //JoyWing Momentary Switches
-  // pin 27 on JoyWing must have option interrupt shorted
-  if(!digitalRead(IRQ_PIN)){
-    uint32_t buttons = ss.digitalReadBulk(button_mask);
-    if (! (buttons & (1 << BUTTON_RIGHT))) {
-      delay(10);
+  switch(key){
+    case JOY_RIGHT:
+    case JOY_SELECT:
       ms.select();
-      change=true;
-      if(passkeyTriggered){
-        passkeyDismissed = true;
-      }
-    }
-    if (! (buttons & (1 << BUTTON_DOWN))) {
-      delay(10);
-      ms.next();
-      change=true;
-      if(passkeyTriggered){
-        passkeyDismissed = true;
-      }
-    }
-    if (! (buttons & (1 << BUTTON_LEFT))) {
-      delay(10);
+      break;
+    case JOY_LEFT:
       ms.back();
-      change=true;
-      if(passkeyTriggered){
-        passkeyDismissed = true;
-      }
-    }
-    if (! (buttons & (1 << BUTTON_UP))) {
-      delay(10);
+      break;
+    case JOY_UP:
       ms.prev();
-      change=true;
-      if(passkeyTriggered){
-        passkeyDismissed = true;
+      break;
+    case JOY_DOWN:
+      ms.next();
+      break;
+  }
+  updateStatus();
+  digitalWrite(LED_BUILTIN,ledCtrl);
+}
+
+//Sleeps until something happens: JoyWing input, BLE connection changes,
+//a prompt finishing or a timer (marquee steps, power statistics)
+void loop() {
+  LoopEvent ev;
+  if(!events.wait(ev)){
+    return;
+  }
+  switch(ev.type){
+    case EVENT_INPUT:
+      //IRQ and read times come with the event
+      if(ev.b == JOY_PRESS || ev.b == JOY_REPEAT){
+        latency.begin(ev.at, ev.us);
       }
-    }
-    if (! (buttons & (1 << BUTTON_SEL))) {
-      delay(10);
-    }
+      handleInput(ev.a, ev.b);
+      latency.mark(LAT_ACTION);
+      break;
+    case EVENT_CONNECT:
+    case EVENT_DISCONNECT:
+      updateStatus();
+      break;
+    case EVENT_TIMER:
+      if(ev.a == TIMER_STATS){
+        events.printStats(Serial);
+        if(latency.count()){
+          latency.printReport(Serial);
+        }
+      }
+      break;
   }
-  
-  //Clears passkey display after button has
-  //been pressed. Removes artifacts of the
-  //passkey display.
+
+  //Clears passkey display after the prompt is done.
+  //Removes artifacts of the passkey display.
   if(passkeyTriggered && passkeyDismissed){
     passkeyTriggered = false;
     passkeyDismissed = false;
     updateStatus();
-    ms.display();
+    ms.invalidate();
+  }
+  //the prompts own the screen
+  if((passkeyTriggered && !passkeyDismissed) || oobPrompt){
+    events.stopTimer(TIMER_MARQUEE);
+    latency.cancel();
+    return;
   }
 
-  if(change){
-    updateStatus();
+  JoyWingInput::BusGuard bus(input);
+  //only what changed is redrawn, nothing if the event didn't change anything
+  if(ms.is_dirty()){
     ms.display();
-    digitalWrite(LED_BUILTIN,ledCtrl);
   }
-  
-
-  //This delay may need to be shortened
-  delay(100);
+  //long menu entry scrolling, takes as many steps as are due. The
+  //hardware scroll runs on its own, only the software one needs ticks
+  my_renderer.marquee.update();
+  //the press is on the panel now, logged if it redrew the menu
+  latency.commit();
+  if(my_renderer.marquee.isActive() && !my_renderer.marquee.isHardware()){
+    if(!events.isTimerActive(TIMER_MARQUEE)){
+      events.startTimer(TIMER_MARQUEE, MARQUEE_TICK_MS);
+    }
+  }
+  else{
+    events.stopTimer(TIMER_MARQUEE);
+  }
 }
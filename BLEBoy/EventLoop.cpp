@@ -0,0 +1,137 @@
+/*********************************************************************
+Event loop for the BLEBoy sketch.
+*********************************************************************/
+
+#include "EventLoop.h"
+
+EventLoop *EventLoop::_instance = NULL;
+
+EventLoop::EventLoop(void) {
+  _queue = NULL;
+  for (uint8_t i=0; i<EVENTLOOP_TIMERS; i++) {
+    _timers[i] = NULL;
+    _repeat[i] = false;
+  }
+  _dropped = 0;
+  _wakes = _lastMark = 0;
+  _idleUs = _activeUs = 0;
+}
+
+bool EventLoop::begin(void) {
+  _queue = xQueueCreate(EVENTLOOP_QUEUE_LEN, sizeof(LoopEvent));
+  if (!_queue) return false;
+  _instance = this;
+  resetStats();
+  return true;
+}
+
+bool EventLoop::post(uint8_t type, uint8_t a, uint16_t b, uint32_t at) {
+  LoopEvent ev = { type, a, b, micros(), at };
+  if (_queue && (xQueueSend(_queue, &ev, 0) == pdTRUE)) return true;
+  _dropped++;
+  return false;
+}
+
+bool EventLoop::postFromISR(uint8_t type, uint8_t a, uint16_t b, BaseType_t *woken) {
+  LoopEvent ev = { type, a, b, micros(), 0 };
+  if (_queue && (xQueueSendFromISR(_queue, &ev, woken) == pdTRUE)) return true;
+  _dropped++;
+  return false;
+}
+
+// time since the last mark was spent working
+void EventLoop::account(void) {
+  uint32_t now = micros();
+  _activeUs += now - _lastMark;
+  _lastMark = now;
+}
+
+bool EventLoop::wait(LoopEvent &ev, uint32_t timeoutMs) {
+  if (!_queue) return false;
+  account();
+  TickType_t ticks = (timeoutMs == EVENTLOOP_FOREVER) ? portMAX_DELAY : ms2tick(timeoutMs);
+  bool got = xQueueReceive(_queue, &ev, ticks) == pdTRUE;
+  uint32_t now = micros();
+  _idleUs += now - _lastMark;
+  _lastMark = now;
+  if (got) _wakes++;
+  return got;
+}
+
+void EventLoop::timerCallback(TimerHandle_t timer) {
+  uint8_t id = (uint8_t)(uintptr_t)pvTimerGetTimerID(timer);
+  _instance->post(EVENT_TIMER, id);
+}
+
+bool EventLoop::startTimer(uint8_t id, uint32_t periodMs, bool repeat) {
+  if (id >= EVENTLOOP_TIMERS) return false;
+  TickType_t ticks = ms2tick(periodMs);
+  if (!ticks) ticks = 1;
+  // auto reload is fixed at creation
+  if (_timers[id] && (_repeat[id] != repeat)) {
+    xTimerDelete(_timers[id], 0);
+    _timers[id] = NULL;
+  }
+  if (!_timers[id]) {
+    _timers[id] = xTimerCreate("loop", ticks, repeat ? pdTRUE : pdFALSE, (void *)(uintptr_t)id, timerCallback);
+    if (!_timers[id]) return false;
+    _repeat[id] = repeat;
+    return xTimerStart(_timers[id], 0) == pdPASS;
+  }
+  // starts a dormant timer too
+  return xTimerChangePeriod(_timers[id], ticks, 0) == pdPASS;
+}
+
+void EventLoop::stopTimer(uint8_t id) {
+  if ((id < EVENTLOOP_TIMERS) && _timers[id]) xTimerStop(_timers[id], 0);
+}
+
+bool EventLoop::isTimerActive(uint8_t id) const {
+  return (id < EVENTLOOP_TIMERS) && _timers[id] && (xTimerIsTimerActive(_timers[id]) != pdFALSE);
+}
+
+uint32_t EventLoop::getWakeCount(void) const {
+  return _wakes;
+}
+
+uint32_t EventLoop::getDropped(void) const {
+  return _dropped;
+}
+
+uint64_t EventLoop::getIdleMicros(void) const {
+  return _idleUs;
+}
+
+uint64_t EventLoop::getTotalMicros(void) const {
+  return _idleUs + _activeUs;
+}
+
+uint8_t EventLoop::getIdlePercent(void) const {
+  uint64_t total = getTotalMicros();
+  return total ? (uint8_t)(_idleUs * 100 / total) : 0;
+}
+
+uint32_t EventLoop::getAverageCurrent(void) const {
+  uint64_t total = getTotalMicros();
+  if (!total) return 0;
+  return (uint32_t)((_activeUs * EVENTLOOP_ACTIVE_UA + _idleUs * EVENTLOOP_IDLE_UA) / total);
+}
+
+void EventLoop::resetStats(void) {
+  _wakes = 0;
+  _dropped = 0;
+  _idleUs = _activeUs = 0;
+  _lastMark = micros();
+}
+
+void EventLoop::printStats(Print &p) const {
+  uint32_t ms = (uint32_t)(getTotalMicros() / 1000);
+  p.print("LOOP wakes=");
+  p.print(_wakes);
+  p.print(" per_s=");
+  p.print(ms ? (float)_wakes * 1000 / ms : 0.0f, 2);
+  p.print(" idle=");
+  p.print(getIdlePercent());
+  p.print("% avg_uA=");
+  p.println(getAverageCurrent());
+}
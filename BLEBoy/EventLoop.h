@@ -0,0 +1,98 @@
+/*********************************************************************
+Event loop for the BLEBoy sketch.
+
+loop() blocks on one FreeRTOS queue fed by the JoyWing input, the BLE
+callbacks and the loop's own timers, nothing runs on a fixed period.
+With tickless idle (configUSE_TICKLESS_IDLE in the core's
+FreeRTOSConfig.h) the MCU sleeps in System ON idle until the next event
+or timer.
+
+The statistics cover the loop task: a wake is one event taken off the
+queue, idle is the time wait() spent blocked.  Other tasks (BLE stack,
+seesaw bus task) running meanwhile count as idle, so the current
+estimate is a lower bound for the MCU alone: radio, OLED and JoyWing are
+not included.
+*********************************************************************/
+#ifndef _EVENT_LOOP_H_
+#define _EVENT_LOOP_H_
+
+#include <Arduino.h>
+
+#ifndef EVENTLOOP_QUEUE_LEN
+  #define EVENTLOOP_QUEUE_LEN 16
+#endif
+#define EVENTLOOP_TIMERS 4
+
+// current estimate, microamps: CPU running from flash (nRF52832, DC/DC)
+// and System ON idle with the RTC running and RAM retained
+#ifndef EVENTLOOP_ACTIVE_UA
+  #define EVENTLOOP_ACTIVE_UA 3700
+#endif
+#ifndef EVENTLOOP_IDLE_UA
+  #define EVENTLOOP_IDLE_UA 3
+#endif
+
+#define EVENTLOOP_FOREVER 0xFFFFFFFFUL
+
+// event types
+enum {
+  EVENT_INPUT,        // a = key, b = JoyWing event type
+  EVENT_CONNECT,
+  EVENT_DISCONNECT,   // a = reason
+  EVENT_TIMER,        // a = timer id
+  EVENT_REDRAW        // a modal screen is done, show the menu again
+};
+
+typedef struct {
+  uint8_t type;
+  uint8_t a;
+  uint16_t b;
+  uint32_t us;        // micros() when it was posted
+  uint32_t at;        // micros() the source saw it (input: IRQ edge), 0 if not known
+} LoopEvent;
+
+class EventLoop {
+ public:
+  EventLoop(void);
+
+  // false if out of memory
+  bool begin(void);
+
+  // from tasks and callbacks, false if the queue is full
+  bool post(uint8_t type, uint8_t a = 0, uint16_t b = 0, uint32_t at = 0);
+  bool postFromISR(uint8_t type, uint8_t a, uint16_t b, BaseType_t *woken);
+
+  // next event, blocks up to timeoutMs.  false if there was none
+  bool wait(LoopEvent &ev, uint32_t timeoutMs = EVENTLOOP_FOREVER);
+
+  // timer id (0..EVENTLOOP_TIMERS-1) posts EVENT_TIMER every periodMs,
+  // or once.  Starting a running timer changes its period.
+  bool startTimer(uint8_t id, uint32_t periodMs, bool repeat = true);
+  void stopTimer(uint8_t id);
+  bool isTimerActive(uint8_t id) const;
+
+  // statistics since begin() or resetStats()
+  uint32_t getWakeCount(void) const;
+  uint32_t getDropped(void) const;       // events lost, queue full
+  uint64_t getIdleMicros(void) const;
+  uint64_t getTotalMicros(void) const;
+  uint8_t getIdlePercent(void) const;
+  uint32_t getAverageCurrent(void) const; // microamps, see above
+  void resetStats(void);
+  // one line: wakes, wakes per second, idle %, average current
+  void printStats(Print &p) const;
+
+ private:
+  QueueHandle_t _queue;
+  TimerHandle_t _timers[EVENTLOOP_TIMERS];
+  bool _repeat[EVENTLOOP_TIMERS];
+  volatile uint32_t _dropped;
+  uint32_t _wakes, _lastMark;
+  uint64_t _idleUs, _activeUs;
+
+  static EventLoop *_instance;
+  static void timerCallback(TimerHandle_t timer);
+  void account(void);
+};
+
+#endif /* _EVENT_LOOP_H_ */
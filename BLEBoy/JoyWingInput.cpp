@@ -0,0 +1,228 @@
+/*********************************************************************
+Interrupt driven input for the Joy FeatherWing (seesaw).
+*********************************************************************/
+
+#include "JoyWingInput.h"
+
+// seesaw pin of each key's button
+static const uint8_t buttonPins[JOY_KEYS] = {
+  JOYWING_BUTTON_UP, JOYWING_BUTTON_DOWN, JOYWING_BUTTON_LEFT, JOYWING_BUTTON_RIGHT, JOYWING_BUTTON_SEL
+};
+#define JOYWING_BUTTON_MASK ((1UL << JOYWING_BUTTON_UP) | (1UL << JOYWING_BUTTON_DOWN) | \
+                             (1UL << JOYWING_BUTTON_LEFT) | (1UL << JOYWING_BUTTON_RIGHT) | \
+                             (1UL << JOYWING_BUTTON_SEL))
+
+JoyWingInput *JoyWingInput::_instance = NULL;
+
+JoyWingInput::JoyWingInput(Adafruit_seesaw &ss, uint8_t irqPin)
+  : _ss(ss), _buttonsT(buttonsDone, this), _joystickT(joystickDone, this) {
+  _irqPin = irqPin;
+  _joyMs = 20;
+  _idleJoyMs = 100;
+  _idleAfter = 2000;
+  _debounce = 20;
+  _repeatKeys = (1 << JOY_UP) | (1 << JOY_DOWN);
+  _repeatDelay = 400;
+  _repeatInterval = 120;
+  _longPress = 800;
+  _threshold = 150;
+  _timer = NULL;
+  _queue = NULL;
+  _bus = NULL;
+  _dropped = 0;
+  _cb = NULL;
+  _cbArg = NULL;
+  _activeAt = 0;
+  _buttonsAt = _joystickAt = 0;
+  _idle = false;
+  _raw = _stable = _longSent = _buttons = _joystick = 0;
+  for (uint8_t k=0; k<JOY_KEYS; k++) {
+    _changedAt[k] = _pressedAt[k] = _nextRepeat[k] = 0;
+  }
+}
+
+void JoyWingInput::setJoystickRate(uint16_t hz) {
+  _joyMs = hz ? 1000 / hz : 1000;
+  if (!_joyMs) _joyMs = 1;
+}
+
+void JoyWingInput::setIdleJoystickRate(uint16_t hz, uint16_t afterMs) {
+  _idleJoyMs = hz ? 1000 / hz : 1000;
+  if (_idleJoyMs < _joyMs) _idleJoyMs = _joyMs;
+  _idleAfter = afterMs;
+}
+
+void JoyWingInput::setDebounce(uint8_t ms) {
+  _debounce = ms;
+}
+
+void JoyWingInput::setRepeat(uint8_t keys, uint16_t delayMs, uint16_t intervalMs) {
+  _repeatKeys = keys;
+  _repeatDelay = delayMs;
+  _repeatInterval = intervalMs ? intervalMs : 1;
+}
+
+void JoyWingInput::setLongPress(uint16_t ms) {
+  _longPress = ms;
+}
+
+void JoyWingInput::setThreshold(uint16_t counts) {
+  _threshold = counts;
+}
+
+bool JoyWingInput::begin(void) {
+  _ss.pinModeBulk(JOYWING_BUTTON_MASK, INPUT_PULLUP);
+  _ss.setGPIOInterrupts(JOYWING_BUTTON_MASK, 1);
+  _ss.getGPIOInterruptFlag();
+  pinMode(_irqPin, INPUT);
+
+  _buttonsT.clear();
+  _buttonsT.read(SEESAW_GPIO_BASE, SEESAW_GPIO_INTFLAG, _flagBuf, 4);
+  _buttonsT.read(SEESAW_GPIO_BASE, SEESAW_GPIO_BULK, _pinBuf, 4);
+  _joystickT.clear();
+  _joystickT.read(SEESAW_ADC_BASE, SEESAW_ADC_CHANNEL_OFFSET, _axisBuf, 4);
+
+  _queue = xQueueCreate(JOYWING_QUEUE_LEN, sizeof(JoyWingEvent));
+  _bus = xSemaphoreCreateMutex();
+  _timer = xTimerCreate("joywing", ms2tick(_joyMs), pdTRUE, this, tick);
+  if (!_queue || !_bus || !_timer) return false;
+
+  _ss.setBusLock(_bus);
+  if (!_ss.beginBusTask()) return false;
+
+  _instance = this;
+  attachInterrupt(_irqPin, isr, FALLING);
+  return xTimerStart(_timer, 0) == pdPASS;
+}
+
+void JoyWingInput::setEventCallback(void (*cb)(const JoyWingEvent &ev, void *arg), void *arg) {
+  _cbArg = arg;
+  _cb = cb;
+}
+
+bool JoyWingInput::read(JoyWingEvent &ev, uint32_t timeoutMs) {
+  if (!_queue) return false;
+  TickType_t ticks = (timeoutMs == JOYWING_FOREVER) ? portMAX_DELAY : ms2tick(timeoutMs);
+  return xQueueReceive(_queue, &ev, ticks) == pdTRUE;
+}
+
+void JoyWingInput::unread(const JoyWingEvent &ev) {
+  if (_queue && (xQueueSendToFront(_queue, &ev, 0) != pdTRUE)) _dropped++;
+}
+
+uint32_t JoyWingInput::getDropped(void) const {
+  return _dropped;
+}
+
+void JoyWingInput::lockBus(void) {
+  if (_bus) xSemaphoreTake(_bus, portMAX_DELAY);
+}
+
+void JoyWingInput::unlockBus(void) {
+  if (_bus) xSemaphoreGive(_bus);
+}
+
+void JoyWingInput::isr(void) {
+  BaseType_t woken = pdFALSE;
+  if (!_instance->_buttonsT.isPending()) _instance->_buttonsAt = micros();
+  _instance->_ss.submitFromISR(_instance->_buttonsT, &woken);
+  portYIELD_FROM_ISR(woken);
+}
+
+// timer task: joystick sample, and the buttons while one is down (a
+// change ignored during the debounce time is picked up here) or the IRQ
+// line is still low (the edge came while the last read was pending).
+// Transactions still pending are skipped.
+void JoyWingInput::tick(TimerHandle_t timer) {
+  JoyWingInput *in = (JoyWingInput *)pvTimerGetTimerID(timer);
+  uint32_t now = micros();
+  if (!in->_joystickT.isPending()) {
+    in->_joystickAt = now;
+    in->_ss.submit(in->_joystickT);
+  }
+  if ((in->_buttons || (digitalRead(in->_irqPin) == LOW)) && !in->_buttonsT.isPending()) {
+    in->_buttonsAt = now;
+    in->_ss.submit(in->_buttonsT);
+  }
+}
+
+// bus task
+void JoyWingInput::buttonsDone(seesaw_Transaction &t, void *arg) {
+  JoyWingInput *in = (JoyWingInput *)arg;
+  if (!t.ok()) return;
+  uint32_t pins = ((uint32_t)in->_pinBuf[0] << 24) | ((uint32_t)in->_pinBuf[1] << 16) |
+                  ((uint32_t)in->_pinBuf[2] << 8) | in->_pinBuf[3];
+  in->_buttons = 0;
+  for (uint8_t k=0; k<JOY_KEYS; k++) {
+    if (!(pins & (1UL << buttonPins[k]))) in->_buttons |= 1 << k;
+  }
+  uint32_t now = millis();
+  in->step(now, in->_buttonsAt);
+  in->pace(now);
+}
+
+// bus task, also runs the repeat/long press timing
+void JoyWingInput::joystickDone(seesaw_Transaction &t, void *arg) {
+  JoyWingInput *in = (JoyWingInput *)arg;
+  if (t.ok()) {
+    // x on ADC channel 0 (up is low), y on channel 1 (right is high)
+    int16_t dx = (int16_t)(((uint16_t)in->_axisBuf[0] << 8) | in->_axisBuf[1]) - 512;
+    int16_t dy = (int16_t)(((uint16_t)in->_axisBuf[2] << 8) | in->_axisBuf[3]) - 512;
+    in->_joystick = 0;
+    if (abs(dy) > abs(dx)) {
+      if (abs(dy) >= in->_threshold) in->_joystick = 1 << ((dy > 0) ? JOY_RIGHT : JOY_LEFT);
+    } else if (abs(dx) >= in->_threshold) {
+      in->_joystick = 1 << ((dx < 0) ? JOY_UP : JOY_DOWN);
+    }
+  }
+  uint32_t now = millis();
+  in->step(now, in->_joystickAt);
+  in->pace(now);
+}
+
+// fewer wakeups while nothing is touched, full rate again on a key
+void JoyWingInput::pace(uint32_t now) {
+  if (_raw | _stable) _activeAt = now;
+  bool idle = (now - _activeAt) >= _idleAfter;
+  if (idle != _idle) {
+    _idle = idle;
+    xTimerChangePeriod(_timer, ms2tick(idle ? _idleJoyMs : _joyMs), 0);
+  }
+}
+
+// A change is taken at once and the key then ignores further changes for
+// the debounce time, so debouncing adds no latency to a press.
+void JoyWingInput::step(uint32_t now, uint32_t at) {
+  _raw = _buttons | _joystick;
+  for (uint8_t k=0; k<JOY_KEYS; k++) {
+    uint8_t bit = 1 << k;
+    if ((_raw ^ _stable) & bit) {
+      if (now - _changedAt[k] < _debounce) continue;
+      _changedAt[k] = now;
+      _stable ^= bit;
+      if (_stable & bit) {
+        _pressedAt[k] = now;
+        _nextRepeat[k] = now + _repeatDelay;
+        _longSent &= ~bit;
+        post(k, JOY_PRESS, at);
+      } else {
+        post(k, JOY_RELEASE, at);
+      }
+    } else if (_stable & bit) {
+      if (_longPress && !(_longSent & bit) && (now - _pressedAt[k] >= _longPress)) {
+        _longSent |= bit;
+        post(k, JOY_LONG_PRESS, at);
+      }
+      if ((_repeatKeys & bit) && ((int32_t)(now - _nextRepeat[k]) >= 0)) {
+        _nextRepeat[k] = now + _repeatInterval;
+        post(k, JOY_REPEAT, at);
+      }
+    }
+  }
+}
+
+void JoyWingInput::post(uint8_t key, uint8_t type, uint32_t at) {
+  JoyWingEvent ev = { key, type, micros(), at };
+  if (_cb) _cb(ev, _cbArg);
+  else if (xQueueSend(_queue, &ev, 0) != pdTRUE) _dropped++;
+}
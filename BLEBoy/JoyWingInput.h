@@ -0,0 +1,132 @@
+/*********************************************************************
+Interrupt driven input for the Joy FeatherWing (seesaw).
+
+The seesaw IRQ line and a FreeRTOS timer submit register transactions
+to the seesaw bus task: the buttons are read only when they changed or
+are held, both joystick axes in one read at a fixed rate (the ADC has no
+interrupt), lower while nothing is touched.  The completion callbacks run buttons and joystick
+directions through the same debounce state machine, events come out of
+a queue as press/repeat/long press/release.
+
+The seesaw shares the I2C bus with the OLED and holds it only per
+transfer: everything else using the bus while the bus task runs has to
+hold it too (BusGuard).
+*********************************************************************/
+#ifndef _JOYWING_INPUT_H_
+#define _JOYWING_INPUT_H_
+
+#include <Arduino.h>
+#include <Adafruit_seesaw.h>
+
+// seesaw pins of the JoyWing buttons
+#define JOYWING_BUTTON_RIGHT 6
+#define JOYWING_BUTTON_DOWN  7
+#define JOYWING_BUTTON_LEFT  9
+#define JOYWING_BUTTON_UP    10
+#define JOYWING_BUTTON_SEL   14
+
+#ifndef JOYWING_QUEUE_LEN
+  #define JOYWING_QUEUE_LEN 16
+#endif
+
+#define JOYWING_FOREVER 0xFFFFFFFFUL
+
+// keys, buttons and joystick directions alike
+enum {
+  JOY_UP,
+  JOY_DOWN,
+  JOY_LEFT,
+  JOY_RIGHT,
+  JOY_SELECT,
+  JOY_KEYS
+};
+
+// event types
+enum {
+  JOY_PRESS,
+  JOY_REPEAT,         // key held, up to the key's repeat settings
+  JOY_LONG_PRESS,     // key held for the long press time, once per press
+  JOY_RELEASE
+};
+
+typedef struct {
+  uint8_t key;
+  uint8_t type;
+  uint32_t us;        // micros() when the (debounced) change was seen
+  uint32_t at;        // micros() of the IRQ edge or joystick sample that led to it
+} JoyWingEvent;
+
+class JoyWingInput {
+ public:
+  JoyWingInput(Adafruit_seesaw &ss, uint8_t irqPin);
+
+  // settings, before begin()
+  void setJoystickRate(uint16_t hz);                        // default 50
+  void setIdleJoystickRate(uint16_t hz, uint16_t afterMs);  // after afterMs without a key down, default 10, 2000
+  void setDebounce(uint8_t ms);                             // default 20
+  void setRepeat(uint8_t keys, uint16_t delayMs, uint16_t intervalMs); // bitmask of 1 << JOY_*, default up/down, 400, 120
+  void setLongPress(uint16_t ms);                           // default 800, 0 for none
+  void setThreshold(uint16_t counts);                       // joystick deflection from center, default 150
+
+  // sets the JoyWing pins up and starts the seesaw bus task and the sample
+  // timer, false if out of memory
+  bool begin(void);
+
+  // events go to cb (called in the seesaw bus task) instead of the queue
+  void setEventCallback(void (*cb)(const JoyWingEvent &ev, void *arg), void *arg = NULL);
+
+  // next event, waits up to timeoutMs.  false if there was none
+  bool read(JoyWingEvent &ev, uint32_t timeoutMs = JOYWING_FOREVER);
+  // puts an event back to be read first
+  void unread(const JoyWingEvent &ev);
+  // events lost because the queue was full
+  uint32_t getDropped(void) const;
+
+  void lockBus(void);
+  void unlockBus(void);
+
+  // holds the bus for its lifetime
+  class BusGuard {
+   public:
+    BusGuard(JoyWingInput &in) : _in(in) { _in.lockBus(); }
+    ~BusGuard() { _in.unlockBus(); }
+   private:
+    JoyWingInput &_in;
+  };
+
+ private:
+  Adafruit_seesaw &_ss;
+  uint8_t _irqPin;
+  uint16_t _joyMs, _idleJoyMs, _idleAfter, _repeatDelay, _repeatInterval, _longPress, _threshold;
+  uint8_t _debounce, _repeatKeys;
+
+  TimerHandle_t _timer;
+  QueueHandle_t _queue;
+  SemaphoreHandle_t _bus;
+  volatile uint32_t _dropped;
+  void (*_cb)(const JoyWingEvent &ev, void *arg);
+  void *_cbArg;
+
+  // buttons: interrupt flags (reading them releases the IRQ line) and pins,
+  // joystick: both ADC channels
+  seesaw_Transaction _buttonsT, _joystickT;
+  uint8_t _flagBuf[4], _pinBuf[4], _axisBuf[4];
+  volatile uint32_t _buttonsAt, _joystickAt;  // when they were submitted
+
+  // debounce state per key, only touched by the bus task
+  uint8_t _raw, _stable, _longSent, _buttons, _joystick;
+  uint32_t _changedAt[JOY_KEYS], _pressedAt[JOY_KEYS], _nextRepeat[JOY_KEYS];
+  uint32_t _activeAt;   // last time a key was down
+  bool _idle;           // sampling at the idle rate
+
+  static JoyWingInput *_instance;
+  static void isr(void);
+  static void tick(TimerHandle_t timer);
+  static void buttonsDone(seesaw_Transaction &t, void *arg);
+  static void joystickDone(seesaw_Transaction &t, void *arg);
+  void step(uint32_t now, uint32_t at);
+  void pace(uint32_t now);
+  void post(uint8_t key, uint8_t type, uint32_t at);
+};
+
+#endif /* _JOYWING_INPUT_H_ */
@@ -0,0 +1,113 @@
+/*********************************************************************
+Input-to-pixel latency log for the BLEBoy sketch.
+*********************************************************************/
+
+#include "LatencyLog.h"
+
+static const char *const stageNames[LAT_STAGES + 1] = {
+  "read", "queue", "action", "draw", "push", "total"
+};
+
+LatencyLog::LatencyLog(void) {
+  _open = false;
+  _marked = 0;
+  clear();
+}
+
+void LatencyLog::begin(uint32_t irqUs, uint32_t readUs) {
+  _t[LAT_IRQ] = irqUs;
+  _t[LAT_READ] = readUs;
+  _t[LAT_DISPATCH] = micros();
+  _marked = (1 << LAT_IRQ) | (1 << LAT_READ) | (1 << LAT_DISPATCH);
+  _open = true;
+}
+
+void LatencyLog::mark(uint8_t point) {
+  if (!_open || (point >= LAT_POINTS)) return;
+  _t[point] = micros();
+  _marked |= 1 << point;
+}
+
+void LatencyLog::commit(void) {
+  if (!_open) return;
+  mark(LAT_PIXELS);
+  _open = false;
+  // nothing was drawn for it
+  if (_marked != (1 << LAT_POINTS) - 1) return;
+
+  Entry &e = _log[_head];
+  for (uint8_t s=0; s<LAT_STAGES; s++) {
+    int32_t d = (int32_t)(_t[s + 1] - _t[s]);
+    e.us[s] = (d < 0) ? 0 : (d > 0xFFFF) ? 0xFFFF : d;
+  }
+  _head = (_head + 1) % LATENCY_LOG_LEN;
+  if (_count < LATENCY_LOG_LEN) _count++;
+  _total++;
+}
+
+void LatencyLog::cancel(void) {
+  _open = false;
+}
+
+bool LatencyLog::isOpen(void) const {
+  return _open;
+}
+
+uint16_t LatencyLog::count(void) const {
+  return _count;
+}
+
+uint32_t LatencyLog::total(void) const {
+  return _total;
+}
+
+void LatencyLog::clear(void) {
+  _head = _count = 0;
+  _total = 0;
+}
+
+uint32_t LatencyLog::value(uint16_t i, uint8_t stage) const {
+  if (stage < LAT_STAGES) return _log[i].us[stage];
+  uint32_t sum = 0;
+  for (uint8_t s=0; s<LAT_STAGES; s++) sum += _log[i].us[s];
+  return sum;
+}
+
+uint32_t LatencyLog::percentile(uint8_t stage, uint8_t pct) const {
+  if (!_count || (stage > LAT_TOTAL)) return 0;
+
+  // insertion sort of a copy, the log is small
+  uint32_t v[LATENCY_LOG_LEN];
+  for (uint16_t i=0; i<_count; i++) {
+    uint32_t x = value(i, stage);
+    uint16_t j = i;
+    for (; j && (v[j - 1] > x); j--) v[j] = v[j - 1];
+    v[j] = x;
+  }
+  if (pct > 100) pct = 100;
+  uint16_t rank = ((uint32_t)pct * _count + 99) / 100;
+  return v[rank ? rank - 1 : 0];
+}
+
+const char *LatencyLog::stageName(uint8_t stage) {
+  return (stage <= LAT_TOTAL) ? stageNames[stage] : "";
+}
+
+void LatencyLog::printReport(Print &p) const {
+  p.print("LAT n=");
+  p.print(_count);
+  p.print(" of ");
+  p.println(_total);
+  for (uint8_t s=0; s<=LAT_TOTAL; s++) {
+    p.print("LAT ");
+    p.print(stageNames[s]);
+    p.print(" p50=");
+    p.print(percentile(s, 50));
+    p.print(" p90=");
+    p.print(percentile(s, 90));
+    p.print(" p99=");
+    p.print(percentile(s, 99));
+    p.print(" max=");
+    p.println(percentile(s, 100));
+  }
+}
@@ -0,0 +1,85 @@
+/*********************************************************************
+Input-to-pixel latency log for the BLEBoy sketch.
+
+A trace follows one key press (or repeat) from the JoyWing to the OLED
+through timestamped probe points:
+
+  IRQ       seesaw IRQ edge, or the joystick sample tick
+  READ      seesaw read decoded, event posted (seesaw bus task)
+  DISPATCH  loop() took the event off its queue
+  ACTION    MenuSystem navigation and the item's callback returned
+  DRAW      the renderer composed the frame
+  PIXELS    the last display push returned
+
+Only one trace is open at a time, events that don't redraw the menu are
+dropped.  Finished traces go into a ring of LATENCY_LOG_LEN entries, one
+16 bit microsecond duration per stage (saturating at 65535), and the
+report gives percentiles per stage and of the total.
+*********************************************************************/
+#ifndef _LATENCY_LOG_H_
+#define _LATENCY_LOG_H_
+
+#include <Arduino.h>
+
+#ifndef LATENCY_LOG_LEN
+  #define LATENCY_LOG_LEN 64
+#endif
+
+// probe points
+enum {
+  LAT_IRQ,
+  LAT_READ,
+  LAT_DISPATCH,
+  LAT_ACTION,
+  LAT_DRAW,
+  LAT_PIXELS,
+  LAT_POINTS
+};
+
+// stages are the intervals between consecutive points, stage s ends at
+// point s + 1.  LAT_TOTAL is IRQ to PIXELS.
+#define LAT_STAGES (LAT_POINTS - 1)
+#define LAT_TOTAL  LAT_STAGES
+
+class LatencyLog {
+ public:
+  LatencyLog(void);
+
+  // opens a trace for an event from the JoyWing: irqUs and readUs come
+  // with the event, DISPATCH is now.  Replaces a trace still open.
+  void begin(uint32_t irqUs, uint32_t readUs);
+  // stamps a point of the open trace with now, no-op without one
+  void mark(uint8_t point);
+  // stamps PIXELS and logs the trace if it was drawn, drops it otherwise
+  void commit(void);
+  void cancel(void);
+  bool isOpen(void) const;
+
+  uint16_t count(void) const;     // traces in the log
+  uint32_t total(void) const;     // traces logged since clear()
+  void clear(void);
+
+  // pct percentile (nearest rank) of a stage or LAT_TOTAL in microseconds,
+  // 0 if the log is empty
+  uint32_t percentile(uint8_t stage, uint8_t pct) const;
+  static const char *stageName(uint8_t stage);
+
+  // LAT <stage> p50=.. p90=.. p99=.. max=.. per stage and total
+  void printReport(Print &p) const;
+
+ private:
+  typedef struct {
+    uint16_t us[LAT_STAGES];
+  } Entry;
+
+  Entry _log[LATENCY_LOG_LEN];
+  uint16_t _head, _count;
+  uint32_t _total;
+  uint32_t _t[LAT_POINTS];
+  uint8_t _marked;  // bit per point of the open trace
+  bool _open;
+
+  uint32_t value(uint16_t i, uint8_t stage) const;
+};
+
+#endif /* _LATENCY_LOG_H_ */
@@ -0,0 +1,142 @@
+/*********************************************************************
+Menus of the BLEBoy sketch and the renderer that draws them.
+*********************************************************************/
+
+#include "MenuScreens.h"
+
+CustomRenderer my_renderer;
+MenuSystem ms(my_renderer);
+Menu mm("Main Menu");
+
+//the settings keep their value in the item, toggling them uses no heap
+BoolMenuItem muLed("LED",&setLed,false);
+BoolMenuItem muAdv("Advertising",&setAdv,false);
+
+MenuItem mu_terminate("Terminate Connections",&terminateConnections);
+
+Menu muStatus("Status");
+//TODO need to do an update check each loop and update these config values (for status)
+ConfigMenuItem muStatus_miAddr("00:00:00:00:00:00", "Addr", &setStatus);
+ConfigMenuItem muStatus_miConn("False", "Connected", &setStatus);
+ConfigMenuItem muStatus_miLesc("False", "LESC", &setStatus);
+ConfigMenuItem muStatus_miAM("None", "Asc.Model", &setStatus);
+ConfigMenuItem muStatus_miBond("False", "Bonded", &setStatus);
+ConfigMenuItem muStatus_miSecMode("None", "SecMode", &setStatus);
+ConfigMenuItem muStatus_miSecLevel("None", "SecLevel", &setStatus);
+
+//p50/p95 of one latency stage, worked out when the row is drawn
+class LatencyMenuItem : public ValueMenuItem {
+public:
+    LatencyMenuItem(const char* name, uint8_t stage, SelectFnPtr select_fn)
+    : ValueMenuItem(name, select_fn), stage(stage) {}
+    uint8_t format_value(char* buffer, uint8_t size) const {
+      if(!latency.count()){
+        return copy_value(buffer, size, "-");
+      }
+      return snprintf(buffer, size, "%lu/%lu", (unsigned long)latency.percentile(stage, 50),
+                      (unsigned long)latency.percentile(stage, 95));
+    }
+protected:
+    Menu* select() {
+      set_dirty();
+      return MenuItem::select();
+    }
+private:
+    uint8_t stage;
+};
+Menu muLatency("Latency p50/p95 us");
+LatencyMenuItem muLatency_miTotal("Total", LAT_TOTAL, &printLatency);
+LatencyMenuItem muLatency_miRead("Read", LAT_IRQ, &printLatency);
+LatencyMenuItem muLatency_miQueue("Queue", LAT_READ, &printLatency);
+LatencyMenuItem muLatency_miAction("Action", LAT_DISPATCH, &printLatency);
+LatencyMenuItem muLatency_miDraw("Draw", LAT_ACTION, &printLatency);
+LatencyMenuItem muLatency_miPush("Push", LAT_DRAW, &printLatency);
+
+
+Menu muSettings("Settings");
+//in the order of the BLE_GAP_IO_CAPS_* values
+const char* const ioLabels[] = {"DisplayOnly","DisplayYesNo","KeyboardOnly","NoInputNoOutput","KeyboardDisplay"};
+BoolMenuItem muSettings_miBond("Bonding",&setBonding,bond,"0","1");
+BoolMenuItem muSettings_miLesc("LESC",&setLesc,lesc,"0","1");
+BoolMenuItem muSettings_miMitm("MitM",&setMitm,mitm,"0","1");
+BoolMenuItem muSettings_miKeypress("Keypress",&setKeypress,keypress,"0","1");
+EnumMenuItem muSettings_miIO("IO",&setIO,ioLabels,5,io);
+BoolMenuItem muSettings_miOOB("OOB",&setOOB,oob,"0","1");
+MenuItem muSettings_miClearBonds("Clear Bonds",&clearBonds);
+MenuItem mu_genoob("GenOOBData",&genOOBData);
+
+void setupMenus(){
+  ms.get_root_menu().add_menu(&mm);
+
+  mm.add_item(&muLed);
+  mm.add_item(&muAdv);
+  mm.add_item(&mu_terminate);
+  mm.add_item(&mu_genoob);
+  mm.add_menu(&muStatus);
+  muStatus.add_item(&muStatus_miAddr);
+  muStatus.add_item(&muStatus_miConn);
+  //muStatus.add_item(&muStatus_miLesc);
+  //muStatus.add_item(&muStatus_miAM);
+  muStatus.add_item(&muStatus_miBond);
+  muStatus.add_item(&muStatus_miSecMode);
+  muStatus.add_item(&muStatus_miSecLevel);
+  muStatus.add_menu(&muLatency);
+  muLatency.add_item(&muLatency_miTotal);
+  muLatency.add_item(&muLatency_miRead);
+  muLatency.add_item(&muLatency_miQueue);
+  muLatency.add_item(&muLatency_miAction);
+  muLatency.add_item(&muLatency_miDraw);
+  muLatency.add_item(&muLatency_miPush);
+  mm.add_menu(&muSettings);
+  muSettings.add_item(&muSettings_miBond);
+  muSettings.add_item(&muSettings_miLesc);
+  muSettings.add_item(&muSettings_miMitm);
+  muSettings.add_item(&muSettings_miKeypress);
+  muSettings.add_item(&muSettings_miIO);
+  muSettings.add_item(&muSettings_miOOB);
+  muSettings.add_item(&muSettings_miClearBonds);
+}
+
+const char* const checkScreenNames[CHECK_SCREENS] = {"root", "main", "status", "settings"};
+
+static Menu const& checkScreenMenu(uint8_t i){
+  switch(i){
+    case 0: return ms.get_root_menu();
+    case 1: return mm;
+    case 2: return muStatus;
+    default: return muSettings;
+  }
+}
+
+void beginRenderCheck(SSD1306_Canvas& canvas){
+  canvas.setTextSize(textScale);
+  canvas.setTextColor(WHITE);
+  canvas.enableTextCache();
+  my_renderer.target = &canvas;
+  //the board's own address would make the status screen differ per board
+  muStatus_miAddr.set_value("00:00:00:00:00:00");
+}
+
+void renderCheckScreen(SSD1306_Canvas& canvas, uint8_t i, Print& out){
+  uint32_t bytes = canvas.getBusBytes();
+  canvas.resetCounters();
+  uint32_t start = micros();
+  my_renderer.render(checkScreenMenu(i));
+  uint32_t us = micros() - start;
+  canvas.waitFlush();
+
+  SSD1306_Canvas::Counters const& c = canvas.getCounters();
+  out.print("SCREEN "); out.print(checkScreenNames[i]);
+  out.print(" "); out.print(us);
+  out.print(" "); out.print(c.pixels);
+  out.print(" "); out.print(c.columns);
+  out.print(" "); out.print(c.hLines + c.vLines);
+  out.print(" "); out.println(canvas.getBusBytes() - bytes);
+}
+
+void endRenderCheck(){
+  muStatus_miAddr.set_value(addrString);
+  my_renderer.marquee.end();
+  my_renderer.target = &display;
+  ms.invalidate();
+}
@@ -0,0 +1,238 @@
+/*********************************************************************
+Menus of the BLEBoy sketch and the renderer that draws them.
+
+The menu tree, its renderer and the render check are kept out of
+BLEBoy.ino so they build without the BLE stack: the sketch runs the
+render check on the board (RENDER_CHECK), Scripts/host builds the same
+code on a PC.  Both compare against the golden images in Scripts/screens.
+The select handlers and the settings the items start from belong to the
+sketch.
+*********************************************************************/
+#ifndef _MENU_SCREENS_H_
+#define _MENU_SCREENS_H_
+
+#include <Arduino.h>
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1306.h>
+#include <SSD1306_Marquee.h>
+#include <SSD1306_Canvas.h>
+#include <MenuSystem.h>
+#include "LatencyLog.h"
+
+#define textScale 1
+
+// provided by the sketch
+extern Adafruit_SSD1306 display;
+extern LatencyLog latency;
+extern int oob;
+extern int bond;
+extern int mitm;
+extern int lesc;
+extern int keypress;
+extern int io;
+extern char* addrString;
+
+// menu events, in the sketch
+void setBonding(MenuComponent* p_menu_component);
+void setLed(MenuComponent* p_menu_component);
+void setAdv(MenuComponent* p_menu_component);
+void terminateConnections(MenuComponent* p_menu_component);
+void setStatus(MenuComponent* p_menu_component);
+void setLesc(MenuComponent* p_menu_component);
+void setKeypress(MenuComponent* p_menu_component);
+void setIO(MenuComponent* p_menu_component);
+void setOOB(MenuComponent* p_menu_component);
+void setMitm(MenuComponent* p_menu_component);
+void clearBonds(MenuComponent* p_menu_component);
+void genOOBData(MenuComponent* p_menu_component);
+void printLatency(MenuComponent* p_menu_component);
+
+//collects printed text, menu lines are measured before they are drawn
+class LinePrint : public Print {
+public:
+    char buf[48];
+    uint8_t n = 0;
+    void clear(){ n = 0; buf[0] = '\0'; }
+    size_t write(uint8_t c){
+      if (n < sizeof(buf) - 1){ buf[n++] = c; buf[n] = '\0'; }
+      return 1;
+    }
+};
+
+class CustomRenderer : public MenuComponentRenderer {
+public:
+    const int MAX_VIEWABLE = 2; // number of items that can be viewed at once
+    //items don't wrap, the current one scrolls if it is too long
+    Adafruit_SSD1306* target = &display; //where the menus are drawn, see RENDER_CHECK
+    mutable SSD1306_Marquee marquee; //scrolls the current item if it is too long, update() from loop()
+    mutable LinePrint line;
+    mutable Print* out = &display; //where the items print themselves
+    bool incremental = true; //false redraws the whole menu on every render
+
+    //what is on screen: menu, its first visible item and where the items start
+    mutable Menu const* shown = nullptr;
+    mutable int shownFirst = 0;
+    mutable int16_t rowsTop = 0;
+    mutable int16_t marqueeY = -1;
+
+    void render(Menu const& menu) const {
+      //the page of MAX_VIEWABLE items the current one is on
+      int first = menu.get_current_component_num() / MAX_VIEWABLE * MAX_VIEWABLE;
+      int last = min(first + MAX_VIEWABLE, (int)menu.get_num_components());
+      //the menu is composed in RAM and pushed to the OLED once, only the
+      //parts drawn are sent
+      target->beginFrame();
+      if (!incremental || &menu != shown || first != shownFirst || menu.is_dirty()){
+        marquee.end();
+        target->clearDisplay();
+        target->setCursor(0,0);
+        //target->print("\nCurrent menu name: ");
+        if(strlen(menu.get_name()) != 0){
+          target->print(menu.get_name());
+          target->println(":");
+        }
+        else{
+          //laid out once, then served from the text cache
+          target->printWrapped("BLEBoy", 0, target->getCursorY(), 0, GFX_ALIGN_CENTER);
+          target->printWrapped("Press [select] to go to the menu", 0, target->getCursorY());
+        }
+        rowsTop = target->getCursorY();
+        for (int i = first; i < last; ++i){
+          render_row(menu.get_menu_component(i), rowsTop + (i - first) * 8 * textScale);
+        }
+        shown = &menu;
+        shownFirst = first;
+      }
+      else if (menu.has_dirty_components()){
+        //same page as before: only the items that changed
+        for (int i = first; i < last; ++i){
+          MenuComponent const* cp_m_comp = menu.get_menu_component(i);
+          if (cp_m_comp->is_dirty()){
+            render_row(cp_m_comp, rowsTop + (i - first) * 8 * textScale);
+          }
+        }
+      }
+      menu.clear_dirty();
+      latency.mark(LAT_DRAW);
+      target->endFrame();
+    }
+
+    //draws one item over its row at y
+    void render_row(MenuComponent const* cp_m_comp, int16_t y) const {
+      if (marquee.isActive() && y == marqueeY){
+        marquee.end();
+      }
+      target->fillRect(0, y, target->width(), 8 * textScale, BLACK);
+      target->setCursor(0, y);
+      if (cp_m_comp->is_current()){
+          target->print(">");
+      }
+      target->print(" ");
+      //collect the item's text first to see whether it fits
+      line.clear();
+      out = &line;
+      cp_m_comp->render(*this);
+      out = target;
+      int16_t x1, y1;
+      uint16_t w, h;
+      int16_t room = target->width() - target->getCursorX();
+      target->getTextBounds(line.buf, 0, 0, &x1, &y1, &w, &h);
+      if (cp_m_comp->is_current() && w > room){
+        //scrolled in software next to the cursor: the controller's scroll
+        //only rotates the 128 columns already in panel RAM, text wider
+        //than the panel can't go through it even as a full width row
+        marquee.begin(*target, line.buf, target->getCursorX(), y, room);
+        marqueeY = y;
+      }
+      else{
+        //the others are cut off at the edge instead of wrapping
+        target->setTextWrap(false);
+        target->print(line.buf);
+        target->setTextWrap(true);
+      }
+    }
+
+    void render_menu_item(MenuItem const& menu_item) const {
+        
+        out->print(menu_item.get_name());
+    }
+
+    void render_config_menu_item(ConfigMenuItem const& menu_item) const {
+        
+        out->print(menu_item.get_name());
+        out->print(":");
+        out->print(menu_item.get_value());
+    }
+
+    void render_back_menu_item(BackMenuItem const& menu_item) const {
+        out->print(menu_item.get_name());
+    }
+
+    void render_value_menu_item(ValueMenuItem const& menu_item) const {
+        char value[16];
+        menu_item.format_value(value, sizeof(value));
+        out->print(menu_item.get_name());
+        out->print(menu_item.has_focus() ? "<" : ":");
+        out->print(value);
+        if (menu_item.has_focus())
+            out->print(">");
+    }
+
+    void render_numeric_menu_item(NumericMenuItem const& menu_item) const {
+      String buffer;
+
+      buffer = menu_item.get_name();
+      buffer += menu_item.has_focus() ? '<' : '=';
+      buffer += menu_item.get_formatted_value();
+  
+      if (menu_item.has_focus())
+          buffer += '>';
+  
+      out->print(buffer);
+    }
+
+
+    void render_menu(Menu const& menu) const {
+        out->print(menu.get_name());
+    }
+};
+
+
+// Menu variables
+extern CustomRenderer my_renderer;
+extern MenuSystem ms;
+extern Menu mm;
+extern BoolMenuItem muLed;
+extern BoolMenuItem muAdv;
+extern Menu muStatus;
+extern ConfigMenuItem muStatus_miAddr;
+extern ConfigMenuItem muStatus_miConn;
+extern ConfigMenuItem muStatus_miBond;
+extern ConfigMenuItem muStatus_miSecMode;
+extern ConfigMenuItem muStatus_miSecLevel;
+extern Menu muLatency;
+extern Menu muSettings;
+extern BoolMenuItem muSettings_miBond;
+extern BoolMenuItem muSettings_miLesc;
+extern BoolMenuItem muSettings_miMitm;
+extern BoolMenuItem muSettings_miKeypress;
+extern EnumMenuItem muSettings_miIO;
+extern BoolMenuItem muSettings_miOOB;
+
+//builds the menu tree, before the first ms.display()
+void setupMenus();
+
+//Render check: the screens with golden images, drawn into an off-screen
+//canvas instead of the display
+#define CHECK_SCREENS 4
+extern const char* const checkScreenNames[CHECK_SCREENS];
+//points the renderer at the canvas, the status screen shows a placeholder
+//address instead of the board's
+void beginRenderCheck(SSD1306_Canvas& canvas);
+//renders screen i into the canvas and prints
+//  SCREEN <name> <render us> <pixels> <glyph columns> <lines> <bus bytes>
+void renderCheckScreen(SSD1306_Canvas& canvas, uint8_t i, Print& out);
+//back to the display, the next ms.display() redraws everything
+void endRenderCheck();
+
+#endif
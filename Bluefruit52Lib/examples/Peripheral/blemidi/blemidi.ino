@@ -64,6 +64,10 @@ void setup()
   // Do the same for MIDI Note Off messages.
   MIDI.setHandleNoteOff(handleNoteOff);
 
+  // Call the handlers at the sender's timing, 20 ms behind it, instead of
+  // in bursts once per connection interval
+  blemidi.setPlayoutLatency(20);
+
   // Set General Discoverable Mode flag
   Bluefruit.Advertising.addFlags(BLE_GAP_ADV_FLAGS_LE_ONLY_GENERAL_DISC_MODE);
 
@@ -129,6 +133,14 @@ void loop()
   // Increment position
   position++;
 
+  // Both messages above go out in one packet, print how well that
+  // and the playout of received notes worked once per pass through
+  // the sequence
+  if (position == 1) {
+    blemidi.printTxStats(Serial);
+    blemidi.printRxStats(Serial);
+  }
+
   // If we are at the end of the sequence, start over.
   if (position >= sizeof(note_sequence)) {
     position = 0;
@@ -0,0 +1,251 @@
+/*********************************************************************
+ This is an example for our nRF52 based Bluefruit LE modules
+
+ Pick one up today in the adafruit shop!
+
+ Adafruit invests time and resources providing this open source code,
+ please support Adafruit and open-source hardware by purchasing
+ products from Adafruit!
+
+ MIT license, check LICENSE for more information
+ All text above, and the splash screen below must be included in
+ any redistribution
+*********************************************************************/
+
+/* Checks and benchmarks the BLE MIDI packet decoder used by BLEMidi,
+ * no connection needed:
+ *  - a corpus of packets covering timestamps, running status, real-time
+ *    and SysEx across packets, each with the events it must produce
+ *  - random packets and mutations of the corpus, every event must still
+ *    be a well formed MIDI message
+ *  - decoding throughput for typical aggregated packets
+ */
+
+#include <bluefruit.h>
+
+#define SYSEX_SIZE      16
+#define FUZZ_ROUNDS     20000
+#define BENCH_ROUNDS    2000
+
+typedef struct
+{
+  const char* name;
+  bool        cont;         // continues the previous packet's state
+  uint8_t     len;
+  uint8_t     packet[20];
+  uint8_t     expect_len;   // events concatenated
+  uint8_t     expect[20];
+  uint16_t    last_ts;      // timestamp of the last event
+} corpus_t;
+
+const corpus_t corpus[] =
+{
+  { "note on"          , false, 5, { 0x80, 0x80, 0x90, 60, 100 }, 3, { 0x90, 60, 100 }, 0 },
+  { "timestamp"        , false, 5, { 0x87, 0xE8, 0x90, 60, 100 }, 3, { 0x90, 60, 100 }, 1000 },
+  { "two messages"     , false, 9, { 0x80, 0x81, 0x90, 60, 100, 0x82, 0x80, 60, 0 }, 6, { 0x90, 60, 100, 0x80, 60, 0 }, 2 },
+  { "running, stamped" , false, 8, { 0x80, 0x81, 0x90, 60, 100, 0x82, 61, 100 }, 6, { 0x90, 60, 100, 0x90, 61, 100 }, 2 },
+  { "running"          , false, 9, { 0x80, 0x81, 0x90, 60, 100, 61, 100, 62, 100 }, 9, { 0x90, 60, 100, 0x90, 61, 100, 0x90, 62, 100 }, 1 },
+  { "running 2 byte"   , false, 6, { 0x80, 0x81, 0xC0, 5, 6, 7 }, 6, { 0xC0, 5, 0xC0, 6, 0xC0, 7 }, 1 },
+  { "timestamp wrap"   , false, 7, { 0x80, 0xFF, 0xF8, 0x81, 0x90, 60, 100 }, 4, { 0xF8, 0x90, 60, 100 }, 129 },
+  { "real-time between", false,10, { 0x80, 0x81, 0xB0, 1, 5, 0x81, 0xF8, 0x82, 1, 6 }, 7, { 0xB0, 1, 5, 0xF8, 0xB0, 1, 6 }, 2 },
+  { "common cancels"   , false,11, { 0x80, 0x81, 0x90, 60, 100, 0x81, 0xF3, 5, 0x82, 61, 100 }, 5, { 0x90, 60, 100, 0xF3, 5 }, 1 },
+  { "sysex"            , false, 9, { 0x80, 0x81, 0xF0, 0x7D, 1, 2, 3, 0x82, 0xF7 }, 6, { 0xF0, 0x7D, 1, 2, 3, 0xF7 }, 1 },
+  { "sysex start"      , false, 6, { 0x80, 0x81, 0xF0, 0x7D, 1, 2 }, 0, { 0 }, 0 },
+  { "sysex middle"     , true , 4, { 0x80, 3, 4, 5 }, 0, { 0 }, 0 },
+  { "sysex end"        , true , 4, { 0x80, 6, 0x83, 0xF7 }, 9, { 0xF0, 0x7D, 1, 2, 3, 4, 5, 6, 0xF7 }, 1 },
+  { "sysex real-time"  , false, 9, { 0x80, 0x81, 0xF0, 1, 0x82, 0xF8, 2, 0x83, 0xF7 }, 5, { 0xF8, 0xF0, 1, 2, 0xF7 }, 1 },
+  { "sysex aborted"    , false, 9, { 0x80, 0x81, 0xF0, 1, 2, 0x82, 0x90, 3, 4 }, 3, { 0x90, 3, 4 }, 2 },
+  { "sysex overflow"   , false,20, { 0x80, 0x81, 0xF0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17 }, 0, { 0 }, 0 },
+  { "overflow end"     , true , 4, { 0x80, 0x7F, 0x82, 0xF7 }, 0, { 0 }, 0 },
+  { "incomplete"       , false, 4, { 0x80, 0x81, 0x90, 60 }, 0, { 0 }, 0 },
+  { "bad header"       , false, 5, { 0x00, 0x81, 0x90, 60, 100 }, 0, { 0 }, 0 },
+  { "data first"       , false, 7, { 0x80, 60, 100, 0x81, 0x90, 1, 2 }, 3, { 0x90, 1, 2 }, 1 },
+  { "trailing stamp"   , false, 5, { 0x80, 0x81, 0xC0, 5, 0x82 }, 2, { 0xC0, 5 }, 1 },
+};
+
+const uint8_t corpus_count = sizeof(corpus) / sizeof(corpus[0]);
+
+uint8_t sysex_buf[SYSEX_SIZE];
+BLEMidiDecoder decoder(sysex_buf, sizeof(sysex_buf));
+
+// events of the current packet
+uint8_t  out[64];
+uint8_t  out_len;
+uint16_t out_ts;
+uint32_t violations;
+
+uint32_t rand_state = 0x12345678;
+
+uint32_t xorshift(void)
+{
+  rand_state ^= rand_state << 13;
+  rand_state ^= rand_state >> 17;
+  rand_state ^= rand_state << 5;
+  return rand_state;
+}
+
+uint8_t message_len(uint8_t status)
+{
+  if ( status < 0xC0 ) return 3;
+  if ( status < 0xE0 ) return 2;
+  if ( status < 0xF0 ) return 3;
+  if ( status == 0xF1 || status == 0xF3 ) return 2;
+  if ( status == 0xF2 ) return 3;
+  return 1;
+}
+
+// every event must be one well formed message
+void check_event(void* arg, uint16_t timestamp, const uint8_t* data, uint16_t len)
+{
+  (void) arg;
+  bool ok = (len > 0) && (data[0] & 0x80) && (timestamp < 8192);
+
+  if ( ok && data[0] == 0xF0 )
+  {
+    ok = (len >= 2) && (len <= SYSEX_SIZE) && (data[len-1] == 0xF7);
+    for (uint16_t i = 1; ok && i < len - 1; i++) ok = !(data[i] & 0x80);
+  }
+  else if ( ok )
+  {
+    ok = (data[0] != 0xF7) && (len == message_len(data[0]));
+    for (uint16_t i = 1; ok && i < len; i++) ok = !(data[i] & 0x80);
+  }
+
+  if ( !ok ) violations++;
+
+  for (uint16_t i = 0; i < len && out_len < sizeof(out); i++) out[out_len++] = data[i];
+  out_ts = timestamp;
+}
+
+void count_event(void* arg, uint16_t timestamp, const uint8_t* data, uint16_t len)
+{
+  (void) timestamp; (void) data;
+  *((uint32_t*) arg) += len;
+}
+
+void run_corpus(void)
+{
+  uint8_t passed = 0;
+  decoder.setEventCallback(check_event, NULL);
+
+  for (uint8_t i = 0; i < corpus_count; i++)
+  {
+    const corpus_t* c = &corpus[i];
+
+    if ( !c->cont ) decoder.reset();
+    out_len = 0;
+    decoder.decode(c->packet, c->len);
+
+    bool ok = (out_len == c->expect_len) && !memcmp(out, c->expect, out_len) &&
+              (!out_len || out_ts == c->last_ts);
+    if ( ok ) passed++;
+
+    Serial.printf("%-18s %s\n", c->name, ok ? "ok" : "FAIL");
+  }
+
+  Serial.printf("CORPUS %d/%d passed\n", passed, corpus_count);
+}
+
+void run_fuzz(void)
+{
+  decoder.reset();
+  decoder.resetStats();
+  decoder.setEventCallback(check_event, NULL);
+  violations = 0;
+
+  for (uint32_t r = 0; r < FUZZ_ROUNDS; r++)
+  {
+    uint8_t packet[20];
+    uint8_t len;
+
+    if ( r & 1 )
+    {
+      // random bytes, header mostly valid
+      len = 1 + xorshift() % sizeof(packet);
+      for (uint8_t i = 0; i < len; i++) packet[i] = xorshift();
+      if ( xorshift() & 3 ) packet[0] = (packet[0] | 0x80) & 0xBF;
+    }
+    else
+    {
+      // a corpus packet with a few bits flipped, bytes dropped or repeated
+      const corpus_t* c = &corpus[xorshift() % corpus_count];
+      len = c->len;
+      memcpy(packet, c->packet, len);
+
+      uint8_t edits = 1 + xorshift() % 3;
+      while ( edits-- )
+      {
+        uint8_t pos = xorshift() % len;
+        switch ( xorshift() % 3 )
+        {
+          case 0: packet[pos] ^= 1 << (xorshift() % 8); break;
+          case 1: if ( len > 1 ) { memmove(packet + pos, packet + pos + 1, len - pos - 1); len--; } break;
+          default:
+            if ( len < sizeof(packet) ) { memmove(packet + pos + 1, packet + pos, len - pos); len++; }
+          break;
+        }
+      }
+    }
+
+    out_len = 0;
+    decoder.decode(packet, len);
+  }
+
+  Serial.printf("FUZZ packets=%lu events=%lu errors=%lu sysex_dropped=%lu violations=%lu\n",
+                decoder.packets(), decoder.events(), decoder.errors(), decoder.sysexDropped(), violations);
+}
+
+void run_bench(void)
+{
+  // what a keyboard sends: aggregated chords with running status,
+  // controller sweeps and clock
+  const uint8_t packets[][20] =
+  {
+    { 0x80, 0x81, 0x90, 60, 100, 64, 100, 67, 100, 0x82, 72, 100, 76, 100, 0x83, 79, 100 },
+    { 0x80, 0x81, 0xB0, 1, 10, 0x82, 1, 11, 0x83, 1, 12, 0x84, 1, 13, 0x85, 1, 14, 0x86, 0xF8 },
+    { 0x80, 0x81, 0x80, 60, 0, 64, 0, 67, 0, 0x82, 0xE0, 0, 64, 0x83, 0, 65, 0x84, 0xF8 },
+  };
+  const uint8_t lens[] = { 17, 19, 18 };
+
+  uint32_t bytes  = 0;
+  uint32_t events = 0;
+  uint32_t out_bytes = 0;
+
+  decoder.reset();
+  decoder.resetStats();
+  decoder.setEventCallback(count_event, &out_bytes);
+
+  uint32_t start = micros();
+  for (uint32_t r = 0; r < BENCH_ROUNDS; r++)
+  {
+    for (uint8_t p = 0; p < 3; p++)
+    {
+      events += decoder.decode(packets[p], lens[p]);
+      bytes  += lens[p];
+    }
+  }
+  uint32_t us = micros() - start;
+  if ( !us ) us = 1;
+
+  Serial.printf("BENCH packets=%lu events=%lu us=%lu\n", decoder.packets(), events, us);
+  Serial.printf("BENCH us_per_packet=%.2f packets_per_s=%lu bytes_per_s=%lu events_per_s=%lu\n",
+                (float) us / decoder.packets(),
+                (uint32_t) ((uint64_t) decoder.packets() * 1000000 / us),
+                (uint32_t) ((uint64_t) bytes * 1000000 / us),
+                (uint32_t) ((uint64_t) events * 1000000 / us));
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println("Bluefruit52 BLE MIDI decoder check and benchmark");
+  Serial.println("-------------------------------------------------\n");
+
+  run_corpus();
+  run_fuzz();
+  run_bench();
+}
+
+void loop()
+{
+}
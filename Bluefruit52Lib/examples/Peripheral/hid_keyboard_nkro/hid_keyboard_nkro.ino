@@ -0,0 +1,125 @@
+/*********************************************************************
+ This is an example for our nRF52 based Bluefruit LE modules
+
+ Pick one up today in the adafruit shop!
+
+ Adafruit invests time and resources providing this open source code,
+ please support Adafruit and open-source hardware by purchasing
+ products from Adafruit!
+
+ MIT license, check LICENSE for more information
+ All text above, and the splash screen below must be included in
+ any redistribution
+*********************************************************************/
+
+/* N-Key Rollover keyboard benchmark
+ *
+ * Once connected, open a text editor on the host and send any character
+ * from the Serial Monitor. The sketch types a few typical strings with the
+ * 6-key report and then with the NKRO bitmap report, and prints reports per
+ * character and characters per second for each. Finally it holds a chord
+ * of 10 keys: the 6-key report can't carry it, the NKRO one sends it in a
+ * single report.
+ *
+ * Expect the same reports per character for plain text: a bitmap has no
+ * order, so a report can still add only one new key to what is held.
+ * NKRO pays off when many keys change or are held together.
+ */
+#include <bluefruit.h>
+
+BLEDis bledis;
+BLEHidAdafruit blehid;
+
+const char* samples[] =
+{
+  "The quick brown fox jumps over the lazy dog. ",
+  "hello, bookkeeper! aaa bbb 1000 ",
+  "void setup() { Serial.begin(115200); } ",
+};
+
+void setup()
+{
+  Serial.begin(115200);
+
+  Serial.println("Bluefruit52 HID NKRO Keyboard Benchmark");
+  Serial.println("---------------------------------------");
+
+  Bluefruit.begin();
+  Bluefruit.setName("Bluefruit52");
+
+  bledis.setManufacturer("Adafruit Industries");
+  bledis.setModel("Bluefruit Feather 52");
+  bledis.begin();
+
+  blehid.begin();
+  blehid.beginKeyQueue();
+
+  Bluefruit.Advertising.addFlags(BLE_GAP_ADV_FLAGS_LE_ONLY_GENERAL_DISC_MODE);
+  Bluefruit.Advertising.addTxPower();
+  Bluefruit.Advertising.addAppearance(BLE_APPEARANCE_HID_KEYBOARD);
+  Bluefruit.Advertising.addService(blehid);
+  Bluefruit.Advertising.addName();
+  Bluefruit.Advertising.start();
+
+  Serial.println("Pair, focus a text editor, then send any character to start");
+}
+
+void typeSamples(bool nkro)
+{
+  blehid.setKeyboardNKRO(nkro);
+
+  for(uint8_t i=0; i<sizeof(samples)/sizeof(samples[0]); i++)
+  {
+    blehid.resetKeyQueueStats();
+    blehid.keySequence(samples[i]);
+    blehid.keyQueueWait(10000);
+
+    Serial.print(nkro ? "NKRO " : "6KRO ");
+    blehid.printKeyQueueStats(Serial);
+  }
+
+  blehid.keySequence("\n");
+  blehid.keyQueueWait(1000);
+}
+
+void typeChord(void)
+{
+  // a..j held together
+  hid_nkro_keyboard_report_t report;
+  varclr(&report);
+
+  for(uint8_t keycode = HID_KEY_A; keycode < HID_KEY_A + 10; keycode++)
+  {
+    hid_nkro_set_key(&report, keycode, true);
+  }
+
+  blehid.keyboardReportNKRO(&report);
+  delay(100);
+
+  varclr(&report);
+  blehid.keyboardReportNKRO(&report);
+
+  Serial.println("Chord of 10 keys: 6KRO can't report it, NKRO reports = 1");
+}
+
+void loop()
+{
+  if ( Serial.available() )
+  {
+    while ( Serial.available() ) Serial.read();
+
+    if ( !Bluefruit.connected() )
+    {
+      Serial.println("Not connected");
+      return;
+    }
+
+    typeSamples(false);
+    typeSamples(true);
+    typeChord();
+
+    blehid.setKeyboardNKRO(false);
+  }
+
+  waitForEvent();
+}
@@ -32,6 +32,7 @@ void setup()
   Serial.println("- 'WASD'  to move mouse (up, left, down, right)");
   Serial.println("- 'LRMBF' to press mouse button(s) (left, right, middle, backward, forward)");
   Serial.println("- 'X'     to release mouse button(s)");
+  Serial.println("- 'Q'     to draw a square from 1 ms moves and print the report statistics");
 
   Bluefruit.begin();
   // HID Device can have a min connection interval of 9*1.25 = 11.25 ms
@@ -46,6 +47,9 @@ void setup()
   // BLE HID
   blehid.begin();
 
+  // Sum mouse moves and button changes into one report per connection interval
+  blehid.beginMouseCoalescing();
+
   // Set up Advertising Packet
   setupAdv();
 
@@ -125,8 +129,28 @@ void loop()
         blehid.mouseButtonRelease();
       break;
 
+      case 'Q':
+        drawSquare();
+      break;
+
       default: break;
     }
   }
 }
 
+// A motion source running at 1 kHz, much faster than the connection interval
+void drawSquare(void)
+{
+  const int8_t dir[4][2] = { {2, 0}, {0, 2}, {-2, 0}, {0, -2} };
+
+  blehid.resetMouseStats();
+
+  for(int i=0; i<400; i++)
+  {
+    blehid.mouseMove(dir[i/100][0], dir[i/100][1]);
+    delay(1);
+  }
+
+  blehid.mouseWait(1000);
+  blehid.printMouseStats(Serial);
+}
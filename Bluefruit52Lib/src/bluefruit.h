@@ -73,6 +73,7 @@
 #include "services/BLEBas.h"
 #include "services/BLEBeacon.h"
 #include "services/BLEHidGeneric.h"
+#include "services/BLEHidReportMap.h"
 #include "services/BLEHidAdafruit.h"
 #include "services/BLEMidi.h"
 
@@ -41,10 +41,11 @@ enum
   REPORT_ID_KEYBOARD = 1,
   REPORT_ID_CONSUMER_CONTROL,
   REPORT_ID_MOUSE,
+  REPORT_ID_NKRO_KEYBOARD,
   REPORT_ID_GAMEPAD
 };
 
-uint8_t const hid_report_descriptor[] =
+constexpr uint8_t hid_report_descriptor[] =
 {
   //------------- Keyboard Report  -------------//
   HID_USAGE_PAGE ( HID_USAGE_PAGE_DESKTOP     ),
@@ -154,6 +155,9 @@ uint8_t const hid_report_descriptor[] =
     HID_COLLECTION_END,
   HID_COLLECTION_END,
 
+  //------------- N-Key Rollover Keyboard Report -------------//
+  HID_REPORT_DESC_NKRO_KEYBOARD( REPORT_ID_NKRO_KEYBOARD ),
+
 #if 0
   //------------- Gamepad Report -------------//
   /* Byte 0: 4 pad | 2 Y-axis | 2 X-axis
@@ -193,20 +197,48 @@ uint8_t const hid_report_descriptor[] =
 #endif
 };
 
+typedef BLE_HID_REPORT_MAP(hid_report_descriptor) hid_report_map_t;
+
+static_assert(hid_report_map_t::input_count == REPORT_ID_NKRO_KEYBOARD && hid_report_map_t::output_count == 1, "report count");
+static_assert(hid_report_map_t::inputLen(REPORT_ID_KEYBOARD)         == sizeof(hid_keyboard_report_t)        , "keyboard report");
+static_assert(hid_report_map_t::outputLen(REPORT_ID_KEYBOARD)        == 1                                    , "keyboard led report");
+static_assert(hid_report_map_t::inputLen(REPORT_ID_CONSUMER_CONTROL) == sizeof(hid_consumer_control_report_t), "consumer control report");
+static_assert(hid_report_map_t::inputLen(REPORT_ID_MOUSE)            == sizeof(hid_mouse_report_t)           , "mouse report");
+static_assert(hid_report_map_t::inputLen(REPORT_ID_NKRO_KEYBOARD)    == sizeof(hid_nkro_keyboard_report_t)   , "nkro keyboard report");
+
 BLEHidAdafruit::BLEHidAdafruit(void)
-  : BLEHidGeneric(3, 1, 0)
+  : BLEHidGeneric(hid_report_map_t::input_count, hid_report_map_t::output_count, hid_report_map_t::feature_count)
 {
   _mse_buttons = 0;
+  _kbd_nkro    = false;
+
+  _kq          = NULL;
+  _kq_task     = NULL;
+  _kq_mutex    = NULL;
+  _kq_per_conn = false;
+  _kq_sending  = false;
+  _kq_start_us = 0;
+  varclr(&_kq_last);
+
+  varclr(_mc_seg);
+  _mc_head        = 0;
+  _mc_count       = 1;    // current button state, already reported
+  _mc_seg[0].reported = true;
+  _mc_mutex       = NULL;
+  _mc_sem         = NULL;
+  _mc_task        = NULL;
+  _mc_per_conn    = true;
+  _mc_sending     = false;
+  _mc_pending_us  = 0;
+
+  resetKeyQueueStats();
+  resetMouseStats();
 }
 
 err_t BLEHidAdafruit::begin(void)
 {
-  uint16_t input_len [] = { sizeof(hid_keyboard_report_t),  sizeof(hid_consumer_control_report_t), sizeof(hid_mouse_report_t) };
-  uint16_t output_len[] = { 1 };
-
-  setReportLen(input_len, output_len, NULL);
   enableBootProtocol(true, true);
-  setReportMap(hid_report_descriptor, sizeof(hid_report_descriptor));
+  setReportMap<hid_report_map_t>();
 
   VERIFY_STATUS( BLEHidGeneric::begin() );
 
@@ -221,7 +253,97 @@ err_t BLEHidAdafruit::begin(void)
  *------------------------------------------------------------------*/
 bool BLEHidAdafruit::keyboardReport(hid_keyboard_report_t* report)
 {
-  return inputReport( REPORT_ID_KEYBOARD, report, sizeof(hid_keyboard_report_t));
+  // keep the order with what is queued
+  if ( _kq )
+  {
+    xSemaphoreTake(_kq_mutex, portMAX_DELAY);
+    bool const ok = _kq_push(report, 0, portMAX_DELAY);
+    xSemaphoreGive(_kq_mutex);
+    return ok;
+  }
+
+  return _kbd_send(report);
+}
+
+// Send a 6KRO report on the keyboard the host is using
+bool BLEHidAdafruit::_kbd_send(const hid_keyboard_report_t* report)
+{
+  // Host only understands the boot keyboard
+  if ( isBootProtocol() ) return bootKeyboardReport(report, sizeof(hid_keyboard_report_t));
+
+  if ( _kbd_nkro )
+  {
+    hid_nkro_keyboard_report_t nkro;
+    varclr(&nkro);
+
+    nkro.modifier = report->modifier;
+    for(uint8_t i=0; i<6; i++)
+    {
+      // skip no key and the error codes
+      if ( report->keycode[i] >= HID_KEY_A ) hid_nkro_set_key(&nkro, report->keycode[i], true);
+    }
+
+    return inputReport(REPORT_ID_NKRO_KEYBOARD, &nkro, sizeof(hid_nkro_keyboard_report_t));
+  }
+
+  return inputReport(REPORT_ID_KEYBOARD, report, sizeof(hid_keyboard_report_t));
+}
+
+void BLEHidAdafruit::setKeyboardNKRO(bool enabled)
+{
+  if ( enabled == _kbd_nkro ) return;
+
+  // queued reports are for the current keyboard
+  if ( _kq ) keyQueueWait(UINT32_MAX);
+
+  // don't leave keys held on the keyboard we stop using
+  if ( !isBootProtocol() )
+  {
+    if ( _kbd_nkro )
+    {
+      hid_nkro_keyboard_report_t release;
+      varclr(&release);
+      inputReport(REPORT_ID_NKRO_KEYBOARD, &release, sizeof(hid_nkro_keyboard_report_t));
+    }else
+    {
+      hid_keyboard_report_t release;
+      varclr(&release);
+      inputReport(REPORT_ID_KEYBOARD, &release, sizeof(hid_keyboard_report_t));
+    }
+  }
+
+  _kbd_nkro = enabled;
+}
+
+bool BLEHidAdafruit::isKeyboardNKRO(void)
+{
+  return _kbd_nkro;
+}
+
+bool BLEHidAdafruit::keyboardReportNKRO(hid_nkro_keyboard_report_t* report)
+{
+  if ( !isBootProtocol() ) return inputReport(REPORT_ID_NKRO_KEYBOARD, report, sizeof(hid_nkro_keyboard_report_t));
+
+  // Boot keyboard: first 6 keys, more than that is a rollover error
+  hid_keyboard_report_t boot;
+  varclr(&boot);
+  boot.modifier = report->modifier;
+
+  uint8_t count = 0;
+  for(uint8_t keycode = HID_KEY_A; keycode <= HID_NKRO_KEYCODE_MAX; keycode++)
+  {
+    if ( !(report->keys[keycode >> 3] & bit(keycode & 7)) ) continue;
+
+    if ( count == 6 )
+    {
+      memset(boot.keycode, HID_KEY_ERROR_ROLLOVER, 6);
+      break;
+    }
+
+    boot.keycode[count++] = keycode;
+  }
+
+  return bootKeyboardReport(&boot, sizeof(hid_keyboard_report_t));
 }
 
 bool BLEHidAdafruit::keyboardReport(uint8_t modifier, uint8_t keycode[6])
@@ -268,25 +390,209 @@ bool BLEHidAdafruit::keyRelease(void)
 
 bool BLEHidAdafruit::keySequence(const char* str, int interal)
 {
-  // Send each key in sequence
+  (void) interal;
+
+  VERIFY( beginKeyQueue() );
+
+  // the whole sequence goes in one piece
+  xSemaphoreTake(_kq_mutex, portMAX_DELAY);
+
+  bool ok = true;
   char ch;
-  while( (ch = *str++) != 0 )
+  while( ok && (ch = *str++) != 0 )
   {
-    char lookahead = *str;
+    ok = _kq_push_char(ch, portMAX_DELAY);
+  }
+
+  // don't leave the last key held
+  hid_keyboard_report_t release;
+  varclr(&release);
+
+  if ( ok ) ok = _kq_push(&release, 0, portMAX_DELAY);
+
+  xSemaphoreGive(_kq_mutex);
+
+  return ok;
+}
+
+/*------------------------------------------------------------------*/
+/* Keyboard Queue
+ *------------------------------------------------------------------*/
+bool BLEHidAdafruit::beginKeyQueue(uint16_t depth)
+{
+  if ( _kq ) return true;
 
-    keyPress(ch);
-    delay(interal);
+  if ( !_kq_mutex ) _kq_mutex = xSemaphoreCreateMutex();
+  VERIFY( _kq_mutex );
 
-    /* Only need to empty report if the next character is NULL or the same with
-     * the current one, or no need to send */
-    if ( lookahead == ch || lookahead == 0 )
+  _kq = xQueueCreate(depth, sizeof(key_queue_item_t));
+  VERIFY( _kq );
+
+  if ( pdPASS != xTaskCreate(_kq_task_entry, "HID Keys", BLE_HID_KEY_TASK_STACKSIZE, this, TASK_PRIO_LOW, &_kq_task) )
+  {
+    vQueueDelete(_kq);
+    _kq = NULL;
+    return false;
+  }
+
+  return true;
+}
+
+void BLEHidAdafruit::setKeyQueuePacing(bool perConnInterval)
+{
+  _kq_per_conn = perConnInterval;
+}
+
+// Queue a report unless it equals the previous one
+bool BLEHidAdafruit::_kq_push(const hid_keyboard_report_t* report, uint8_t chars, TickType_t wait)
+{
+  if ( 0 == memcmp(report, &_kq_last, sizeof(hid_keyboard_report_t)) )
+  {
+    _kq_stats.collapsed++;
+    return true;
+  }
+
+  key_queue_item_t item;
+  item.report = *report;
+  item.chars  = chars;
+
+  VERIFY( pdTRUE == xQueueSend(_kq, &item, wait) );
+
+  _kq_last = *report;
+  return true;
+}
+
+bool BLEHidAdafruit::_kq_push_char(char ch, TickType_t wait)
+{
+  hid_ascii_to_keycode_entry_t const entry = HID_ASCII_TO_KEYCODE[ ((uint8_t) ch) & 0x7F ];
+
+  // nothing to type for it
+  if ( !entry.keycode ) return true;
+
+  hid_keyboard_report_t report;
+  varclr(&report);
+
+  // the same key again must be released first to count as a new press
+  if ( _kq_last.keycode[0] == entry.keycode )
+  {
+    VERIFY( _kq_push(&report, 0, wait) );
+  }
+
+  report.modifier   = entry.shift ? KEYBOARD_MODIFIER_LEFTSHIFT : 0;
+  report.keycode[0] = entry.keycode;
+
+  return _kq_push(&report, 1, wait);
+}
+
+size_t BLEHidAdafruit::keyQueue(const char* str)
+{
+  VERIFY( beginKeyQueue(), 0 );
+
+  // another task is queueing (and may be waiting for room)
+  if ( pdTRUE != xSemaphoreTake(_kq_mutex, 0) ) return 0;
+
+  size_t count = 0;
+
+  // a character takes two reports at most, plus the final release
+  while ( str[count] && uxQueueSpacesAvailable(_kq) >= 3 )
+  {
+    _kq_push_char(str[count++], 0);
+  }
+
+  if ( count )
+  {
+    hid_keyboard_report_t release;
+    varclr(&release);
+    _kq_push(&release, 0, 0);
+  }
+
+  xSemaphoreGive(_kq_mutex);
+
+  return count;
+}
+
+uint16_t BLEHidAdafruit::keyQueuePending(void)
+{
+  return _kq ? uxQueueMessagesWaiting(_kq) : 0;
+}
+
+bool BLEHidAdafruit::keyQueueWait(uint32_t timeout_ms)
+{
+  uint32_t const start = millis();
+
+  while ( keyQueuePending() || _kq_sending )
+  {
+    if ( millis() - start >= timeout_ms ) return false;
+    delay(1);
+  }
+
+  return true;
+}
+
+void BLEHidAdafruit::_kq_task_entry(void* arg)
+{
+  ((BLEHidAdafruit*) arg)->_kq_run();
+}
+
+void BLEHidAdafruit::_kq_run(void)
+{
+  key_queue_item_t item;
+
+  while(1)
+  {
+    // mark it in flight while it is still counted as pending, so that
+    // keyQueueWait() never sees neither
+    if ( pdTRUE != xQueuePeek(_kq, &item, portMAX_DELAY) ) continue;
+    _kq_sending = true;
+    xQueueReceive(_kq, &item, 0);
+
+    if ( !_kq_start_us ) _kq_start_us = micros();
+
+    // waits for a TX buffer, i.e. as fast as the connection events drain them
+    _kbd_send(&item.report);
+    _kq_sending = false;
+
+    _kq_stats.reports++;
+    _kq_stats.chars += item.chars;
+
+    if ( _kq_per_conn )
     {
-      keyRelease();
-      delay(interal);
+      uint32_t ms = MS125TO100(Bluefruit.connInterval());
+      vTaskDelay( ms2tick(ms ? ms : 1) );
+    }
+
+    if ( !uxQueueMessagesWaiting(_kq) )
+    {
+      _kq_stats.active_us += micros() - _kq_start_us;
+      _kq_start_us = 0;
     }
   }
+}
 
-  return true;
+const hid_key_queue_stats_t& BLEHidAdafruit::getKeyQueueStats(void)
+{
+  return _kq_stats;
+}
+
+void BLEHidAdafruit::resetKeyQueueStats(void)
+{
+  varclr(&_kq_stats);
+}
+
+void BLEHidAdafruit::printKeyQueueStats(Print& p)
+{
+  hid_key_queue_stats_t const st = _kq_stats;
+
+  p.print("HID keys chars=");
+  p.print(st.chars);
+  p.print(" reports=");
+  p.print(st.reports);
+  p.print(" collapsed=");
+  p.print(st.collapsed);
+  p.print(" reports_per_char=");
+  p.print(st.chars ? (float) st.reports / st.chars : 0.0f, 2);
+  p.print(" chars_per_s=");
+  p.println(st.active_us ? (float) st.chars * 1000000 / st.active_us : 0.0f, 1);
 }
 
 /*------------------------------------------------------------------*/
@@ -313,6 +619,16 @@ bool BLEHidAdafruit::consumerKeyRelease(void)
  *------------------------------------------------------------------*/
 bool BLEHidAdafruit::mouseReport(hid_mouse_report_t* report)
 {
+  if ( _mc_task ) return _mc_add(report->buttons, report->x, report->y, report->wheel, report->pan);
+
+  return _mse_send(report);
+}
+
+bool BLEHidAdafruit::_mse_send(const hid_mouse_report_t* report)
+{
+  // Boot mouse: buttons, x, y only
+  if ( isBootProtocol() ) return bootMouseReport(report, 3);
+
   return inputReport( REPORT_ID_MOUSE, report, sizeof(hid_mouse_report_t));
 }
 
@@ -357,3 +673,209 @@ bool BLEHidAdafruit::mousePan(int8_t pan)
 {
   return mouseReport(_mse_buttons, 0, 0, 0, pan);
 }
+
+/*------------------------------------------------------------------*/
+/* Mouse Coalescing
+ *------------------------------------------------------------------*/
+bool BLEHidAdafruit::beginMouseCoalescing(void)
+{
+  if ( _mc_task ) return true;
+
+  if ( !_mc_mutex ) _mc_mutex = xSemaphoreCreateMutex();
+  if ( !_mc_sem   ) _mc_sem   = xSemaphoreCreateBinary();
+  VERIFY( _mc_mutex && _mc_sem );
+
+  _mc_seg[0].buttons = _mse_buttons;
+
+  return pdPASS == xTaskCreate(_mc_task_entry, "HID Mouse", BLE_HID_MOUSE_TASK_STACKSIZE, this, TASK_PRIO_LOW, &_mc_task);
+}
+
+void BLEHidAdafruit::setMousePacing(bool perConnInterval)
+{
+  _mc_per_conn = perConnInterval;
+}
+
+bool BLEHidAdafruit::_mc_add(uint8_t buttons, int8_t x, int8_t y, int8_t wheel, int8_t pan)
+{
+  xSemaphoreTake(_mc_mutex, portMAX_DELAY);
+
+  mouse_segment_t* seg = &_mc_seg[ (_mc_head + _mc_count - 1) % BLE_HID_MOUSE_SEGMENTS ];
+
+  // a button change starts a new segment, motion so far goes with the old state
+  if ( buttons != seg->buttons )
+  {
+    if ( _mc_count == BLE_HID_MOUSE_SEGMENTS )
+    {
+      _mc_stats.overflows++;
+      xSemaphoreGive(_mc_mutex);
+      return false;
+    }
+
+    seg = &_mc_seg[ (_mc_head + _mc_count) % BLE_HID_MOUSE_SEGMENTS ];
+    varclr(seg);
+    seg->buttons = buttons;
+    _mc_count++;
+  }
+
+  seg->x     += x;
+  seg->y     += y;
+  seg->wheel += wheel;
+  seg->pan   += pan;
+
+  if ( !_mc_pending_us && _mc_pending() ) _mc_pending_us = micros();
+  _mc_stats.updates++;
+
+  xSemaphoreGive(_mc_mutex);
+  xSemaphoreGive(_mc_sem);
+
+  return true;
+}
+
+// Mutex must be held
+bool BLEHidAdafruit::_mc_pending(void)
+{
+  mouse_segment_t const* seg = &_mc_seg[_mc_head];
+  return (_mc_count > 1) || !seg->reported || seg->x || seg->y || seg->wheel || seg->pan;
+}
+
+// Take at most +/-127 from an accumulated delta
+static int8_t mouse_take(int32_t* acc)
+{
+  int32_t const v = (*acc > 127) ? 127 : (*acc < -127) ? -127 : *acc;
+  *acc -= v;
+  return (int8_t) v;
+}
+
+// Send one report from the oldest segment, false if there was nothing
+bool BLEHidAdafruit::_mc_send_one(void)
+{
+  hid_mouse_report_t report;
+
+  xSemaphoreTake(_mc_mutex, portMAX_DELAY);
+
+  // skip a state already sent when a newer one follows
+  while ( _mc_count > 1 && _mc_seg[_mc_head].reported &&
+          !(_mc_seg[_mc_head].x || _mc_seg[_mc_head].y || _mc_seg[_mc_head].wheel || _mc_seg[_mc_head].pan) )
+  {
+    _mc_head = (_mc_head + 1) % BLE_HID_MOUSE_SEGMENTS;
+    _mc_count--;
+  }
+
+  if ( !_mc_pending() )
+  {
+    xSemaphoreGive(_mc_mutex);
+    return false;
+  }
+
+  mouse_segment_t* seg = &_mc_seg[_mc_head];
+
+  report.buttons = seg->buttons;
+  report.x       = mouse_take(&seg->x);
+  report.y       = mouse_take(&seg->y);
+  report.wheel   = mouse_take(&seg->wheel);
+  report.pan     = mouse_take(&seg->pan);
+  seg->reported  = true;
+
+  bool const split = seg->x || seg->y || seg->wheel || seg->pan;
+
+  // done with this button state
+  if ( !split && _mc_count > 1 )
+  {
+    _mc_head = (_mc_head + 1) % BLE_HID_MOUSE_SEGMENTS;
+    _mc_count--;
+  }
+
+  uint32_t const since = _mc_pending_us;
+
+  // what is left counts from the same update (an upper bound)
+  _mc_pending_us = _mc_pending() ? since : 0;
+  _mc_sending    = true;
+
+  xSemaphoreGive(_mc_mutex);
+
+  // waits for a TX buffer
+  _mse_send(&report);
+
+  uint32_t const latency = micros() - since;
+
+  _mc_stats.reports++;
+  if ( split ) _mc_stats.splits++;
+  _mc_stats.latency_sum_us += latency;
+  if ( latency > _mc_stats.latency_max_us ) _mc_stats.latency_max_us = latency;
+
+  _mc_sending = false;
+
+  return true;
+}
+
+void BLEHidAdafruit::_mc_task_entry(void* arg)
+{
+  ((BLEHidAdafruit*) arg)->_mc_run();
+}
+
+void BLEHidAdafruit::_mc_run(void)
+{
+  while(1)
+  {
+    xSemaphoreTake(_mc_sem, portMAX_DELAY);
+
+    // updates arriving meanwhile are summed into the next report
+    while ( _mc_send_one() )
+    {
+      if ( _mc_per_conn )
+      {
+        uint32_t ms = MS125TO100(Bluefruit.connInterval());
+        vTaskDelay( ms2tick(ms ? ms : 1) );
+      }
+    }
+  }
+}
+
+bool BLEHidAdafruit::mouseWait(uint32_t timeout_ms)
+{
+  if ( !_mc_task ) return true;
+
+  uint32_t const start = millis();
+
+  while(1)
+  {
+    xSemaphoreTake(_mc_mutex, portMAX_DELAY);
+    bool const busy = _mc_pending() || _mc_sending;
+    xSemaphoreGive(_mc_mutex);
+
+    if ( !busy ) return true;
+    if ( millis() - start >= timeout_ms ) return false;
+
+    delay(1);
+  }
+}
+
+const hid_mouse_stats_t& BLEHidAdafruit::getMouseStats(void)
+{
+  return _mc_stats;
+}
+
+void BLEHidAdafruit::resetMouseStats(void)
+{
+  varclr(&_mc_stats);
+}
+
+void BLEHidAdafruit::printMouseStats(Print& p)
+{
+  hid_mouse_stats_t const st = _mc_stats;
+
+  p.print("HID mouse updates=");
+  p.print(st.updates);
+  p.print(" reports=");
+  p.print(st.reports);
+  p.print(" splits=");
+  p.print(st.splits);
+  p.print(" overflows=");
+  p.print(st.overflows);
+  p.print(" updates_per_report=");
+  p.print(st.reports ? (float) st.updates / st.reports : 0.0f, 2);
+  p.print(" latency_avg_us=");
+  p.print(st.reports ? (uint32_t) (st.latency_sum_us / st.reports) : 0);
+  p.print(" latency_max_us=");
+  p.println(st.latency_max_us);
+}
@@ -43,11 +43,88 @@
 #include "BLEHidGeneric.h"
 #include "BLEService.h"
 
+#define BLE_HID_KEY_QUEUE_DEPTH       48
+#define BLE_HID_KEY_TASK_STACKSIZE    256
+
+#define BLE_HID_MOUSE_SEGMENTS        8     // button changes waiting to be sent
+#define BLE_HID_MOUSE_TASK_STACKSIZE  256
+
+typedef struct
+{
+  uint32_t chars;         // characters typed
+  uint32_t reports;       // keyboard reports sent
+  uint32_t collapsed;     // reports dropped as no change
+  uint64_t active_us;     // time the queue was not empty
+} hid_key_queue_stats_t;
+
+typedef struct
+{
+  uint32_t updates;       // mouse calls accumulated
+  uint32_t reports;       // mouse reports sent
+  uint32_t splits;        // reports sent with motion left over (beyond +/-127)
+  uint32_t overflows;     // button changes refused, too many waiting
+  uint32_t latency_max_us;  // oldest update to its report handed to the stack
+  uint64_t latency_sum_us;
+} hid_mouse_stats_t;
 
 class BLEHidAdafruit : public BLEHidGeneric
 {
   protected:
     uint8_t _mse_buttons;
+    bool    _kbd_nkro;
+
+    bool _kbd_send(const hid_keyboard_report_t* report);
+
+    // keyboard output queue
+    typedef struct ATTR_PACKED
+    {
+      hid_keyboard_report_t report;
+      uint8_t chars;      // characters completed by this report
+    } key_queue_item_t;
+
+    QueueHandle_t         _kq;
+    TaskHandle_t          _kq_task;
+    SemaphoreHandle_t     _kq_mutex;    // producers, guards _kq_last
+    hid_keyboard_report_t _kq_last;     // last report queued
+    bool                  _kq_per_conn;
+    volatile bool         _kq_sending;  // a report taken off the queue is not sent yet
+    uint32_t              _kq_start_us;
+    hid_key_queue_stats_t _kq_stats;
+
+    // caller holds _kq_mutex
+    bool _kq_push(const hid_keyboard_report_t* report, uint8_t chars, TickType_t wait);
+    bool _kq_push_char(char ch, TickType_t wait);
+    void _kq_run(void);
+
+    static void _kq_task_entry(void* arg);
+
+    // mouse accumulator: a segment per button state, motion is summed into
+    // the newest one and sent from the oldest
+    typedef struct
+    {
+      int32_t x, y, wheel, pan;
+      uint8_t buttons;
+      bool    reported;   // its button state was sent
+    } mouse_segment_t;
+
+    mouse_segment_t   _mc_seg[BLE_HID_MOUSE_SEGMENTS];
+    uint8_t           _mc_head;
+    uint8_t           _mc_count;
+    SemaphoreHandle_t _mc_mutex;
+    SemaphoreHandle_t _mc_sem;
+    TaskHandle_t      _mc_task;
+    bool              _mc_per_conn;
+    volatile bool     _mc_sending;
+    uint32_t          _mc_pending_us;   // oldest update not sent, 0 if none
+    hid_mouse_stats_t _mc_stats;
+
+    bool _mse_send(const hid_mouse_report_t* report);
+    bool _mc_add(uint8_t buttons, int8_t x, int8_t y, int8_t wheel, int8_t pan);
+    bool _mc_pending(void);
+    bool _mc_send_one(void);
+    void _mc_run(void);
+
+    static void _mc_task_entry(void* arg);
 
   public:
     BLEHidAdafruit(void);
@@ -61,6 +138,32 @@ class BLEHidAdafruit : public BLEHidGeneric
 
     bool keyPress(char ch);
     bool keyRelease(void);
+
+    // N-Key Rollover: with NKRO on, keyboard reports above (and queued
+    // typing) go out as the bitmap report instead of the 6-key one.
+    // keyboardReportNKRO() sends a bitmap with any number of keys held.
+    // A host using the boot protocol gets the boot keyboard report either way.
+    void setKeyboardNKRO(bool enabled);
+    bool isKeyboardNKRO(void);
+    bool keyboardReportNKRO(hid_nkro_keyboard_report_t* report);
+
+    // Queued typing: once the key queue is started every keyboard report
+    // goes through it and a task sends them as fast as the connection takes
+    // them (TX buffers), or one per connection interval. A key is released
+    // only when the next character needs it, reports that change nothing
+    // are dropped.
+    bool     beginKeyQueue(uint16_t depth = BLE_HID_KEY_QUEUE_DEPTH);
+    void     setKeyQueuePacing(bool perConnInterval);
+    size_t   keyQueue(const char* str);     // doesn't wait, returns characters queued
+    uint16_t keyQueuePending(void);         // reports not sent yet
+    bool     keyQueueWait(uint32_t timeout_ms); // until everything is sent
+
+    const hid_key_queue_stats_t& getKeyQueueStats(void);
+    void     resetKeyQueueStats(void);
+    void     printKeyQueueStats(Print& p);  // reports per character, characters per second
+
+    // Queues the whole string, waits only while the queue is full.
+    // interal is no longer used: reports are paced by the connection.
     bool keySequence(const char* str, int interal=5);
 
     // Consumer Media Keys
@@ -78,6 +181,20 @@ class BLEHidAdafruit : public BLEHidGeneric
     bool mouseMove(int8_t x, int8_t y);
     bool mouseScroll(int8_t scroll);
     bool mousePan(int8_t pan);
+
+    // Mouse coalescing: once started the mouse calls above only add to an
+    // accumulator and a task sends one report per connection interval (or
+    // per free TX buffer, setMousePacing(false)) with everything summed
+    // since the last one. Deltas beyond +/-127 are carried to the next
+    // report, button changes are kept in order. A fast motion source then
+    // costs no extra reports and no reports wait behind stale ones.
+    bool beginMouseCoalescing(void);
+    void setMousePacing(bool perConnInterval);
+    bool mouseWait(uint32_t timeout_ms);    // until everything is sent
+
+    const hid_mouse_stats_t& getMouseStats(void);
+    void resetMouseStats(void);
+    void printMouseStats(Print& p);         // updates per report, latency
 };
 
 #endif /* BLEHIDADAFRUIT_H_ */
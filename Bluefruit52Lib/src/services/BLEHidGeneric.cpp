@@ -107,7 +107,7 @@ void BLEHidGeneric::setReportMap(const uint8_t* report_map, size_t len)
   _report_map_len = len;
 }
 
-void BLEHidGeneric::setReportLen(uint16_t input_len[], uint16_t output_len[], uint16_t feature_len[])
+void BLEHidGeneric::setReportLen(const uint16_t input_len[], const uint16_t output_len[], const uint16_t feature_len[])
 {
   _input_len   = input_len;
   _output_len  = output_len;
@@ -155,8 +155,9 @@ err_t BLEHidGeneric::begin(void)
     _chr_inputs[i].setPermission(SECMODE_ENC_NO_MITM, SECMODE_NO_ACCESS);
     _chr_inputs[i].setReportRefDescriptor(i+1, REPORT_TYPE_INPUT);
 
-    // Input report len is configured, else variable len up to 255
-    if ( _input_len ) _chr_inputs[i].setFixedLen( _input_len[i] );
+    // Input report len is configured, else variable len up to 255.
+    // 0 is a report ID without an input report
+    if ( _input_len && _input_len[i] ) _chr_inputs[i].setFixedLen( _input_len[i] );
 
     VERIFY_STATUS( _chr_inputs[i].begin() );
   }
@@ -174,7 +175,7 @@ err_t BLEHidGeneric::begin(void)
     )
 
     // Input report len is configured, else variable len up to 255
-    if ( _output_len ) _chr_outputs[i].setFixedLen( _output_len[i] );
+    if ( _output_len && _output_len[i] ) _chr_outputs[i].setFixedLen( _output_len[i] );
 
     VERIFY_STATUS( _chr_outputs[i].begin() );
 
@@ -212,7 +213,7 @@ err_t BLEHidGeneric::begin(void)
   {
     _chr_boot_mouse_input = new BLECharacteristic(UUID16_CHR_BOOT_MOUSE_INPUT_REPORT);
     _chr_boot_mouse_input->setProperties(CHR_PROPS_READ | CHR_PROPS_NOTIFY);
-    _chr_boot_mouse_input->setFixedLen(sizeof(hid_mouse_report_t));
+    _chr_boot_mouse_input->setFixedLen(3); // boot mouse is buttons, x, y
     _chr_boot_mouse_input->setPermission(SECMODE_ENC_NO_MITM, SECMODE_NO_ACCESS);
     VERIFY_STATUS(_chr_boot_mouse_input->begin());
   }
@@ -244,6 +245,27 @@ bool BLEHidGeneric::inputReport(uint8_t reportID, void const* data, int len)
   return _chr_inputs[reportID-1].notify( (uint8_t const*) data, len);
 }
 
+bool BLEHidGeneric::isBootProtocol(void)
+{
+  // Report Protocol is the default
+  uint8_t mode = 1;
+  if ( _chr_protocol ) _chr_protocol->read(&mode, 1);
+
+  return mode == 0;
+}
+
+bool BLEHidGeneric::bootKeyboardReport(void const* data, int len)
+{
+  VERIFY( _chr_boot_keyboard_input );
+  return _chr_boot_keyboard_input->notify( (uint8_t const*) data, len);
+}
+
+bool BLEHidGeneric::bootMouseReport(void const* data, int len)
+{
+  VERIFY( _chr_boot_mouse_input );
+  return _chr_boot_mouse_input->notify( (uint8_t const*) data, len);
+}
+
 /*------------------------------------------------------------------*/
 /*
  *------------------------------------------------------------------*/
@@ -66,6 +66,17 @@ typedef ATTR_PACKED_STRUCT(struct)
   uint8_t keycode[6]; /**< Key codes of the currently pressed keys. */
 } hid_keyboard_report_t;
 
+/// N-Key Rollover Keyboard Report: a bit per key code, any number of keys
+/// pressed at once. Key codes above HID_NKRO_KEYCODE_MAX can't be reported.
+#define HID_NKRO_KEYCODE_MAX   0x77
+#define HID_NKRO_KEY_BYTES     ((HID_NKRO_KEYCODE_MAX + 1) / 8)
+
+typedef ATTR_PACKED_STRUCT(struct)
+{
+  uint8_t modifier;                 /**< Keyboard modifier byte, as in the boot report. */
+  uint8_t keys[HID_NKRO_KEY_BYTES]; /**< Bit (n & 7) of keys[n >> 3] is set while key code n is pressed. */
+} hid_nkro_keyboard_report_t;
+
 /// HID Consumer Control Report
 typedef ATTR_PACKED_STRUCT(struct)
 {
@@ -95,15 +106,30 @@ class BLEHidGeneric : public BLEService
     void enableBootProtocol(bool bootKeyboard, bool bootMouse);
     void setHidInfo(uint16_t bcd, uint8_t country, uint8_t flags);
 
-    void setReportLen(uint16_t input_len[], uint16_t output_len[] = NULL, uint16_t feature_len[] = NULL);
+    void setReportLen(const uint16_t input_len[], const uint16_t output_len[] = NULL, const uint16_t feature_len[] = NULL);
     void setReportMap(const uint8_t* report_map, size_t len);
 
+    // Report map and report lengths from a BLE_HID_REPORT_MAP() type
+    // (BLEHidReportMap.h), all computed at compile time
+    template <class ReportMap>
+    void setReportMap(void)
+    {
+      setReportMap(ReportMap::bytes(), ReportMap::size());
+      setReportLen(ReportMap::input_table::len, ReportMap::output_table::len, ReportMap::feature_table::len);
+    }
+
     void setOutputReportCallback(uint8_t reportID, output_report_cb_t fp);
 
     virtual err_t begin(void);
 
     bool inputReport(uint8_t reportID, void const* data, int len);
 
+    // Host selected the boot protocol (Protocol Mode = 0), it reads the
+    // boot keyboard/mouse characteristics only
+    bool isBootProtocol(void);
+    bool bootKeyboardReport(void const* data, int len);
+    bool bootMouseReport(void const* data, int len);
+
   protected:
     uint8_t _num_input;
     uint8_t _num_output;
@@ -116,9 +142,9 @@ class BLEHidGeneric : public BLEService
     const uint8_t* _report_map;
     size_t _report_map_len;
 
-    uint16_t* _input_len;
-    uint16_t* _output_len;
-    uint16_t* _feature_len;
+    const uint16_t* _input_len;
+    const uint16_t* _output_len;
+    const uint16_t* _feature_len;
 
     output_report_cb_t* _output_cbs;
 
@@ -176,10 +202,39 @@ typedef enum {
   KEYBOARD_LED_KANA       = bit(4) ///< Kana mode
 }hid_keyboard_led_bm_t;
 
+// Set or clear a key in an NKRO report, modifier key codes (0xE0-0xE7)
+// go to the modifier byte. false if the key code can't be reported.
+static inline bool hid_nkro_set_key(hid_nkro_keyboard_report_t* report, uint8_t keycode, bool pressed)
+{
+  uint8_t* byte;
+  uint8_t  mask;
+
+  if ( keycode >= 0xE0 && keycode <= 0xE7 )
+  {
+    byte = &report->modifier;
+    mask = bit(keycode - 0xE0);
+  }
+  else if ( keycode <= HID_NKRO_KEYCODE_MAX )
+  {
+    byte = &report->keys[keycode >> 3];
+    mask = bit(keycode & 7);
+  }
+  else
+  {
+    return false;
+  }
+
+  if ( pressed ) *byte |= mask;
+  else           *byte &= ~mask;
+
+  return true;
+}
+
 //--------------------------------------------------------------------+
 // HID KEYCODE
 //--------------------------------------------------------------------+
 #define HID_KEY_NONE               0x00
+#define HID_KEY_ERROR_ROLLOVER     0x01
 #define HID_KEY_A                  0x04
 #define HID_KEY_B                  0x05
 #define HID_KEY_C                  0x06
@@ -398,6 +453,30 @@ enum {
 #define HID_USAGE_MAX(x)          HID_REPORT_ITEM(x, 2, RI_TYPE_LOCAL, 1)
 #define HID_USAGE_MAX_N(x, n)     HID_REPORT_ITEM(x, 2, RI_TYPE_LOCAL, n)
 
+//------------- N-KEY ROLLOVER KEYBOARD -------------//
+// Application collection with an input report of hid_nkro_keyboard_report_t
+#define HID_REPORT_DESC_NKRO_KEYBOARD(report_id) \
+  HID_USAGE_PAGE ( HID_USAGE_PAGE_DESKTOP     ), \
+  HID_USAGE      ( HID_USAGE_DESKTOP_KEYBOARD ), \
+  HID_COLLECTION ( HID_COLLECTION_APPLICATION ), \
+    HID_REPORT_ID ( report_id ), \
+    HID_USAGE_PAGE( HID_USAGE_PAGE_KEYBOARD ), \
+      /* 8 bits Modifier Keys */ \
+      HID_USAGE_MIN    ( 224                                    ), \
+      HID_USAGE_MAX    ( 231                                    ), \
+      HID_LOGICAL_MIN  ( 0                                      ), \
+      HID_LOGICAL_MAX  ( 1                                      ), \
+      HID_REPORT_COUNT ( 8                                      ), \
+      HID_REPORT_SIZE  ( 1                                      ), \
+      HID_INPUT        ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE ), \
+      /* a bit per key code */ \
+      HID_USAGE_MIN    ( 0                                      ), \
+      HID_USAGE_MAX    ( HID_NKRO_KEYCODE_MAX                   ), \
+      HID_REPORT_COUNT ( HID_NKRO_KEYCODE_MAX + 1               ), \
+      HID_REPORT_SIZE  ( 1                                      ), \
+      HID_INPUT        ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE ), \
+  HID_COLLECTION_END
+
 //--------------------------------------------------------------------+
 // Usage Table
 //--------------------------------------------------------------------+
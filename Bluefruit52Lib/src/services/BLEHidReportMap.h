@@ -0,0 +1,197 @@
+/**************************************************************************/
+/*!
+    @file     BLEHidReportMap.h
+    @author   hathach
+
+    @section LICENSE
+
+    Software License Agreement (BSD License)
+
+    Copyright (c) 2017, Adafruit Industries (adafruit.com)
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+    1. Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+    3. Neither the name of the copyright holders nor the
+    names of its contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ''AS IS'' AND ANY
+    EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/**************************************************************************/
+#ifndef BLEHIDREPORTMAP_H_
+#define BLEHIDREPORTMAP_H_
+
+#include "BLEHidGeneric.h"
+
+/* Report map evaluated at compile time
+ *
+ * The report map is written with the HID_* item macros of BLEHidGeneric.h
+ * into a constexpr array, BLE_HID_REPORT_MAP() then walks its items at
+ * compile time for the number of input, output and feature reports and the
+ * length of each, so the characteristics are sized from the same bytes the
+ * host parses:
+ *
+ *   constexpr uint8_t my_map[] = { HID_USAGE_PAGE(...), ... };
+ *   typedef BLE_HID_REPORT_MAP(my_map) my_map_t;
+ *
+ *   BLEHidGeneric hid(my_map_t::input_count, my_map_t::output_count, my_map_t::feature_count);
+ *   hid.setReportMap<my_map_t>();
+ *
+ * Report IDs are expected to run from 1, a map without Report ID items is
+ * report 1. Push and Pop items are not supported. A malformed map (an item
+ * running past the end) fails to compile.
+ */
+#define BLE_HID_REPORT_MAP(map)   BLEHidReportMap<map, sizeof(map)>
+
+// Item prefixes without their size bits
+#define HID_RI_TAG(prefix)        ((prefix) & 0xFC)
+#define HID_RI_LONG_ITEM          0xFE
+
+#define HID_RI_INPUT              HID_REPORT_ITEM(0, 8 , RI_TYPE_MAIN  , 0)
+#define HID_RI_OUTPUT             HID_REPORT_ITEM(0, 9 , RI_TYPE_MAIN  , 0)
+#define HID_RI_FEATURE            HID_REPORT_ITEM(0, 11, RI_TYPE_MAIN  , 0)
+#define HID_RI_REPORT_SIZE        HID_REPORT_ITEM(0, 7 , RI_TYPE_GLOBAL, 0)
+#define HID_RI_REPORT_ID          HID_REPORT_ITEM(0, 8 , RI_TYPE_GLOBAL, 0)
+#define HID_RI_REPORT_COUNT       HID_REPORT_ITEM(0, 9 , RI_TYPE_GLOBAL, 0)
+
+//--------------------------------------------------------------------+
+// Item walk (C++11 constexpr, one return statement each)
+//--------------------------------------------------------------------+
+// Data bytes of a short item
+constexpr uint8_t hid_ri_data_len(uint8_t prefix)
+{
+  return ((prefix & 3) == 3) ? 4 : (prefix & 3);
+}
+
+// Little endian item data
+constexpr uint32_t hid_ri_data(const uint8_t* data, uint8_t len)
+{
+  return len ? (data[0] | (hid_ri_data(data + 1, len - 1) << 8)) : 0;
+}
+
+// Offset of the item following the one at i
+constexpr size_t hid_ri_next(const uint8_t* map, size_t i)
+{
+  return (map[i] == HID_RI_LONG_ITEM) ? (i + 3 + map[i+1]) : (i + 1 + hid_ri_data_len(map[i]));
+}
+
+constexpr uint32_t hid_report_bits(const uint8_t* map, size_t len, uint8_t main_tag, uint8_t report_id,
+                                   size_t i = 0, uint8_t cur_id = 1, uint32_t size = 0, uint32_t count = 0);
+
+// Report Size, Count and ID are global state, a main item of the type
+// adds size * count bits to the current report
+constexpr uint32_t hid_report_bits_item(const uint8_t* map, size_t len, uint8_t main_tag, uint8_t report_id,
+                                        size_t i, uint8_t cur_id, uint32_t size, uint32_t count,
+                                        uint8_t tag, uint32_t data)
+{
+  return (tag == HID_RI_REPORT_SIZE ) ? hid_report_bits(map, len, main_tag, report_id, hid_ri_next(map, i), cur_id, data, count) :
+         (tag == HID_RI_REPORT_COUNT) ? hid_report_bits(map, len, main_tag, report_id, hid_ri_next(map, i), cur_id, size, data) :
+         (tag == HID_RI_REPORT_ID   ) ? hid_report_bits(map, len, main_tag, report_id, hid_ri_next(map, i), (uint8_t) data, size, count) :
+         (((tag == main_tag) && (cur_id == report_id)) ? size*count : 0) +
+           hid_report_bits(map, len, main_tag, report_id, hid_ri_next(map, i), cur_id, size, count);
+}
+
+// Bits of a report ID for an input, output or feature main item tag
+constexpr uint32_t hid_report_bits(const uint8_t* map, size_t len, uint8_t main_tag, uint8_t report_id,
+                                   size_t i, uint8_t cur_id, uint32_t size, uint32_t count)
+{
+  return (i >= len) ? 0 :
+         (map[i] == HID_RI_LONG_ITEM) ? hid_report_bits(map, len, main_tag, report_id, hid_ri_next(map, i), cur_id, size, count) :
+         hid_report_bits_item(map, len, main_tag, report_id, i, cur_id, size, count,
+                              HID_RI_TAG(map[i]), hid_ri_data(map + i + 1, hid_ri_data_len(map[i])));
+}
+
+// Report length in bytes, without the report ID (it is in the Report Reference)
+constexpr uint16_t hid_report_len(const uint8_t* map, size_t len, uint8_t main_tag, uint8_t report_id)
+{
+  return (uint16_t) ((hid_report_bits(map, len, main_tag, report_id) + 7) / 8);
+}
+
+// Highest report ID, 1 without Report ID items
+constexpr uint8_t hid_report_id_max(const uint8_t* map, size_t len, size_t i = 0, uint8_t id_max = 1)
+{
+  return (i >= len) ? id_max :
+         hid_report_id_max(map, len, hid_ri_next(map, i),
+                           ( (map[i] != HID_RI_LONG_ITEM) && (HID_RI_TAG(map[i]) == HID_RI_REPORT_ID) &&
+                             (hid_ri_data(map + i + 1, hid_ri_data_len(map[i])) > id_max) ) ?
+                             (uint8_t) hid_ri_data(map + i + 1, hid_ri_data_len(map[i])) : id_max);
+}
+
+// Characteristics needed for a type: the highest report ID up to report_id
+// that has a report of it, characteristics are indexed by report ID - 1
+constexpr uint8_t hid_report_count(const uint8_t* map, size_t len, uint8_t main_tag, uint8_t report_id)
+{
+  return (report_id == 0) ? 0 :
+         hid_report_bits(map, len, main_tag, report_id) ? report_id :
+         hid_report_count(map, len, main_tag, report_id - 1);
+}
+
+//--------------------------------------------------------------------+
+// Length tables
+//--------------------------------------------------------------------+
+template <uint8_t... I> struct hid_report_index { };
+
+template <uint8_t N, uint8_t... I>
+struct hid_make_report_index : hid_make_report_index<N - 1, N - 1, I...> { };
+
+template <uint8_t... I>
+struct hid_make_report_index<0, I...>
+{
+  typedef hid_report_index<I...> type;
+};
+
+template <const uint8_t* MAP, size_t LEN, uint8_t TAG, class INDEX> struct hid_report_len_table;
+
+// len[id-1] for report ID 1 up to the count, one spare entry so a type
+// without reports still has an array
+template <const uint8_t* MAP, size_t LEN, uint8_t TAG, uint8_t... I>
+struct hid_report_len_table<MAP, LEN, TAG, hid_report_index<I...> >
+{
+  static const uint16_t len[sizeof...(I) + 1];
+};
+
+template <const uint8_t* MAP, size_t LEN, uint8_t TAG, uint8_t... I>
+const uint16_t hid_report_len_table<MAP, LEN, TAG, hid_report_index<I...> >::len[sizeof...(I) + 1] =
+{
+  hid_report_len(MAP, LEN, TAG, I + 1)...
+};
+
+//--------------------------------------------------------------------+
+// Report Map
+//--------------------------------------------------------------------+
+template <const uint8_t* MAP, size_t LEN>
+struct BLEHidReportMap
+{
+  static constexpr const uint8_t* bytes(void) { return MAP; }
+  static constexpr size_t         size (void) { return LEN; }
+
+  static constexpr uint8_t id_max        = hid_report_id_max(MAP, LEN);
+  static constexpr uint8_t input_count   = hid_report_count(MAP, LEN, HID_RI_INPUT  , id_max);
+  static constexpr uint8_t output_count  = hid_report_count(MAP, LEN, HID_RI_OUTPUT , id_max);
+  static constexpr uint8_t feature_count = hid_report_count(MAP, LEN, HID_RI_FEATURE, id_max);
+
+  static constexpr uint16_t inputLen  (uint8_t id) { return hid_report_len(MAP, LEN, HID_RI_INPUT  , id); }
+  static constexpr uint16_t outputLen (uint8_t id) { return hid_report_len(MAP, LEN, HID_RI_OUTPUT , id); }
+  static constexpr uint16_t featureLen(uint8_t id) { return hid_report_len(MAP, LEN, HID_RI_FEATURE, id); }
+
+  typedef hid_report_len_table<MAP, LEN, HID_RI_INPUT  , typename hid_make_report_index<input_count  >::type> input_table;
+  typedef hid_report_len_table<MAP, LEN, HID_RI_OUTPUT , typename hid_make_report_index<output_count >::type> output_table;
+  typedef hid_report_len_table<MAP, LEN, HID_RI_FEATURE, typename hid_make_report_index<feature_count>::type> feature_table;
+};
+
+#endif /* BLEHIDREPORTMAP_H_ */
@@ -112,10 +112,32 @@ void blemidi_write_cb(BLECharacteristic& chr, uint8_t* data, uint16_t len, uint1
 /* IMPLEMENTATION
  *------------------------------------------------------------------*/
 BLEMidi::BLEMidi(uint16_t fifo_depth)
-  : BLEService(BLEMIDI_UUID_SERVICE), _io(BLEMIDI_UUID_CHR_IO), _rxd_fifo(fifo_depth, 1)
+  : BLEService(BLEMIDI_UUID_SERVICE), _io(BLEMIDI_UUID_CHR_IO), _rxd_fifo(fifo_depth, 1),
+    _decoder(_rx_sysex, sizeof(_rx_sysex))
 {
   _write_cb    = NULL;
+  _event_cb    = NULL;
+  _playout     = NULL;
   _midilib_obj = NULL;
+
+  _decoder.setEventCallback(_rx_event_cb, this);
+  _decoder.setSysexCallback(_rx_sysex_cb, this);
+
+  _tx_msg_len   = 0;
+  _tx_aggregate = true;
+  _tx_mutex     = NULL;
+  _tx_timer     = NULL;
+  _tx_len       = 0;
+  _tx_count     = 0;
+  _tx_status    = 0;
+  _tx_stamp     = 0;
+
+  _task     = NULL;
+  _task_sem = NULL;
+  _tx_due   = false;
+  _rx_due   = false;
+
+  resetTxStats();
 }
 
 bool BLEMidi::notifyEnabled(void)
@@ -128,6 +150,39 @@ void BLEMidi::setWriteCallback(midi_write_cb_t fp)
   _write_cb = fp;
 }
 
+void BLEMidi::setEventCallback(midi_event_cb_t fp)
+{
+  _event_cb = fp;
+}
+
+const BLEMidiDecoder& BLEMidi::getDecoder(void)
+{
+  return _decoder;
+}
+
+bool BLEMidi::setPlayoutLatency(uint16_t ms)
+{
+  if ( !_playout )
+  {
+    if ( !ms ) return true;
+
+    _playout = new BLEMidiPlayout();
+    VERIFY( _playout && _playout->begin() );
+    _playout->setReleaseCallback(_rx_release_cb, this);
+  }
+
+  // whatever is queued goes out now when turned off
+  if ( !ms ) _playout->flush();
+
+  _playout->setLatency(ms);
+  return true;
+}
+
+BLEMidiPlayout* BLEMidi::getPlayout(void)
+{
+  return _playout;
+}
+
 void BLEMidi::autoMIDIread(void* midi_obj)
 {
   _midilib_obj = midi_obj;
@@ -149,6 +204,18 @@ err_t BLEMidi::begin(void)
 
   VERIFY_STATUS( _io.begin() );
 
+  // Packet aggregation, the timer sends a packet held for a connection interval
+  if ( !_tx_mutex ) _tx_mutex = xSemaphoreCreateMutex();
+  if ( !_tx_timer ) _tx_timer = xTimerCreate(NULL, ms2tick(BLE_MIDI_TX_MAX_HOLD_MS), false, this, _tx_timer_cb);
+
+  // Received messages are delivered and held packets sent by our own task
+  if ( !_task_sem ) _task_sem = xSemaphoreCreateBinary();
+  VERIFY( _task_sem, NRF_ERROR_NO_MEM );
+  if ( !_task )
+  {
+    VERIFY( pdPASS == xTaskCreate(_task_entry, "MIDI", BLE_MIDI_TASK_STACKSIZE, this, TASK_PRIO_LOW, &_task), NRF_ERROR_NO_MEM );
+  }
+
   // Attempt to change the connection interval to 11.25-15 ms when starting HID
   Bluefruit.setConnInterval(9, 12);
 
@@ -161,41 +228,78 @@ err_t BLEMidi::begin(void)
 void blemidi_write_cb(BLECharacteristic& chr, uint8_t* data, uint16_t len, uint16_t offset)
 {
   (void) offset;
-  if ( len < 3 ) return;
+  // header + at least one byte, a SysEx continuation may be that short
+  if ( len < 2 ) return;
 
   BLEMidi& midi_svc = (BLEMidi&) chr.parentService();
   midi_svc._write_handler(data, len);
 }
 
-void BLEMidi::_write_handler(uint8_t* data, uint16_t len)
+void BLEMidi::_rx_event_cb(void* arg, uint16_t timestamp, const uint8_t* data, uint16_t len)
 {
-  // drop the BLE MIDI header byte
-  data++;
-  len--;
+  BLEMidi* midi_svc = (BLEMidi*) arg;
+
+  if ( midi_svc->_event_cb ) midi_svc->_event_cb(timestamp, data, len);
 
-  while (len)
+  // SysEx is already in the FIFO, written by _rx_sysex_cb as it arrived
+  if ( data[0] == 0xF0 ) return;
+
+  // scheduled, released to the FIFO by the playout timer
+  BLEMidiPlayout* playout = midi_svc->_playout;
+  if ( playout && playout->getLatency() )
   {
+    if ( (len <= 3) && playout->push(timestamp, data, len) ) return;
 
-    // timestamp low byte followed by a MIDI status,
-    // so we drop the timestamp low byte
-    if ( isStatusByte(data[0]) && isStatusByte(data[1]) )
-    {
-      data++;
-      len--;
-    }
-    // timestamp low byte on it's own (running status),
-    // so we drop the timestamp low byte
-    else if ( isStatusByte(data[0]) && ! isStatusByte(data[1]) )
-    {
-      data++;
-      len--;
-    }
+    // queue full: what is scheduled goes first to keep the order
+    playout->flush();
+  }
+
+  // whole message at once, running status expanded
+  midi_svc->_rxd_fifo.write(data, len);
+}
+
+void BLEMidi::_rx_sysex_cb(void* arg, const uint8_t* data, uint16_t len)
+{
+  BLEMidi* midi_svc = (BLEMidi*) arg;
+
+  // SysEx isn't scheduled, what is goes first to keep the order
+  if ( midi_svc->_playout ) midi_svc->_playout->flush();
+
+  midi_svc->_rxd_fifo.write(data, len);
+}
+
+void BLEMidi::_rx_release_cb(void* arg, const uint8_t* data, uint16_t len)
+{
+  BLEMidi* midi_svc = (BLEMidi*) arg;
+
+  // runs in the playout timer, the task reads it
+  midi_svc->_rxd_fifo.write(data, len);
+  midi_svc->_rx_signal();
+}
+
+void BLEMidi::_write_handler(uint8_t* data, uint16_t len)
+{
+  // completed messages go to the FIFO (or playout queue) as the decoder finds them
+  _decoder.decode(data, len);
 
-    // write the status or MIDI data to the FIFO
-    _rxd_fifo.write(data++, 1);
-    len--;
+  if ( _rxd_fifo.count() ) _rx_signal();
+}
+
+void BLEMidi::_rx_signal(void)
+{
+  // before begin() there is no task, deliver here
+  if ( !_task )
+  {
+    _rx_deliver();
+    return;
   }
 
+  _rx_due = true;
+  xSemaphoreGive(_task_sem);
+}
+
+void BLEMidi::_rx_deliver(void)
+{
   // Call write callback if configured
   if ( _write_cb ) _write_cb();
 
@@ -224,56 +328,55 @@ size_t BLEMidi::write ( uint8_t b )
   // MIDI Library will write event byte by byte.
   // We need to buffer the data until we have a full event,
   // or until we reach the TX buffer limit.
-  static uint8_t count = 0;
-  static uint8_t buf[BLE_MIDI_TX_BUFFER_SIZE] = { 0 };
+  uint8_t* buf = _tx_msg;
 
   // the current byte is a sysex end status message,
   // and we still have an existing buffer. send the
   // existing buffer and clear it so we can send
   // the sysex end status message with the appropriate
   // BLE header and timestamp bytes.
-  if(b == 0xF7 && count > 0)
+  if(b == 0xF7 && _tx_msg_len > 0)
   {
     // send and clear the last of the existing buffer.
     // it should contain the final bytes in the sysex payload.
     if (isStatusByte(buf[0]))
-      send(buf, count);
+      send(buf, _tx_msg_len);
     else
-      sendSplit(buf, count);
+      sendSplit(buf, _tx_msg_len);
 
     // reset buffer
     buf[0] = 0;
-    count = 0;
+    _tx_msg_len = 0;
   }
 
   // add the current byte to the buffer
-  buf[count++] = b;
+  buf[_tx_msg_len++] = b;
 
   // send matching 1, 2, or 3 byte messages
   // and clear the buffer
-  if ( (oneByteMessage(buf[0]) && count == 1) ||
-       (twoByteMessage(buf[0]) && count == 2) ||
-       (threeByteMessage(buf[0]) && count == 3) )
+  if ( (oneByteMessage(buf[0]) && _tx_msg_len == 1) ||
+       (twoByteMessage(buf[0]) && _tx_msg_len == 2) ||
+       (threeByteMessage(buf[0]) && _tx_msg_len == 3) )
   {
-    send(buf, count);
+    send(buf, _tx_msg_len);
     // reset buffer
     buf[0] = 0;
-    count = 0;
+    _tx_msg_len = 0;
   }
 
   // do we have a full buffer at this point?
-  if(count == BLE_MIDI_TX_BUFFER_SIZE)
+  if(_tx_msg_len == BLE_MIDI_TX_BUFFER_SIZE)
   {
     // send a full or split message depending
     // on the type of the first byte in the buffer
     if (isStatusByte(buf[0]))
-      send(buf, count);
+      send(buf, _tx_msg_len);
     else
-      sendSplit(buf, count);
+      sendSplit(buf, _tx_msg_len);
 
     // reset buffer
     buf[0] = 0;
-    count = 0;
+    _tx_msg_len = 0;
   }
 
   return 1;
@@ -350,6 +453,21 @@ bool BLEMidi::threeByteMessage( uint8_t status )
 /* Send Event (notify)
  *------------------------------------------------------------------*/
 bool BLEMidi::send(uint8_t data[], uint8_t len)
+{
+  // SysEx goes out as before (start, split continuations, end),
+  // anything still pending is sent first to keep the order
+  bool const sysex = (data[0] == 0xF0) || (data[0] == 0xF7);
+
+  if ( _tx_aggregate && _tx_mutex && !sysex && (len <= BLE_MIDI_TX_BUFFER_SIZE) )
+  {
+    return _tx_append(data, len);
+  }
+
+  flushTx();
+  return _send_now(data, len);
+}
+
+bool BLEMidi::_send_now(uint8_t data[], uint8_t len)
 {
   uint32_t tstamp = millis();
 
@@ -368,12 +486,16 @@ bool BLEMidi::send(uint8_t data[], uint8_t len)
 
   memcpy(event.data, data, len);
 
+  _tx_account(1, 0, 0, 0);
+
   // send data length + 1 byte for header + 1 byte for timestamp
   return _io.notify(&event, len + 2);
 }
 
 bool BLEMidi::sendSplit(uint8_t data[], uint8_t len)
 {
+  flushTx();
+
   uint32_t tstamp = millis();
 
   midi_split_packet_t event =
@@ -390,3 +512,219 @@ bool BLEMidi::sendSplit(uint8_t data[], uint8_t len)
   // don't include the second timestamp byte
   return _io.notify(&event, len + 1);
 }
+
+void BLEMidi::printRxStats(Print& p)
+{
+  p.print("MIDI rx packets=");
+  p.print(_decoder.packets());
+  p.print(" events=");
+  p.print(_decoder.events());
+  p.print(" errors=");
+  p.print(_decoder.errors());
+  p.print(" sysex_dropped=");
+  p.println(_decoder.sysexDropped());
+
+  if ( _playout ) _playout->printStats(p);
+}
+
+/*------------------------------------------------------------------*/
+/* Packet Aggregation
+ *------------------------------------------------------------------*/
+void BLEMidi::setAggregation(bool enabled)
+{
+  if ( !enabled ) flushTx();
+  _tx_aggregate = enabled;
+}
+
+bool BLEMidi::_tx_append(uint8_t data[], uint8_t len)
+{
+  bool result = true;
+
+  xSemaphoreTake(_tx_mutex, portMAX_DELAY);
+
+  uint32_t const ms = millis();
+  uint32_t const us = micros();
+  uint8_t const status = data[0];
+
+  uint8_t stamp  = (uint8_t) (0x80 | (ms & 0x7FUL));
+  bool running   = (status == _tx_status);
+  uint8_t needed = (running ? len - 1 : len) + ((running && stamp == _tx_stamp) ? 0 : 1);
+
+  // Send what we have if this message doesn't fit, or if its timestamp-low
+  // would wrap past the packet's first one (receivers assume one wrap)
+  if ( _tx_len && ( (_tx_len + needed > BLE_MIDI_TX_PACKET_SIZE) || (ms - _tx_first_ms > 0x7F) ) )
+  {
+    result = _tx_send_locked();
+
+    running = false;
+    needed  = len + 1;
+  }
+
+  if ( !_tx_len )
+  {
+    midi_header_t header;
+    header.byte         = 0;
+    header.timestamp_hi = (uint8_t) ((ms & 0x1F80UL) >> 7);
+    header.start_bit    = 1;
+
+    _tx_buf[_tx_len++] = header.byte;
+    _tx_first_ms  = ms;
+    _tx_first_us  = us;
+    _tx_offset_us = 0;
+
+    // hold it for a connection interval at most
+    uint32_t hold_ms = MS125TO100(Bluefruit.connInterval());
+    if ( !hold_ms || hold_ms > BLE_MIDI_TX_MAX_HOLD_MS ) hold_ms = BLE_MIDI_TX_MAX_HOLD_MS;
+
+    TickType_t ticks = ms2tick(hold_ms);
+    xTimerChangePeriod(_tx_timer, ticks ? ticks : 1, 0);
+  }
+
+  // a running status message with the previous timestamp is just its data bytes
+  if ( needed > (running ? len - 1 : len) )
+  {
+    _tx_buf[_tx_len++] = stamp;
+  }
+
+  if ( running )
+  {
+    memcpy(_tx_buf + _tx_len, data + 1, len - 1);
+    _tx_len += len - 1;
+  }else
+  {
+    memcpy(_tx_buf + _tx_len, data, len);
+    _tx_len += len;
+  }
+
+  _tx_offset_us += us - _tx_first_us;
+  _tx_last_us    = us;
+  _tx_count++;
+
+  if ( status < 0xF0 )
+  {
+    // channel message, may be followed by running status
+    _tx_status = status;
+    _tx_stamp  = stamp;
+  }else
+  {
+    // system common messages cancel running status, real-time ones don't.
+    // Either way the next message carries its timestamp again.
+    if ( status < 0xF8 ) _tx_status = 0;
+    _tx_stamp = 0;
+  }
+
+  xSemaphoreGive(_tx_mutex);
+
+  return result;
+}
+
+// mutex must be held
+bool BLEMidi::_tx_send_locked(void)
+{
+  if ( !_tx_len ) return true;
+
+  xTimerStop(_tx_timer, 0);
+
+  uint32_t const now = micros();
+  bool const result  = _io.notify(_tx_buf, _tx_len);
+
+  _tx_account(_tx_count, now - _tx_first_us, now - _tx_last_us,
+              (uint64_t) _tx_count * (now - _tx_first_us) - _tx_offset_us);
+
+  _tx_len    = 0;
+  _tx_count  = 0;
+  _tx_status = 0;
+  _tx_stamp  = 0;
+
+  return result;
+}
+
+bool BLEMidi::flushTx(void)
+{
+  if ( !_tx_mutex ) return true;
+
+  xSemaphoreTake(_tx_mutex, portMAX_DELAY);
+  bool const result = _tx_send_locked();
+  xSemaphoreGive(_tx_mutex);
+
+  return result;
+}
+
+void BLEMidi::_tx_timer_cb(TimerHandle_t timer)
+{
+  BLEMidi* midi_svc = (BLEMidi*) pvTimerGetTimerID(timer);
+
+  // not in the timer task: notify() may wait for the SoftDevice
+  midi_svc->_tx_due = true;
+  xSemaphoreGive(midi_svc->_task_sem);
+}
+
+void BLEMidi::_task_entry(void* arg)
+{
+  ((BLEMidi*) arg)->_task_run();
+}
+
+void BLEMidi::_task_run(void)
+{
+  while(1)
+  {
+    xSemaphoreTake(_task_sem, portMAX_DELAY);
+
+    // flags are cleared first, a signal arriving meanwhile runs us again
+    if ( _tx_due )
+    {
+      _tx_due = false;
+      flushTx();
+    }
+
+    if ( _rx_due )
+    {
+      _rx_due = false;
+      _rx_deliver();
+    }
+  }
+}
+
+/*------------------------------------------------------------------*/
+/* Statistics
+ *------------------------------------------------------------------*/
+void BLEMidi::_tx_account(uint8_t count, uint32_t first_hold, uint32_t last_hold, uint64_t sum_hold)
+{
+  // the first message of a packet waited longest, the last one shortest
+  if ( _tx_stats.messages == 0 || last_hold  < _tx_stats.hold_min_us ) _tx_stats.hold_min_us = last_hold;
+  if ( first_hold > _tx_stats.hold_max_us ) _tx_stats.hold_max_us = first_hold;
+
+  _tx_stats.hold_sum_us += sum_hold;
+  _tx_stats.messages    += count;
+  _tx_stats.packets++;
+}
+
+const midi_tx_stats_t& BLEMidi::getTxStats(void)
+{
+  return _tx_stats;
+}
+
+void BLEMidi::resetTxStats(void)
+{
+  varclr(&_tx_stats);
+}
+
+void BLEMidi::printTxStats(Print& p)
+{
+  midi_tx_stats_t const st = _tx_stats;
+
+  p.print("MIDI tx packets=");
+  p.print(st.packets);
+  p.print(" msgs=");
+  p.print(st.messages);
+  p.print(" per_pkt=");
+  p.print(st.packets ? (float) st.messages / st.packets : 0.0f, 2);
+  p.print(" hold_us min=");
+  p.print(st.hold_min_us);
+  p.print(" avg=");
+  p.print(st.messages ? (uint32_t) (st.hold_sum_us / st.messages) : 0);
+  p.print(" max=");
+  p.print(st.hold_max_us);
+  p.print(" jitter=");
+  p.println(st.hold_max_us - st.hold_min_us);
+}
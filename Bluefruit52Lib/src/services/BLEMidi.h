@@ -37,6 +37,8 @@
 
 #include "bluefruit_common.h"
 #include "utility/adafruit_fifo.h"
+#include "utility/BLEMidiDecoder.h"
+#include "utility/BLEMidiPlayout.h"
 
 #include "BLECharacteristic.h"
 #include "BLEService.h"
@@ -45,14 +47,34 @@
 
 #define BLE_MIDI_DEFAULT_FIFO_DEPTH   128
 #define BLE_MIDI_TX_BUFFER_SIZE       3
+#define BLE_MIDI_RX_SYSEX_SIZE        128   // whole SysEx for the event callback, longer ones only reach the FIFO
+#define BLE_MIDI_TASK_STACKSIZE       512   // write callback and MIDI library handlers run on it
+
+// Outgoing messages are packed into one notification per connection
+// interval: header, then timestamp-low byte + message for each, running
+// status elided within the packet.  A packet is sent when the next message
+// would not fit, when it has been held for a connection interval, or when
+// its timestamps would span more than the 7 bit timestamp-low range.
+#define BLE_MIDI_TX_PACKET_SIZE       (GATT_MTU_SIZE_DEFAULT - 3)
+#define BLE_MIDI_TX_MAX_HOLD_MS       100
 
 extern const uint8_t BLEMIDI_UUID_SERVICE[];
 extern const uint8_t BLEMIDI_UUID_CHR_IO[];
 
+typedef struct
+{
+  uint32_t packets;         // notifications sent
+  uint32_t messages;        // MIDI messages in them
+  uint32_t hold_min_us;     // time a message waited for its packet
+  uint32_t hold_max_us;
+  uint64_t hold_sum_us;
+} midi_tx_stats_t;
+
 class BLEMidi: public BLEService, public Stream
 {
   public:
     typedef void (*midi_write_cb_t) (void);
+    typedef void (*midi_event_cb_t) (uint16_t timestamp, const uint8_t* data, uint16_t len);
 
     BLEMidi(uint16_t fifo_depth = BLE_MIDI_DEFAULT_FIFO_DEPTH);
 
@@ -63,6 +85,19 @@ class BLEMidi: public BLEService, public Stream
     bool send(uint8_t data[], uint8_t len);
     bool sendSplit(uint8_t data[], uint8_t len);
 
+    // Aggregation of outgoing messages, enabled by default. When disabled
+    // every message is sent in a notification of its own.
+    void setAggregation(bool enabled);
+    bool flushTx(void); // send the pending packet now
+
+    // Sender side statistics: messages per packet and how long messages
+    // were held before their packet went out. The hold spread (jitter) is
+    // what a receiver sees in arrival times; one that plays by the packet
+    // timestamps is left with their 1 ms resolution.
+    const midi_tx_stats_t& getTxStats(void);
+    void resetTxStats(void);
+    void printTxStats(Print& p);
+
     // message type helpers
     bool isStatusByte(uint8_t b);
     bool oneByteMessage(uint8_t status);
@@ -70,6 +105,20 @@ class BLEMidi: public BLEService, public Stream
     bool threeByteMessage(uint8_t status);
 
     void setWriteCallback(midi_write_cb_t fp);
+
+    // Every received message (or whole SysEx up to BLE_MIDI_RX_SYSEX_SIZE
+    // bytes, longer ones only reach the Stream API) with the sender's 13 bit
+    // millisecond timestamp, called before it is read from the Stream API
+    void setEventCallback(midi_event_cb_t fp);
+    const BLEMidiDecoder& getDecoder(void);
+    void printRxStats(Print& p);
+
+    // Play received messages at the sender's timing, ms behind it (see
+    // BLEMidiPlayout). 0, the default, passes them on as they arrive.
+    // SysEx, and messages the queue has no room for, are passed on as
+    // they arrive, after everything already scheduled.
+    bool setPlayoutLatency(uint16_t ms);
+    BLEMidiPlayout* getPlayout(void); // NULL if never enabled
     void autoMIDIread(void* midi_obj);
 
     // Stream API for MIDI Interface
@@ -86,11 +135,59 @@ class BLEMidi: public BLEService, public Stream
 
     Adafruit_FIFO     _rxd_fifo;
     midi_write_cb_t   _write_cb;
+    midi_event_cb_t   _event_cb;
+
+    uint8_t           _rx_sysex[BLE_MIDI_RX_SYSEX_SIZE];
+    BLEMidiDecoder    _decoder;
+    BLEMidiPlayout*   _playout;
 
     void* _midilib_obj;
 
+    // message being assembled by write()
+    uint8_t           _tx_msg[BLE_MIDI_TX_BUFFER_SIZE];
+    uint8_t           _tx_msg_len;
+
+    // packet being aggregated by send()
+    bool              _tx_aggregate;
+    SemaphoreHandle_t _tx_mutex;
+    TimerHandle_t     _tx_timer;
+    uint8_t           _tx_buf[BLE_MIDI_TX_PACKET_SIZE];
+    uint8_t           _tx_len;
+    uint8_t           _tx_count;
+    uint8_t           _tx_status;   // running status, 0 if none
+    uint8_t           _tx_stamp;    // last timestamp-low byte, 0 if none
+    uint32_t          _tx_first_ms;
+    uint32_t          _tx_first_us;
+    uint32_t          _tx_last_us;
+    uint32_t          _tx_offset_us; // sum of arrivals after the first
+
+    midi_tx_stats_t   _tx_stats;
+
+    // the task delivers received messages and sends the packets the timer
+    // found due, timer callbacks only signal it
+    TaskHandle_t      _task;
+    SemaphoreHandle_t _task_sem;
+    volatile bool     _tx_due;
+    volatile bool     _rx_due;
+
+    bool _send_now(uint8_t data[], uint8_t len);
+    bool _tx_append(uint8_t data[], uint8_t len);
+    bool _tx_send_locked(void);
+    void _tx_account(uint8_t count, uint32_t first_hold, uint32_t last_hold, uint64_t sum_hold);
+
     void _write_handler(uint8_t* data, uint16_t len);
 
+    static void _tx_timer_cb(TimerHandle_t timer);
+    void _rx_deliver(void);
+    void _rx_signal(void);
+    void _task_run(void);
+
+    static void _task_entry(void* arg);
+
+    static void _rx_event_cb(void* arg, uint16_t timestamp, const uint8_t* data, uint16_t len);
+    static void _rx_release_cb(void* arg, const uint8_t* data, uint16_t len);
+    static void _rx_sysex_cb(void* arg, const uint8_t* data, uint16_t len);
+
     friend void blemidi_write_cb(BLECharacteristic& chr, uint8_t* data, uint16_t len, uint16_t offset);
 };
 
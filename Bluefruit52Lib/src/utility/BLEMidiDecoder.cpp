@@ -0,0 +1,328 @@
+/**************************************************************************/
+/*!
+    @file     BLEMidiDecoder.cpp
+    @author   hathach
+
+    @section LICENSE
+
+    Software License Agreement (BSD License)
+
+    Copyright (c) 2017, Adafruit Industries (adafruit.com)
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+    1. Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+    3. Neither the name of the copyright holders nor the
+    names of its contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ''AS IS'' AND ANY
+    EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "BLEMidiDecoder.h"
+
+BLEMidiDecoder::BLEMidiDecoder(uint8_t* sysex_buf, uint16_t sysex_size)
+{
+  _sysex_buf  = sysex_buf;
+  _sysex_size = sysex_size;
+
+  _cb     = NULL;
+  _cb_arg = NULL;
+
+  _sysex_cb  = NULL;
+  _sysex_arg = NULL;
+
+  reset();
+  resetStats();
+}
+
+void BLEMidiDecoder::setEventCallback(event_cb_t fp, void* arg)
+{
+  _cb     = fp;
+  _cb_arg = arg;
+}
+
+void BLEMidiDecoder::setSysexCallback(sysex_cb_t fp, void* arg)
+{
+  _sysex_cb  = fp;
+  _sysex_arg = arg;
+}
+
+void BLEMidiDecoder::reset(void)
+{
+  _in_sysex  = false;
+  _run_len   = 0;
+  _sysex_len = 0;
+  _sysex_ts  = 0;
+  _running   = 0;
+  _msg_len   = 0;
+  _msg_need  = 0;
+  _msg_ts    = 0;
+}
+
+void BLEMidiDecoder::resetStats(void)
+{
+  _packets = _events = _errors = _sysex_dropped = 0;
+}
+
+// message length including the status byte
+uint8_t BLEMidiDecoder::_message_len(uint8_t status)
+{
+  if ( status < 0xC0 ) return 3;                     // note off/on, poly aftertouch, control change
+  if ( status < 0xE0 ) return 2;                     // program change, channel aftertouch
+  if ( status < 0xF0 ) return 3;                     // pitch bend
+  if ( status == 0xF1 || status == 0xF3 ) return 2;  // time code quarter frame, song select
+  if ( status == 0xF2 ) return 3;                    // song position
+
+  return 1;
+}
+
+uint16_t BLEMidiDecoder::decode(const uint8_t* packet, uint16_t len)
+{
+  _emitted = 0;
+  _packets++;
+
+  // header: bit 7 set, bit 6 reserved (0), then at least one more byte
+  if ( len < 2 || (packet[0] & 0xC0) != 0x80 )
+  {
+    _errors++;
+    return 0;
+  }
+
+  uint8_t  ts_high  = packet[0] & 0x3F;
+  int16_t  ts_low   = -1;      // none seen in this packet yet
+  uint16_t ts       = 0;
+  bool     stamped  = false;   // the last byte was a timestamp
+  bool     skipping = false;   // resync at the next timestamp
+
+  uint16_t i = 1;
+
+  // a SysEx from a previous packet continues right after the header
+  if ( _in_sysex )
+  {
+    while ( i < len && !(packet[i] & 0x80) ) _data(packet[i++]);
+  }
+
+  for ( ; i < len; i++ )
+  {
+    uint8_t const b = packet[i];
+
+    if ( stamped )
+    {
+      stamped = false;
+
+      if ( b & 0x80 )
+      {
+        _status(b, ts);
+      }else
+      {
+        // running status with a new timestamp
+        _msg_ts  = ts;
+        skipping = !_data(b);
+      }
+    }
+    else if ( b & 0x80 )
+    {
+      // timestamp-low, the next byte is a status or running status data
+      if ( ts_low >= 0 && (b & 0x7F) < ts_low ) ts_high = (ts_high + 1) & 0x3F;
+      ts_low = b & 0x7F;
+      ts     = (ts_high << 7) | ts_low;
+
+      stamped  = true;
+      skipping = false;
+    }
+    else if ( skipping )
+    {
+      // dropped with the malformed message
+    }
+    else if ( ts_low < 0 )
+    {
+      // data before any timestamp
+      _errors++;
+      skipping = true;
+    }
+    else
+    {
+      // running status without a timestamp, same time as the previous one
+      skipping = !_data(b);
+    }
+  }
+
+  // the SysEx bytes of this packet don't wait for the next one
+  _run_flush();
+
+  // trailing timestamp without a message
+  if ( stamped ) _errors++;
+
+  // only SysEx may continue in the next packet
+  if ( _msg_len )
+  {
+    _errors++;
+    _msg_len = 0;
+  }
+
+  return _emitted;
+}
+
+void BLEMidiDecoder::_status(uint8_t status, uint16_t ts)
+{
+  // real-time messages may appear anywhere, even inside a SysEx
+  if ( status >= 0xF8 )
+  {
+    // after the SysEx bytes before it
+    _run_flush();
+    _emit(ts, &status, 1);
+    return;
+  }
+
+  if ( _in_sysex )
+  {
+    if ( status == 0xF7 )
+    {
+      _in_sysex = false;
+
+      _run_add(status);
+      _run_flush();
+
+      if ( _sysex_len < _sysex_size )
+      {
+        _sysex_buf[_sysex_len++] = status;
+        _emit(_sysex_ts, _sysex_buf, _sysex_len);
+      }else
+      {
+        _sysex_dropped++;
+      }
+      return;
+    }
+
+    // any other status ends it unfinished
+    _errors++;
+    _sysex_abort();
+  }
+
+  // the previous message lacks data bytes
+  if ( _msg_len )
+  {
+    _errors++;
+    _msg_len = 0;
+  }
+
+  if ( status == 0xF0 )
+  {
+    _running   = 0;
+    _in_sysex  = true;
+    _sysex_ts  = ts;
+    _sysex_len = 0;
+
+    if ( _sysex_size ) _sysex_buf[_sysex_len++] = status;
+    _run_add(status);
+    return;
+  }
+
+  if ( status == 0xF7 )
+  {
+    // end without a start
+    _errors++;
+    _running = 0;
+    return;
+  }
+
+  // channel messages set running status, system common ones cancel it
+  _running = (status < 0xF0) ? status : 0;
+
+  _msg[0]   = status;
+  _msg_len  = 1;
+  _msg_need = _message_len(status);
+  _msg_ts   = ts;
+
+  if ( _msg_need == 1 )
+  {
+    _emit(ts, _msg, 1);
+    _msg_len = 0;
+  }
+}
+
+// false if there is no status for the data byte
+bool BLEMidiDecoder::_data(uint8_t data)
+{
+  if ( _in_sysex )
+  {
+    _run_add(data);
+
+    // keep counting past the end so the overflow is noticed at F7
+    if ( _sysex_len < _sysex_size ) _sysex_buf[_sysex_len] = data;
+    if ( _sysex_len < 0xFFFF ) _sysex_len++;
+    return true;
+  }
+
+  if ( !_msg_len )
+  {
+    if ( !_running )
+    {
+      _errors++;
+      return false;
+    }
+
+    _msg[0]   = _running;
+    _msg_len  = 1;
+    _msg_need = _message_len(_running);
+  }
+
+  _msg[_msg_len++] = data;
+
+  if ( _msg_len == _msg_need )
+  {
+    _emit(_msg_ts, _msg, _msg_len);
+    _msg_len = 0;
+  }
+
+  return true;
+}
+
+void BLEMidiDecoder::_sysex_abort(void)
+{
+  // what was streamed stays streamed, the next status resyncs the reader
+  _run_flush();
+
+  _in_sysex  = false;
+  _sysex_len = 0;
+  _sysex_dropped++;
+}
+
+void BLEMidiDecoder::_run_add(uint8_t b)
+{
+  if ( !_sysex_cb ) return;
+
+  _run[_run_len++] = b;
+  if ( _run_len == sizeof(_run) ) _run_flush();
+}
+
+void BLEMidiDecoder::_run_flush(void)
+{
+  if ( !_run_len ) return;
+
+  _sysex_cb(_sysex_arg, _run, _run_len);
+  _run_len = 0;
+}
+
+void BLEMidiDecoder::_emit(uint16_t ts, const uint8_t* data, uint16_t len)
+{
+  _events++;
+  _emitted++;
+
+  if ( _cb ) _cb(_cb_arg, ts, data, len);
+}
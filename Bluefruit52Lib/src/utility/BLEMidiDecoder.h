@@ -0,0 +1,119 @@
+/**************************************************************************/
+/*!
+    @file     BLEMidiDecoder.h
+    @author   hathach
+
+    @section LICENSE
+
+    Software License Agreement (BSD License)
+
+    Copyright (c) 2017, Adafruit Industries (adafruit.com)
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+    1. Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+    3. Neither the name of the copyright holders nor the
+    names of its contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ''AS IS'' AND ANY
+    EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef BLEMIDIDECODER_H_
+#define BLEMIDIDECODER_H_
+
+#include "Arduino.h"
+
+#define BLE_MIDI_DECODER_SYSEX_RUN    16    // SysEx bytes passed to the SysEx callback at once
+
+/* Incremental decoder for BLE MIDI packets (BLE MIDI 1.0):
+ *
+ *   header  | ts-low status data.. | [ts-low] data.. (running status) | ...
+ *
+ * The header carries the upper 6 bits of the sender's 13 bit millisecond
+ * timestamp, each timestamp-low byte the lower 7. A timestamp-low smaller
+ * than the previous one in the packet means the upper bits went up by one.
+ *
+ * Events are complete messages with their status byte (running status is
+ * expanded) or a whole SysEx from F0 to F7, which may span packets. Real-time
+ * messages inside a SysEx are passed on as they come. The SysEx callback gets
+ * the SysEx bytes (F0 to F7) in order as they are decoded, whatever their
+ * length, the event callback only SysEx that fit sysex_buf. Running status is kept
+ * across packets. Malformed input is counted and skipped up to the next
+ * timestamp, it never stalls the decoder.
+ */
+class BLEMidiDecoder
+{
+  public:
+    typedef void (*event_cb_t) (void* arg, uint16_t timestamp, const uint8_t* data, uint16_t len);
+    typedef void (*sysex_cb_t) (void* arg, const uint8_t* data, uint16_t len);
+
+    // sysex_buf holds a SysEx until its F7 for the event callback, longer
+    // ones only reach the SysEx callback
+    BLEMidiDecoder(uint8_t* sysex_buf, uint16_t sysex_size);
+
+    void setEventCallback(event_cb_t fp, void* arg);
+    void setSysexCallback(sysex_cb_t fp, void* arg);
+    void reset(void);
+
+    // decode one packet, returns the number of events it completed
+    uint16_t decode(const uint8_t* packet, uint16_t len);
+
+    uint32_t packets(void) const { return _packets; }
+    uint32_t events (void) const { return _events;  }
+    uint32_t errors (void) const { return _errors;  } // malformed packets or messages
+    uint32_t sysexDropped(void) const { return _sysex_dropped; } // too long for the event callback, or aborted
+    void     resetStats(void);
+
+  private:
+    uint8_t*   _sysex_buf;
+    uint16_t   _sysex_size;
+    uint16_t   _sysex_len;
+    uint16_t   _sysex_ts;
+    bool       _in_sysex;
+
+    uint8_t    _running;     // running status, 0 if none
+    uint8_t    _msg[3];      // message being completed
+    uint8_t    _msg_len;
+    uint8_t    _msg_need;
+    uint16_t   _msg_ts;
+
+    event_cb_t _cb;
+    void*      _cb_arg;
+
+    sysex_cb_t _sysex_cb;
+    void*      _sysex_arg;
+    uint8_t    _run[BLE_MIDI_DECODER_SYSEX_RUN];  // SysEx bytes not passed to _sysex_cb yet
+    uint8_t    _run_len;
+
+    uint32_t   _packets;
+    uint32_t   _events;
+    uint32_t   _errors;
+    uint32_t   _sysex_dropped;
+
+    uint16_t   _emitted;     // events completed by the current decode()
+
+    void _status(uint8_t status, uint16_t ts);
+    bool _data  (uint8_t data);
+    void _emit  (uint16_t ts, const uint8_t* data, uint16_t len);
+    void _sysex_abort(void);
+    void _run_add(uint8_t b);
+    void _run_flush(void);
+
+    static uint8_t _message_len(uint8_t status);
+};
+
+#endif /* BLEMIDIDECODER_H_ */
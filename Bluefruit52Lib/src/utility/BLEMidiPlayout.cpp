@@ -0,0 +1,278 @@
+/**************************************************************************/
+/*!
+    @file     BLEMidiPlayout.cpp
+    @author   hathach
+
+    @section LICENSE
+
+    Software License Agreement (BSD License)
+
+    Copyright (c) 2017, Adafruit Industries (adafruit.com)
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+    1. Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+    3. Neither the name of the copyright holders nor the
+    names of its contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ''AS IS'' AND ANY
+    EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "BLEMidiPlayout.h"
+
+BLEMidiPlayout::BLEMidiPlayout(void)
+{
+  _queue = NULL;
+  _depth = _head = _count = 0;
+
+  _mutex = NULL;
+  _timer = NULL;
+
+  _release_cb  = NULL;
+  _release_arg = NULL;
+
+  _latency_us = 0;
+  _synced     = false;
+
+  _have_arrival = _have_release = false;
+
+  resetStats();
+}
+
+bool BLEMidiPlayout::begin(uint16_t depth)
+{
+  if ( _queue ) return true;
+
+  _queue = new entry_t[depth];
+  _mutex = xSemaphoreCreateMutex();
+  _timer = xTimerCreate(NULL, 1, false, this, _timer_cb);
+  VERIFY( _queue && _mutex && _timer );
+
+  _depth = depth;
+  return true;
+}
+
+void BLEMidiPlayout::setReleaseCallback(release_cb_t fp, void* arg)
+{
+  _release_cb  = fp;
+  _release_arg = arg;
+}
+
+void BLEMidiPlayout::setLatency(uint16_t ms)
+{
+  _latency_us = ms * 1000UL;
+}
+
+uint16_t BLEMidiPlayout::getLatency(void)
+{
+  return _latency_us / 1000;
+}
+
+bool BLEMidiPlayout::push(uint16_t timestamp, const uint8_t* data, uint8_t len)
+{
+  VERIFY( _queue && len <= 3 );
+
+  xSemaphoreTake(_mutex, portMAX_DELAY);
+
+  uint32_t const now = micros();
+
+  if ( _synced && (now - _last_arrival_us < BLE_MIDI_PLAYOUT_RESYNC_MS * 1000UL) )
+  {
+    // timestamps are 13 bit, take the nearer way around
+    int16_t delta = (timestamp - _last_ts) & 0x1FFF;
+    if ( delta >= 0x1000 ) delta -= 0x2000;
+
+    _sender_ms += delta;
+  }else
+  {
+    _synced          = true;
+    _sender_ms       = timestamp;
+    _offset_us       = _next_offset_us = now - _sender_ms * 1000UL;
+    _window_start_us = now;
+    _have_arrival    = _have_release = false;
+  }
+
+  _last_ts         = timestamp;
+  _last_arrival_us = now;
+
+  // the event with the least delay so far sets the offset
+  uint32_t const transit = now - _sender_ms * 1000UL;
+
+  if ( (int32_t) (transit - _offset_us)      < 0 ) _offset_us      = transit;
+  if ( (int32_t) (transit - _next_offset_us) < 0 ) _next_offset_us = transit;
+
+  if ( now - _window_start_us >= BLE_MIDI_PLAYOUT_WINDOW_MS * 1000UL )
+  {
+    _offset_us       = _next_offset_us;
+    _next_offset_us  = transit;
+    _window_start_us = now;
+  }
+
+  // arrival jitter: change of transit time from the previous event
+  if ( _have_arrival )
+  {
+    int32_t d = (int32_t) (transit - _prev_transit_us);
+    uint32_t const jitter = (d < 0) ? -d : d;
+
+    if ( jitter > _stats.arrival_jitter_max_us ) _stats.arrival_jitter_max_us = jitter;
+    _stats.arrival_jitter_sum_us += jitter;
+    _stats.intervals++;
+  }
+  _have_arrival    = true;
+  _prev_transit_us = transit;
+
+  bool const full = (_count == _depth);
+
+  if ( full )
+  {
+    _stats.overflows++;
+  }else
+  {
+    entry_t* e = &_queue[(_head + _count) % _depth];
+    e->due_us = _sender_ms * 1000UL + _offset_us + _latency_us;
+    e->len    = len;
+    memcpy(e->data, data, len);
+
+    _count++;
+  }
+
+  xSemaphoreGive(_mutex);
+
+  // due already (no budget, or it came late): release it from here
+  service();
+
+  return !full;
+}
+
+// take the oldest event if it is due (or any when all is set), mutex held
+bool BLEMidiPlayout::_pop(entry_t* entry, bool all)
+{
+  if ( !_count ) return false;
+  if ( !all && (int32_t) (_queue[_head].due_us - micros()) > BLE_MIDI_PLAYOUT_SLACK_US ) return false;
+
+  *entry = _queue[_head];
+  _head  = (_head + 1) % _depth;
+  _count--;
+
+  return true;
+}
+
+void BLEMidiPlayout::_release(const entry_t* entry, uint32_t now)
+{
+  int32_t const lateness = (int32_t) (now - entry->due_us);
+
+  if ( lateness > 1000 ) _stats.late++;
+
+  // release jitter: change of lateness from the previous event
+  if ( _have_release )
+  {
+    int32_t d = lateness - _prev_lateness_us;
+    uint32_t const jitter = (d < 0) ? -d : d;
+
+    if ( jitter > _stats.playout_jitter_max_us ) _stats.playout_jitter_max_us = jitter;
+    _stats.playout_jitter_sum_us += jitter;
+  }
+  _have_release     = true;
+  _prev_lateness_us = lateness;
+
+  _stats.events++;
+
+  if ( _release_cb ) _release_cb(_release_arg, entry->data, entry->len);
+}
+
+void BLEMidiPlayout::service(void)
+{
+  if ( !_queue ) return;
+
+  // the lock is kept while releasing so that the timer and push()
+  // can't hand out events out of order
+  xSemaphoreTake(_mutex, portMAX_DELAY);
+
+  entry_t entry;
+  while ( _pop(&entry, false) ) _release(&entry, micros());
+
+  _arm();
+
+  xSemaphoreGive(_mutex);
+}
+
+void BLEMidiPlayout::flush(void)
+{
+  if ( !_queue ) return;
+
+  xSemaphoreTake(_mutex, portMAX_DELAY);
+
+  entry_t entry;
+  while ( _pop(&entry, true) ) _release(&entry, micros());
+
+  xTimerStop(_timer, 0);
+
+  xSemaphoreGive(_mutex);
+}
+
+// wake up when the oldest event is due, mutex held
+void BLEMidiPlayout::_arm(void)
+{
+  if ( !_count ) return;
+
+  int32_t wait_us = (int32_t) (_queue[_head].due_us - micros());
+  if ( wait_us < 0 ) wait_us = 0;
+
+  TickType_t ticks = ms2tick( (wait_us + 999) / 1000 );
+  xTimerChangePeriod(_timer, ticks ? ticks : 1, 0);
+}
+
+void BLEMidiPlayout::_timer_cb(TimerHandle_t timer)
+{
+  ((BLEMidiPlayout*) pvTimerGetTimerID(timer))->service();
+}
+
+const midi_playout_stats_t& BLEMidiPlayout::getStats(void)
+{
+  return _stats;
+}
+
+void BLEMidiPlayout::resetStats(void)
+{
+  varclr(&_stats);
+}
+
+void BLEMidiPlayout::printStats(Print& p)
+{
+  midi_playout_stats_t const st = _stats;
+  uint32_t const n     = st.intervals ? st.intervals : 1;
+  uint32_t const n_out = (st.events > 1) ? st.events - 1 : 1;
+
+  p.print("MIDI playout latency_ms=");
+  p.print(getLatency());
+  p.print(" events=");
+  p.print(st.events);
+  p.print(" late=");
+  p.print(st.late);
+  p.print(" overflows=");
+  p.println(st.overflows);
+
+  p.print("MIDI jitter_us arrival avg=");
+  p.print((uint32_t) (st.arrival_jitter_sum_us / n));
+  p.print(" max=");
+  p.print(st.arrival_jitter_max_us);
+  p.print(" playout avg=");
+  p.print((uint32_t) (st.playout_jitter_sum_us / n_out));
+  p.print(" max=");
+  p.println(st.playout_jitter_max_us);
+}
@@ -0,0 +1,141 @@
+/**************************************************************************/
+/*!
+    @file     BLEMidiPlayout.h
+    @author   hathach
+
+    @section LICENSE
+
+    Software License Agreement (BSD License)
+
+    Copyright (c) 2017, Adafruit Industries (adafruit.com)
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+    1. Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+    3. Neither the name of the copyright holders nor the
+    names of its contributors may be used to endorse or promote products
+    derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ''AS IS'' AND ANY
+    EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef BLEMIDIPLAYOUT_H_
+#define BLEMIDIPLAYOUT_H_
+
+#include "Arduino.h"
+
+#define BLE_MIDI_PLAYOUT_DEPTH        32
+#define BLE_MIDI_PLAYOUT_WINDOW_MS    2000  // clock offset is the minimum over this long
+#define BLE_MIDI_PLAYOUT_RESYNC_MS    4000  // a longer gap could hide a timestamp wrap
+#define BLE_MIDI_PLAYOUT_SLACK_US     500   // release this early rather than a tick late
+
+typedef struct
+{
+  uint32_t events;              // released
+  uint32_t late;                // released more than 1 ms after their time
+  uint32_t overflows;           // queue full, passed on unscheduled
+  uint32_t intervals;           // consecutive event pairs measured
+  uint32_t arrival_jitter_max_us;
+  uint32_t playout_jitter_max_us;
+  uint64_t arrival_jitter_sum_us;
+  uint64_t playout_jitter_sum_us;
+} midi_playout_stats_t;
+
+/* Plays received MIDI events at the sender's timing.
+ *
+ * BLE MIDI packets arrive once per connection interval, every event in one
+ * at the same time. Their 13 bit millisecond timestamps give the spacing the
+ * sender had. Sender time is mapped to local time with the smallest transit
+ * seen (arrival minus timestamp, refreshed every BLE_MIDI_PLAYOUT_WINDOW_MS
+ * to follow clock drift), and an event is released by a FreeRTOS timer at
+ * its mapped time plus the latency budget. A budget of at least one
+ * connection interval keeps events from being late.
+ *
+ * Jitter is measured per pair of consecutive events as the difference
+ * between their local spacing and the sender's: on arrival and on release.
+ */
+class BLEMidiPlayout
+{
+  public:
+    typedef void (*release_cb_t) (void* arg, const uint8_t* data, uint16_t len);
+
+    BLEMidiPlayout(void);
+
+    bool     begin(uint16_t depth = BLE_MIDI_PLAYOUT_DEPTH);
+    void     setReleaseCallback(release_cb_t fp, void* arg);
+
+    void     setLatency(uint16_t ms);
+    uint16_t getLatency(void);
+
+    // schedule a message of up to 3 bytes, false if the queue is full
+    bool     push(uint16_t timestamp, const uint8_t* data, uint8_t len);
+
+    // release everything queued now
+    void     flush(void);
+
+    // release what is due and wait for the next one, run by the timer
+    void     service(void);
+
+    const midi_playout_stats_t& getStats(void);
+    void     resetStats(void);
+    void     printStats(Print& p);
+
+  private:
+    typedef struct
+    {
+      uint32_t due_us;
+      uint8_t  len;
+      uint8_t  data[3];
+    } entry_t;
+
+    entry_t*          _queue;
+    uint16_t          _depth;
+    uint16_t          _head;
+    uint16_t          _count;
+
+    SemaphoreHandle_t _mutex;
+    TimerHandle_t     _timer;
+
+    release_cb_t      _release_cb;
+    void*             _release_arg;
+
+    uint32_t          _latency_us;
+
+    // sender clock
+    bool              _synced;
+    uint16_t          _last_ts;
+    uint32_t          _sender_ms;     // timestamps unwrapped
+    uint32_t          _last_arrival_us;
+    uint32_t          _offset_us;     // local minus sender time, smallest transit
+    uint32_t          _next_offset_us;
+    uint32_t          _window_start_us;
+
+    // jitter
+    bool              _have_arrival;
+    uint32_t          _prev_transit_us;
+    bool              _have_release;
+    int32_t           _prev_lateness_us;
+
+    midi_playout_stats_t _stats;
+
+    bool _pop(entry_t* entry, bool all);
+    void _arm(void);
+    void _release(const entry_t* entry, uint32_t now);
+
+    static void _timer_cb(TimerHandle_t timer);
+};
+
+#endif /* BLEMIDIPLAYOUT_H_ */
@@ -0,0 +1,80 @@
+import serial
+import sys
+import os
+import binascii
+
+# Captures the screens BLEBoy dumps at startup when built with RENDER_CHECK 1,
+# saves them as PBM images and compares them against golden images.
+# The rendering runs on the board, this only reads its Serial output.  The
+# golden images for the root, main, status and settings menus are in
+# Scripts/screens (status shows the placeholder address, not the board's).
+# Scripts/host renders and compares the same screens on a PC (make screens,
+# make update-screens), both must agree on the golden images.
+#
+# usage: BLEBoy_checkScreensFromSerial.py <serial port> [golden dir] [--update]
+#   --update stores the captured screens as the new golden images
+
+BAUD = 9600
+
+def pbmRaster(data):
+    # skip magic, width and height (whitespace separated, no comments
+    # expected) and the single whitespace before the raster
+    header = 0
+    for i in range(3):
+        while data[header:header+1].isspace():
+            header += 1
+        while data[header:header+1] and not data[header:header+1].isspace():
+            header += 1
+    return data[header+1:]
+
+def diffPixels(a, b):
+    count = 0
+    for x, y in zip(bytearray(a), bytearray(b)):
+        count += bin(x ^ y).count("1")
+    return count
+
+def main():
+    if len(sys.argv) < 2:
+        print("usage: " + sys.argv[0] + " <serial port> [golden dir] [--update]")
+        return 2
+    port = sys.argv[1]
+    args = [a for a in sys.argv[2:] if a != "--update"]
+    update = "--update" in sys.argv
+    golden = args[0] if args else os.path.join(os.path.dirname(os.path.abspath(__file__)), "screens")
+    if not os.path.isdir(golden):
+        os.makedirs(golden)
+
+    ser = serial.Serial(port, BAUD, timeout=2)
+    print("Waiting for BLEBoy to start (reset the board)...")
+    failed = 0
+    stats = {}
+    while True:
+        line = ser.readline().decode("ascii", "replace").strip()
+        if line.startswith("SCREEN "):
+            name, us, pixels, columns, lines, busBytes = line.split()[1:7]
+            stats[name] = (us, pixels, columns, lines, busBytes)
+        elif line.startswith("PBM "):
+            name, hexdata = line.split()[1:3]
+            pbm = binascii.unhexlify(hexdata)
+            path = os.path.join(golden, name + ".pbm")
+            us, pixels, columns, lines, busBytes = stats.get(name, ("?",) * 5)
+            result = ""
+            if update or not os.path.exists(path):
+                open(path, "wb").write(pbm)
+                result = "stored"
+            else:
+                diff = diffPixels(pbmRaster(open(path, "rb").read()), pbmRaster(pbm))
+                result = "OK" if diff == 0 else ("%d pixels differ" % diff)
+                if diff:
+                    failed += 1
+                    open(os.path.join(golden, name + ".new.pbm"), "wb").write(pbm)
+            print("%-10s %6s us %6s px %5s cols %5s lines %5s bus bytes  %s" %
+                  (name, us, pixels, columns, lines, busBytes, result))
+        elif not line and stats:
+            # the dump is over once the board goes quiet
+            break
+    ser.close()
+    return 1 if failed else 0
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,126 @@
+/*********************************************************************
+BLEBoy render check on the host.
+
+Renders the BLEBoy menus (BLEBoy/MenuScreens.cpp, the code the sketch
+runs) into an SSD1306_Canvas and compares each screen with its golden
+image.  Prints the same SCREEN lines as the sketch built with
+RENDER_CHECK 1 (render time, primitive calls, bus bytes) and the pixels
+that differ.  Screens without a golden image, or all of them with
+--update, are stored as the new golden images.
+
+usage: BLEBoy_renderScreens <golden dir> [--update]
+exit status 1 if a screen differs
+*********************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "MenuScreens.h"
+
+// what the sketch provides, with its start values
+Adafruit_SSD1306 display = Adafruit_SSD1306();
+LatencyLog latency;
+int oob = 0;
+int bond = 1;
+int mitm = 1;
+int lesc = 1;
+int keypress = 1;
+int io = 0;
+static char addr[18] = "00:00:00:00:00:00";
+char* addrString = addr;
+
+// menu events, nothing is selected here
+void setBonding(MenuComponent* p_menu_component) {}
+void setLed(MenuComponent* p_menu_component) {}
+void setAdv(MenuComponent* p_menu_component) {}
+void terminateConnections(MenuComponent* p_menu_component) {}
+void setStatus(MenuComponent* p_menu_component) {}
+void setLesc(MenuComponent* p_menu_component) {}
+void setKeypress(MenuComponent* p_menu_component) {}
+void setIO(MenuComponent* p_menu_component) {}
+void setOOB(MenuComponent* p_menu_component) {}
+void setMitm(MenuComponent* p_menu_component) {}
+void clearBonds(MenuComponent* p_menu_component) {}
+void genOOBData(MenuComponent* p_menu_component) {}
+void printLatency(MenuComponent* p_menu_component) {}
+
+class FilePrint : public Print {
+ public:
+  FILE* f;
+  FilePrint(FILE* f) : f(f) {}
+  size_t write(uint8_t c) { return fputc(c, f) == EOF ? 0 : 1; }
+  using Print::write;
+};
+
+// P4 image of the panel size: header and 512 bytes of raster
+#define PBM_MAX 1024
+
+int main(int argc, char** argv){
+  const char* golden = NULL;
+  bool update = false;
+  for(int a = 1; a < argc; a++){
+    if(!strcmp(argv[a], "--update")){
+      update = true;
+    }
+    else{
+      golden = argv[a];
+    }
+  }
+  if(!golden){
+    fprintf(stderr, "usage: %s <golden dir> [--update]\n", argv[0]);
+    return 2;
+  }
+
+  setupMenus();
+  SSD1306_Canvas canvas;
+  if(!canvas.begin()){
+    fprintf(stderr, "no memory for the canvas\n");
+    return 2;
+  }
+
+  int failed = 0;
+  beginRenderCheck(canvas);
+  for(uint8_t i = 0; i < CHECK_SCREENS; i++){
+    renderCheckScreen(canvas, i, Serial);
+    Serial.flush();
+
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s.pbm", golden, checkScreenNames[i]);
+    static uint8_t pbm[PBM_MAX];
+    size_t len = 0;
+    FILE* f = fopen(path, "rb");
+    if(f){
+      len = fread(pbm, 1, sizeof(pbm), f);
+      fclose(f);
+    }
+
+    if(update || !f){
+      f = fopen(path, "wb");
+      if(!f){
+        fprintf(stderr, "can't write %s\n", path);
+        return 2;
+      }
+      FilePrint out(f);
+      canvas.writePBM(out);
+      fclose(f);
+      printf("  %s: stored\n", path);
+      continue;
+    }
+
+    int32_t diff = canvas.comparePBM(pbm, len);
+    if(diff < 0){
+      printf("  %s: not a %dx%d P4 image\n", path, SSD1306_LCDWIDTH, SSD1306_LCDHEIGHT);
+      failed++;
+    }
+    else if(diff){
+      printf("  %s: %ld pixels differ\n", path, (long)diff);
+      failed++;
+    }
+    else{
+      printf("  %s: ok\n", path);
+    }
+  }
+  endRenderCheck();
+
+  printf(failed ? "%d screens differ\n" : "all screens match\n", failed);
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,116 @@
+/*********************************************************************
+Host stand-in for the Arduino core.
+*********************************************************************/
+
+#include <time.h>
+#include "Arduino.h"
+#include "Wire.h"
+#include "SPI.h"
+
+HardwareSerial Serial;
+TwoWire Wire;
+SPIClass SPI;
+
+static uint64_t nowMicros(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static const uint64_t startMicros = nowMicros();
+
+unsigned long micros(void) {
+  return (unsigned long)(nowMicros() - startMicros);
+}
+
+unsigned long millis(void) {
+  return micros() / 1000;
+}
+
+// busy waits like the core, the simulated bus is timed by micros()
+void delay(unsigned long ms) {
+  delayMicroseconds(ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+  unsigned long start = micros();
+  while ((micros() - start) < us) {}
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  return putchar(c) == EOF ? 0 : 1;
+}
+
+void HardwareSerial::flush(void) {
+  fflush(stdout);
+}
+
+/*------------------------------------------------------------------*/
+/* Print
+ *------------------------------------------------------------------*/
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while (size--) n += write(*buffer++);
+  return n;
+}
+
+size_t Print::print(const String &s) {
+  return write(s.c_str(), s.length());
+}
+
+size_t Print::print(unsigned long n, int base) {
+  char buf[8 * sizeof(long) + 1];
+  char *p = &buf[sizeof(buf) - 1];
+  *p = '\0';
+  if (base < 2) base = 10;
+  do {
+    uint8_t d = n % base;
+    *--p = d < 10 ? '0' + d : 'A' + d - 10;
+    n /= base;
+  } while (n);
+  return write(p);
+}
+
+size_t Print::print(long n, int base) {
+  if ((base == 10) && (n < 0)) {
+    return print('-') + print((unsigned long)-n, 10);
+  }
+  return print((unsigned long)n, base);
+}
+
+size_t Print::print(double n, int digits) {
+  char buf[48];
+  snprintf(buf, sizeof(buf), "%.*f", digits, n);
+  return write(buf);
+}
+
+/*------------------------------------------------------------------*/
+/* String
+ *------------------------------------------------------------------*/
+void String::fromULong(unsigned long n, unsigned char base) {
+  char buf[8 * sizeof(long) + 1];
+  char *p = &buf[sizeof(buf) - 1];
+  *p = '\0';
+  if (base < 2) base = 10;
+  do {
+    uint8_t d = n % base;
+    *--p = d < 10 ? '0' + d : 'a' + d - 10;
+    n /= base;
+  } while (n);
+  _s = p;
+}
+
+void String::fromLong(long n, unsigned char base) {
+  if ((base == 10) && (n < 0)) {
+    fromULong((unsigned long)-n, 10);
+    _s.insert(0, 1, '-');
+  } else {
+    fromULong((unsigned long)n, base);
+  }
+}
+
+void String::fromDouble(double n, unsigned char decimals) {
+  char buf[48];
+  snprintf(buf, sizeof(buf), "%.*f", decimals, n);
+  _s = buf;
+}
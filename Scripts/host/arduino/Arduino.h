@@ -0,0 +1,71 @@
+/*********************************************************************
+Host stand-in for the Arduino core, enough to build the display code
+(Adafruit-GFX, Adafruit_SSD1306, arduino-menusystem) and the BLEBoy menus
+on a PC.  Pins do nothing, time is the host's monotonic clock, Serial
+writes to stdout.
+*********************************************************************/
+#ifndef _HOST_ARDUINO_H_
+#define _HOST_ARDUINO_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+
+// the builder passes it on the command line, libraries test it before
+// including anything
+#ifndef ARDUINO
+  #define ARDUINO 10800
+#endif
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW  0
+#define INPUT        0
+#define OUTPUT       1
+#define INPUT_PULLUP 2
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+#define PROGMEM
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+
+using std::min;
+using std::max;
+
+inline void pinMode(uint8_t pin, uint8_t mode) { (void)pin; (void)mode; }
+inline void digitalWrite(uint8_t pin, uint8_t val) { (void)pin; (void)val; }
+inline int digitalRead(uint8_t pin) { (void)pin; return HIGH; }
+inline void yield(void) {}
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+#include "Print.h"
+#include "WString.h"
+#include "binary.h"
+
+class HardwareSerial : public Print {
+ public:
+  void begin(unsigned long baud) { (void)baud; }
+  size_t write(uint8_t c);
+  using Print::write;
+  int available(void) { return 0; }
+  int read(void) { return -1; }
+  void flush(void);
+};
+
+extern HardwareSerial Serial;
+
+// a sketch's setup() and loop(), see sketch_main.cpp
+void setup(void);
+void loop(void);
+
+#endif
@@ -0,0 +1,44 @@
+/*********************************************************************
+Host stand-in for the Arduino Print class.
+*********************************************************************/
+#ifndef _HOST_PRINT_H_
+#define _HOST_PRINT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+class String;
+class __FlashStringHelper;
+
+class Print {
+ public:
+  virtual ~Print() {}
+
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  size_t write(const char *str) { return str ? write((const uint8_t *)str, strlen(str)) : 0; }
+  size_t write(const char *buffer, size_t size) { return write((const uint8_t *)buffer, size); }
+
+  size_t print(const __FlashStringHelper *s) { return write((const char *)s); }
+  size_t print(const String &s);
+  size_t print(const char *s) { return write(s); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(unsigned char n, int base = DEC) { return print((unsigned long)n, base); }
+  size_t print(int n, int base = DEC) { return print((long)n, base); }
+  size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); }
+  size_t print(long n, int base = DEC);
+  size_t print(unsigned long n, int base = DEC);
+  size_t print(double n, int digits = 2);
+
+  template<typename T> size_t println(T v) { size_t n = print(v); return n + println(); }
+  template<typename T> size_t println(T v, int fmt) { size_t n = print(v, fmt); return n + println(); }
+  size_t println(void) { return write("\r\n"); }
+};
+
+#endif
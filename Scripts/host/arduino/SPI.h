@@ -0,0 +1,31 @@
+/*********************************************************************
+Host stand-in for SPI: transfers go nowhere.
+*********************************************************************/
+#ifndef _HOST_SPI_H_
+#define _HOST_SPI_H_
+
+#include "Arduino.h"
+
+#define SPI_HAS_TRANSACTION
+#define SPI_MODE0 0
+#define SPI_CLOCK_DIV2 4
+
+class SPISettings {
+ public:
+  SPISettings(uint32_t clock = 4000000, uint8_t order = MSBFIRST, uint8_t mode = SPI_MODE0) {
+    (void)clock; (void)order; (void)mode;
+  }
+};
+
+class SPIClass {
+ public:
+  void begin(void) {}
+  void beginTransaction(SPISettings settings) { (void)settings; }
+  void endTransaction(void) {}
+  uint8_t transfer(uint8_t data) { return data; }
+  void setClockDivider(uint8_t div) { (void)div; }
+};
+
+extern SPIClass SPI;
+
+#endif
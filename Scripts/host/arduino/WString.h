@@ -0,0 +1,43 @@
+/*********************************************************************
+Host stand-in for the Arduino String class, backed by std::string.
+*********************************************************************/
+#ifndef _HOST_WSTRING_H_
+#define _HOST_WSTRING_H_
+
+#include <string>
+
+class String {
+ public:
+  String(const char *s = "") : _s(s ? s : "") {}
+  String(char c) : _s(1, c) {}
+  String(int n, unsigned char base = 10) { fromLong(n, base); }
+  String(unsigned int n, unsigned char base = 10) { fromULong(n, base); }
+  String(long n, unsigned char base = 10) { fromLong(n, base); }
+  String(unsigned long n, unsigned char base = 10) { fromULong(n, base); }
+  String(float n, unsigned char decimals = 2) { fromDouble(n, decimals); }
+  String(double n, unsigned char decimals = 2) { fromDouble(n, decimals); }
+
+  unsigned int length(void) const { return _s.length(); }
+  const char *c_str(void) const { return _s.c_str(); }
+  char operator[](unsigned int i) const { return i < _s.length() ? _s[i] : 0; }
+  bool operator==(const String &o) const { return _s == o._s; }
+  bool operator!=(const String &o) const { return _s != o._s; }
+
+  String &operator+=(const String &o) { _s += o._s; return *this; }
+  String &operator+=(const char *s) { if (s) _s += s; return *this; }
+  String &operator+=(char c) { _s += c; return *this; }
+  String &operator+=(int n) { return *this += String(n); }
+  String &operator+=(unsigned int n) { return *this += String(n); }
+  String &operator+=(long n) { return *this += String(n); }
+  String &operator+=(unsigned long n) { return *this += String(n); }
+  String &operator+=(float n) { return *this += String(n); }
+  String &operator+=(double n) { return *this += String(n); }
+
+ private:
+  std::string _s;
+  void fromLong(long n, unsigned char base);
+  void fromULong(unsigned long n, unsigned char base);
+  void fromDouble(double n, unsigned char decimals);
+};
+
+#endif
@@ -0,0 +1,26 @@
+/*********************************************************************
+Host stand-in for Wire: transfers go nowhere, reads return nothing.
+*********************************************************************/
+#ifndef _HOST_WIRE_H_
+#define _HOST_WIRE_H_
+
+#include "Arduino.h"
+
+#define BUFFER_LENGTH 32
+
+class TwoWire : public Print {
+ public:
+  void begin(void) {}
+  void setClock(uint32_t hz) { (void)hz; }
+  void beginTransmission(uint8_t addr) { (void)addr; }
+  uint8_t endTransmission(bool stop = true) { (void)stop; return 0; }
+  uint8_t requestFrom(uint8_t addr, uint8_t len) { (void)addr; (void)len; return 0; }
+  size_t write(uint8_t c) { (void)c; return 1; }
+  using Print::write;
+  int available(void) { return 0; }
+  int read(void) { return -1; }
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1 @@
+// Host stand-in: Adafruit_SSD1306.cpp includes it on non-ARM targets.
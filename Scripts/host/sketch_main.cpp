@@ -0,0 +1,19 @@
+/*********************************************************************
+main() for running an example sketch on the host: setup() once, then
+loop() SKETCH_LOOPS times (default 0, the benchmarks report from setup()).
+*********************************************************************/
+
+#include "Arduino.h"
+
+#ifndef SKETCH_LOOPS
+  #define SKETCH_LOOPS 0
+#endif
+
+int main(void) {
+  setup();
+  for (long i=0; i<SKETCH_LOOPS; i++) {
+    loop();
+  }
+  Serial.flush();
+  return 0;
+}
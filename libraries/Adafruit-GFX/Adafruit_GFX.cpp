@@ -82,6 +82,11 @@ WIDTH(w), HEIGHT(h)
     wrap      = true;
     _cp437    = false;
     gfxFont   = NULL;
+    textCache = NULL;
+}
+
+Adafruit_GFX::~Adafruit_GFX(void) {
+    disableTextCache();
 }
 
 // Bresenham's algorithm - thx wikpedia
@@ -160,6 +165,19 @@ void Adafruit_GFX::writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h,
     fillRect(x,y,w,h,color);
 }
 
+// (x,y) is the pixel of bit 0, bits above h are ignored
+void Adafruit_GFX::writeColumn8(int16_t x, int16_t y, uint8_t bits,
+        uint8_t h, uint16_t color, uint16_t bg) {
+    // Overwrite in subclasses if the display stores 8 rows per byte!
+    for(uint8_t j=0; j<h; j++, bits >>= 1) {
+        if(bits & 1) {
+            writePixel(x, y+j, color);
+        } else if(bg != color) {
+            writePixel(x, y+j, bg);
+        }
+    }
+}
+
 void Adafruit_GFX::endWrite(){
     // Overwrite in subclasses if startWrite is defined!
 }
@@ -723,17 +741,15 @@ void Adafruit_GFX::drawChar(int16_t x, int16_t y, unsigned char c,
         startWrite();
         for(int8_t i=0; i<5; i++ ) { // Char bitmap = 5 columns
             uint8_t line = pgm_read_byte(&font[c * 5 + i]);
+            if(size == 1) { // Column byte is 8 pixels tall, hand it over whole
+                writeColumn8(x+i, y, line, 8, color, bg);
+                continue;
+            }
             for(int8_t j=0; j<8; j++, line >>= 1) {
                 if(line & 1) {
-                    if(size == 1)
-                        writePixel(x+i, y+j, color);
-                    else
-                        writeFillRect(x+i*size, y+j*size, size, size, color);
+                    writeFillRect(x+i*size, y+j*size, size, size, color);
                 } else if(bg != color) {
-                    if(size == 1)
-                        writePixel(x+i, y+j, bg);
-                    else
-                        writeFillRect(x+i*size, y+j*size, size, size, bg);
+                    writeFillRect(x+i*size, y+j*size, size, size, bg);
                 }
             }
         }
@@ -784,6 +800,11 @@ void Adafruit_GFX::drawChar(int16_t x, int16_t y, unsigned char c,
         // displays supporting setAddrWindow() and pushColors()), but haven't
         // implemented this yet.
 
+        if(pgm_read_byte(&gfxFont->flags) & GFX_FONT_RLE) {
+            drawRLEGlyph(x+xo*size, y+yo*size, &bitmap[bo], w, h, color, size);
+            return;
+        }
+
         startWrite();
         for(yy=0; yy<h; yy++) {
             for(xx=0; xx<w; xx++) {
@@ -806,6 +827,80 @@ void Adafruit_GFX::drawChar(int16_t x, int16_t y, unsigned char c,
     } // End classic vs custom font
 }
 
+// Next 4-bit value of a GFX_FONT_RLE glyph, high nibble first
+static inline uint8_t rleNibble(const uint8_t *&p, uint8_t &half) {
+    uint8_t b = pgm_read_byte(p);
+    if((half ^= 1)) return b >> 4;
+    p++;
+    return b & 0x0F;
+}
+
+// Draw a GFX_FONT_RLE glyph (see gfxfont.h) with its top left corner at
+// x,y.  Rows are rebuilt from the deltas in a row buffer and every run of
+// set pixels becomes one span; rows that repeat the one above only grow the
+// height of the pending spans, so solid stems come out as single rects.
+void Adafruit_GFX::drawRLEGlyph(int16_t x, int16_t y, const uint8_t *bitmap,
+  uint8_t w, uint8_t h, uint16_t color, uint8_t size) {
+    uint8_t  row[32], delta[32];          // w <= 255
+    uint8_t  bytes = (w + 7) >> 3;
+    uint8_t  half = 0, set = 1, top = 0, i;
+    uint16_t run = 0, xx, yy;
+
+    memset(row, 0, bytes);
+    startWrite();
+    for(yy=0; yy<=h; yy++) {
+        uint8_t changed = (yy == h);    // flush the last rows
+        if(yy < h) {
+            memset(delta, 0, bytes);
+            for(xx=0; xx<w; ) {
+                while(!run) {
+                    // next run, 15 escapes to two more nibbles
+                    run = rleNibble(bitmap, half);
+                    if(run == 15) {
+                        run  = rleNibble(bitmap, half) << 4;
+                        run |= rleNibble(bitmap, half);
+                        run += 15;
+                    }
+                    set ^= 1;
+                }
+                uint8_t n = (run > (uint16_t)(w - xx)) ? (w - xx) : run;
+                if(set) {
+                    // set delta bits xx..xx+n-1, a byte at a time
+                    uint8_t b = xx >> 3, last = (xx + n - 1) >> 3;
+                    uint8_t head = 0xFF >> (xx & 7),
+                            tail = 0xFF << (7 - ((xx + n - 1) & 7));
+                    if(b == last) {
+                        delta[b] |= head & tail;
+                    } else {
+                        delta[b++] |= head;
+                        while(b < last) delta[b++] = 0xFF;
+                        delta[b] |= tail;
+                    }
+                    changed = 1;
+                }
+                xx  += n;
+                run -= n;
+            }
+        }
+        if(!changed) continue;
+
+        // rows top..yy-1 all look like row[], draw its spans
+        if(yy > top) {
+            for(xx=0; xx<w; ) {
+                if(!(xx & 7) && !row[xx >> 3]) { xx += 8; continue; }
+                if(!(row[xx >> 3] & (0x80 >> (xx & 7)))) { xx++; continue; }
+                uint8_t x0 = xx;
+                while((xx < w) && (row[xx >> 3] & (0x80 >> (xx & 7)))) xx++;
+                writeFillRect(x + x0 * size, y + top * size,
+                  (xx - x0) * size, (yy - top) * size, color);
+            }
+        }
+        for(i=0; i<bytes; i++) row[i] ^= delta[i];
+        top = yy;
+    }
+    endWrite();
+}
+
 #if ARDUINO >= 100
 size_t Adafruit_GFX::write(uint8_t c) {
 #else
@@ -870,8 +965,103 @@ int16_t Adafruit_GFX::getCursorY(void) const {
     return cursor_y;
 }
 
+// Cached getTextBounds()/getTextLayout() results.  Entries are keyed by a
+// hash of the string (or its flash address) mixed with everything else the
+// result depends on apart from font and size, which flush the cache.
+#define GFX_TEXT_BOUNDS 1
+#define GFX_TEXT_LAYOUT 2
+
+struct GFXtextEntry {
+    uint32_t key;
+    uint8_t  kind, len; // GFX_TEXT_*, 0 = free; low 8 bits of the length
+    union {
+        struct { int16_t x1, y1; uint16_t w, h; } bounds;
+        struct { uint8_t count; GFXtextLine line[GFX_TEXT_LINES]; } layout;
+    } u;
+};
+
+struct GFXtextCache {
+    uint8_t       entries, next;
+    uint32_t      hits, misses;
+    GFXtextEntry *entry;
+};
+
+// FNV-1a
+static inline uint32_t textHashByte(uint32_t h, uint8_t b) {
+    return (h ^ b) * 16777619UL;
+}
+
+static uint32_t textHashWord(uint32_t h, uint16_t w) {
+    return textHashByte(textHashByte(h, w & 0xFF), w >> 8);
+}
+
+static uint32_t textHash(const char *str, boolean progmem, uint8_t *len) {
+    uint32_t h = 2166136261UL;
+    uint8_t  n = 0;
+    if(progmem) { // Flash contents never change, the address will do
+        h = textHashWord(textHashWord(h, (uintptr_t)str),
+          (uint32_t)(uintptr_t)str >> 16);
+    } else {
+        for(const char *p = str; *p; p++, n++) h = textHashByte(h, *p);
+    }
+    *len = n;
+    return h;
+}
+
+static void textCacheFlush(GFXtextCache *c) {
+    if(c) {
+        for(uint8_t i=0; i<c->entries; i++) c->entry[i].kind = 0;
+    }
+}
+
+// Entry holding key, or the one to overwrite with it (*hit false)
+static GFXtextEntry *textCacheFind(GFXtextCache *c, uint8_t kind,
+  uint32_t key, uint8_t len, boolean *hit) {
+    for(uint8_t i=0; i<c->entries; i++) {
+        GFXtextEntry *e = &c->entry[i];
+        if((e->kind == kind) && (e->key == key) && (e->len == len)) {
+            c->hits++;
+            *hit = true;
+            return e;
+        }
+    }
+    c->misses++;
+    *hit = false;
+    GFXtextEntry *e = &c->entry[c->next];
+    if(++c->next >= c->entries) c->next = 0;
+    e->kind = 0;
+    return e;
+}
+
+void Adafruit_GFX::enableTextCache(uint8_t entries) {
+    disableTextCache();
+    if(!entries) return;
+    if((textCache = (GFXtextCache *)malloc(sizeof(GFXtextCache) +
+      entries * sizeof(GFXtextEntry)))) {
+        textCache->entries = entries;
+        textCache->next    = 0;
+        textCache->hits    = textCache->misses = 0;
+        textCache->entry   = (GFXtextEntry *)(textCache + 1);
+        textCacheFlush(textCache);
+    }
+}
+
+void Adafruit_GFX::disableTextCache(void) {
+    if(textCache) {
+        free(textCache);
+        textCache = NULL;
+    }
+}
+
+void Adafruit_GFX::getTextCacheStats(uint32_t *hits, uint32_t *misses) {
+    *hits   = textCache ? textCache->hits   : 0;
+    *misses = textCache ? textCache->misses : 0;
+}
+
 void Adafruit_GFX::setTextSize(uint8_t s) {
-    textsize = (s > 0) ? s : 1;
+    s = (s > 0) ? s : 1;
+    if(s != textsize) textCacheFlush(textCache);
+    textsize = s;
 }
 
 void Adafruit_GFX::setTextColor(uint16_t c) {
@@ -932,6 +1122,7 @@ void Adafruit_GFX::setFont(const GFXfont *f) {
         // Move cursor pos up 6 pixels so it's at top-left of char.
         cursor_y -= 6;
     }
+    if(f != gfxFont) textCacheFlush(textCache);
     gfxFont = (GFXfont *)f;
 }
 
@@ -999,6 +1190,25 @@ void Adafruit_GFX::charBounds(char c, int16_t *x, int16_t *y,
 void Adafruit_GFX::getTextBounds(char *str, int16_t x, int16_t y,
         int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h) {
     uint8_t c; // Current character
+    GFXtextEntry *e = NULL;
+
+    if(textCache) {
+        boolean hit;
+        uint8_t len;
+        uint32_t key = textHash(str, false, &len);
+        key = textHashWord(textHashWord(textHashWord(key, x), y),
+          (_width << 1) | wrap);
+        e = textCacheFind(textCache, GFX_TEXT_BOUNDS, key, len, &hit);
+        if(hit) {
+            *x1 = e->u.bounds.x1;
+            *y1 = e->u.bounds.y1;
+            *w  = e->u.bounds.w;
+            *h  = e->u.bounds.h;
+            return;
+        }
+        e->key = key;
+        e->len = len;
+    }
 
     *x1 = x;
     *y1 = y;
@@ -1017,12 +1227,39 @@ void Adafruit_GFX::getTextBounds(char *str, int16_t x, int16_t y,
         *y1 = miny;
         *h  = maxy - miny + 1;
     }
+
+    if(e) {
+        e->kind        = GFX_TEXT_BOUNDS;
+        e->u.bounds.x1 = *x1;
+        e->u.bounds.y1 = *y1;
+        e->u.bounds.w  = *w;
+        e->u.bounds.h  = *h;
+    }
 }
 
 // Same as above, but for PROGMEM strings
 void Adafruit_GFX::getTextBounds(const __FlashStringHelper *str,
         int16_t x, int16_t y, int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h) {
     uint8_t *s = (uint8_t *)str, c;
+    GFXtextEntry *e = NULL;
+
+    if(textCache) {
+        boolean hit;
+        uint8_t len;
+        uint32_t key = textHash((const char *)str, true, &len);
+        key = textHashWord(textHashWord(textHashWord(key, x), y),
+          (_width << 1) | wrap);
+        e = textCacheFind(textCache, GFX_TEXT_BOUNDS, key, len, &hit);
+        if(hit) {
+            *x1 = e->u.bounds.x1;
+            *y1 = e->u.bounds.y1;
+            *w  = e->u.bounds.w;
+            *h  = e->u.bounds.h;
+            return;
+        }
+        e->key = key;
+        e->len = len;
+    }
 
     *x1 = x;
     *y1 = y;
@@ -1041,6 +1278,133 @@ void Adafruit_GFX::getTextBounds(const __FlashStringHelper *str,
         *y1 = miny;
         *h  = maxy - miny + 1;
     }
+
+    if(e) {
+        e->kind        = GFX_TEXT_BOUNDS;
+        e->u.bounds.x1 = *x1;
+        e->u.bounds.y1 = *y1;
+        e->u.bounds.w  = *w;
+        e->u.bounds.h  = *h;
+    }
+}
+
+// Pixels the cursor moves for c
+int16_t Adafruit_GFX::charAdvance(uint8_t c) {
+    if(gfxFont) {
+        uint8_t first = pgm_read_byte(&gfxFont->first),
+                last  = pgm_read_byte(&gfxFont->last);
+        if((c < first) || (c > last)) return 0;
+        GFXglyph *glyph = &(((GFXglyph *)pgm_read_pointer(
+          &gfxFont->glyph))[c - first]);
+        return (uint8_t)pgm_read_byte(&glyph->xAdvance) * (int16_t)textsize;
+    }
+    return (c == '\r') ? 0 : textsize * 6;
+}
+
+// Word wrap, see getTextLayout()
+uint8_t Adafruit_GFX::layoutText(const char *str, int16_t w,
+  GFXtextLine *lines, uint8_t maxLines) {
+    uint8_t  count = 0, start = 0, i, c;
+    int16_t  lineW = 0, spaceW = 0; // Width up to the last space
+    int16_t  space = -1;            // Last space on this line
+
+    for(i=0; ; i++) {
+        c = (i < 255) ? str[i] : 0;
+        if(!c || (c == '\n')) {
+            if(count < maxLines) {
+                lines[count].start = start;
+                lines[count].len   = i - start;
+                lines[count].width = lineW;
+            }
+            count++;
+            if(!c) break;
+            start = i + 1;
+            lineW = 0;
+            space = -1;
+            continue;
+        }
+        int16_t a = charAdvance(c);
+        if(c == ' ') {
+            space  = i;
+            spaceW = lineW;
+        } else if((lineW + a > w) && (i > start)) {
+            // Break after the last space, or mid-word if there is none
+            uint8_t end = (space >= 0) ? space : i;
+            if(count < maxLines) {
+                lines[count].start = start;
+                lines[count].len   = end - start;
+                lines[count].width = (space >= 0) ? spaceW : lineW;
+            }
+            count++;
+            if(space >= 0) {
+                lineW -= spaceW + charAdvance(' ');
+                start  = space + 1;
+            } else {
+                lineW  = 0;
+                start  = i;
+            }
+            space = -1;
+        }
+        lineW += a;
+    }
+    return count;
+}
+
+uint8_t Adafruit_GFX::getTextLayout(const char *str, int16_t w,
+  GFXtextLine *lines, uint8_t maxLines) {
+    GFXtextEntry *e = NULL;
+    uint8_t n;
+
+    if(textCache) {
+        boolean hit;
+        uint8_t len;
+        uint32_t key = textHashWord(textHash(str, false, &len), w);
+        e = textCacheFind(textCache, GFX_TEXT_LAYOUT, key, len, &hit);
+        if(hit) {
+            n = e->u.layout.count;
+            memcpy(lines, e->u.layout.line,
+              ((n < maxLines) ? n : maxLines) * sizeof(GFXtextLine));
+            return n;
+        }
+        e->key = key;
+        e->len = len;
+    }
+
+    n = layoutText(str, w, lines, maxLines);
+
+    // Only complete layouts go in the cache
+    if(e && (n <= GFX_TEXT_LINES) && (n <= maxLines)) {
+        e->kind           = GFX_TEXT_LAYOUT;
+        e->u.layout.count = n;
+        memcpy(e->u.layout.line, lines, n * sizeof(GFXtextLine));
+    }
+    return n;
+}
+
+void Adafruit_GFX::printWrapped(const char *str, int16_t x, int16_t y,
+  int16_t w, uint8_t align) {
+    GFXtextLine line[GFX_TEXT_LINES];
+
+    if(w <= 0) w = _width - x;
+    uint8_t n = getTextLayout(str, w, line, GFX_TEXT_LINES);
+    if(n > GFX_TEXT_LINES) n = GFX_TEXT_LINES;
+
+    int16_t lh = textsize * (gfxFont ?
+      (uint8_t)pgm_read_byte(&gfxFont->yAdvance) : 8);
+    boolean oldWrap = wrap;
+    wrap = false; // Lines are already broken
+    for(uint8_t i=0; i<n; i++) {
+        int16_t dx = 0;
+        if(align == GFX_ALIGN_CENTER)     dx = (w - (int16_t)line[i].width) / 2;
+        else if(align == GFX_ALIGN_RIGHT) dx = w - (int16_t)line[i].width;
+        cursor_x = x + dx;
+        cursor_y = y;
+        for(uint8_t j=0; j<line[i].len; j++) write(str[line[i].start + j]);
+        y += lh;
+    }
+    wrap     = oldWrap;
+    cursor_x = x;
+    cursor_y = y;
 }
 
 // Return the size of the display (per current rotation)
@@ -9,11 +9,28 @@
 #endif
 #include "gfxfont.h"
 
+#ifndef GFX_TEXT_LINES
+ #define GFX_TEXT_LINES 4 // Lines kept per cached text layout
+#endif
+
+// printWrapped() alignment
+#define GFX_ALIGN_LEFT   0
+#define GFX_ALIGN_CENTER 1
+#define GFX_ALIGN_RIGHT  2
+
+typedef struct { // One line of a word wrapped text layout
+  uint8_t  start, len; // Chars of the string on this line
+  uint16_t width;      // Advance width in pixels
+} GFXtextLine;
+
+struct GFXtextCache;
+
 class Adafruit_GFX : public Print {
 
  public:
 
   Adafruit_GFX(int16_t w, int16_t h); // Constructor
+  virtual ~Adafruit_GFX(void);
 
   // This MUST be defined by the subclass:
   virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
@@ -27,6 +44,10 @@ class Adafruit_GFX : public Print {
   virtual void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
   virtual void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
   virtual void writeLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+  // Up to 8 vertically stacked pixels from one byte, bit 0 at the top (the
+  // layout of the classic font columns).  Clear bits use bg, or are left
+  // alone if bg == color.  Page-organized displays write whole bytes here.
+  virtual void writeColumn8(int16_t x, int16_t y, uint8_t bits, uint8_t h, uint16_t color, uint16_t bg);
   virtual void endWrite(void);
 
   // CONTROL API
@@ -46,7 +67,16 @@ class Adafruit_GFX : public Print {
     fillScreen(uint16_t color),
     // Optional and probably not necessary to change
     drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color),
-    drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color),
+    // 1-bit images, worth overriding on displays that store pixels packed
+    drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[],
+      int16_t w, int16_t h, uint16_t color),
+    drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[],
+      int16_t w, int16_t h, uint16_t color, uint16_t bg),
+    drawBitmap(int16_t x, int16_t y, uint8_t *bitmap,
+      int16_t w, int16_t h, uint16_t color),
+    drawBitmap(int16_t x, int16_t y, uint8_t *bitmap,
+      int16_t w, int16_t h, uint16_t color, uint16_t bg);
 
   // These exist only with Adafruit_GFX (no subclass overrides)
   void
@@ -64,14 +94,6 @@ class Adafruit_GFX : public Print {
       int16_t radius, uint16_t color),
     fillRoundRect(int16_t x0, int16_t y0, int16_t w, int16_t h,
       int16_t radius, uint16_t color),
-    drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[],
-      int16_t w, int16_t h, uint16_t color),
-    drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[],
-      int16_t w, int16_t h, uint16_t color, uint16_t bg),
-    drawBitmap(int16_t x, int16_t y, uint8_t *bitmap,
-      int16_t w, int16_t h, uint16_t color),
-    drawBitmap(int16_t x, int16_t y, uint8_t *bitmap,
-      int16_t w, int16_t h, uint16_t color, uint16_t bg),
     drawXBitmap(int16_t x, int16_t y, const uint8_t bitmap[],
       int16_t w, int16_t h, uint16_t color),
     drawGrayscaleBitmap(int16_t x, int16_t y, const uint8_t bitmap[],
@@ -104,7 +126,23 @@ class Adafruit_GFX : public Print {
     getTextBounds(char *string, int16_t x, int16_t y,
       int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h),
     getTextBounds(const __FlashStringHelper *s, int16_t x, int16_t y,
-      int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h);
+      int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h),
+    // Keep getTextBounds() and getTextLayout() results for the last
+    // 'entries' strings (RAM strings by content, flash strings by address).
+    // Dropped when the font or text size changes.  Off by default.
+    enableTextCache(uint8_t entries = 8),
+    disableTextCache(void),
+    getTextCacheStats(uint32_t *hits, uint32_t *misses),
+    // Word wrap str into a box w pixels wide (0: to the right edge) at
+    // cursor x,y, one line per font line height, GFX_TEXT_LINES at most.
+    printWrapped(const char *str, int16_t x, int16_t y, int16_t w = 0,
+      uint8_t align = GFX_ALIGN_LEFT);
+  // Break str (first 255 chars) into lines no wider than w pixels, at
+  // spaces where possible and always at '\n'.  Fills up to maxLines lines,
+  // returns the number of lines the whole text needs.
+  uint8_t
+    getTextLayout(const char *str, int16_t w, GFXtextLine *lines,
+      uint8_t maxLines);
 
 #if ARDUINO >= 100
   virtual size_t write(uint8_t);
@@ -125,6 +163,14 @@ class Adafruit_GFX : public Print {
   void
     charBounds(char c, int16_t *x, int16_t *y,
       int16_t *minx, int16_t *miny, int16_t *maxx, int16_t *maxy);
+  int16_t
+    charAdvance(uint8_t c);
+  uint8_t
+    layoutText(const char *str, int16_t w, GFXtextLine *lines,
+      uint8_t maxLines);
+  void
+    drawRLEGlyph(int16_t x, int16_t y, const uint8_t *bitmap,
+      uint8_t w, uint8_t h, uint16_t color, uint8_t size);
   const int16_t
     WIDTH, HEIGHT;   // This is the 'raw' display w/h - never changes
   int16_t
@@ -140,6 +186,8 @@ class Adafruit_GFX : public Print {
     _cp437; // If set, use correct CP437 charset (default is off)
   GFXfont
     *gfxFont;
+  GFXtextCache
+    *textCache; // NULL unless enableTextCache()
 };
 
 class Adafruit_GFX_Button {
@@ -8,6 +8,15 @@ fonts to be used with the Adafruit_GFX Arduino library.
 For UNIX-like systems.  Outputs to stdout; redirect to header file, e.g.:
   ./fontconvert ~/Library/Fonts/FreeSans.ttf 18 > FreeSans18pt7b.h
 
+Options (before the file name):
+  -r          run-length code the bitmaps (GFX_FONT_RLE, see gfxfont.h);
+              pays off from ~12pt up, small fonts are better left packed
+  -s chars    only keep the bitmaps of these chars
+  -f file     only keep the bitmaps of chars used in string and char
+              literals of a source file, e.g. a sketch (may be repeated)
+With -s/-f the first/last range shrinks to the chars used; chars in
+between that are not used keep their metrics but get an empty bitmap.
+
 REQUIRES FREETYPE LIBRARY.  www.freetype.org
 
 Currently this only extracts the printable 7-bit ASCII chars of a font.
@@ -18,8 +27,11 @@ See notes at end for glyph nomenclature & other tidbits.
 */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <ctype.h>
 #include <stdint.h>
+#include <unistd.h>
 #include <ft2build.h>
 #include FT_GLYPH_H
 #include "../gfxfont.h" // Adafruit_GFX font structures
@@ -46,6 +58,73 @@ void enbit(uint8_t value) {
 	}
 }
 
+// Write a GFX_FONT_RLE run length as 1 or 3 nibbles, returns nibble count
+int enrun(int n) {
+	int i, count = 0;
+	while(n > 270) {         // Longest single run
+		count += enrun(270);
+		count += enrun(0); // Empty run of the other kind
+		n     -= 270;
+	}
+	if(n < 15) {
+		for(i=8; i; i >>= 1) enbit(n & i);
+		return count + 1;
+	}
+	n = 0xF00 | (n - 15); // Escape, then length - 15 in two nibbles
+	for(i=0x800; i; i >>= 1) enbit(!!(n & i));
+	return count + 3;
+}
+
+// Mark the chars used in string and char literals of a source file
+int scanLiterals(const char *path, uint8_t *used) {
+	FILE *f;
+	int   c, quote, n, k;
+
+	if(!(f = fopen(path, "r"))) {
+		fprintf(stderr, "Can't open %s\n", path);
+		return 1;
+	}
+	while((c = getc(f)) != EOF) {
+		if(c == '/') { // Comments, may hold stray quotes
+			if((c = getc(f)) == '/') {
+				while(((c = getc(f)) != EOF) && (c != '\n'));
+			} else if(c == '*') {
+				for(n=0; ((c = getc(f)) != EOF) &&
+				  !((n == '*') && (c == '/')); n=c);
+			} else {
+				ungetc(c, f);
+			}
+			continue;
+		}
+		if((c != '"') && (c != '\'')) continue;
+		quote = c;
+		while(((c = getc(f)) != EOF) && (c != quote) && (c != '\n')) {
+			if(c == '\\') {
+				switch(c = getc(f)) {
+				  case 'n' : case 'r' : case 't' : case EOF :
+					continue;
+				  case 'x' :
+					for(n=0; isxdigit(k = getc(f));
+					  n = n * 16 + (isdigit(k) ? k - '0' : (tolower(k) - 'a' + 10)));
+					ungetc(k, f);
+					c = n & 0xFF;
+					break;
+				  default :
+					if((c >= '0') && (c <= '7')) {
+						for(n=c-'0', k=0; (k < 2) && ((c = getc(f)) >= '0') && (c <= '7'); k++)
+							n = n * 8 + c - '0';
+						if((k < 2) && (c != EOF)) ungetc(c, f);
+						c = n & 0xFF;
+					}
+				}
+			}
+			used[c & 0xFF] = 1;
+		}
+	}
+	fclose(f);
+	return 0;
+}
+
 int main(int argc, char *argv[]) {
 	int                i, j, err, size, first=' ', last='~',
 	                   bitmapOffset = 0, x, y, byte;
@@ -56,7 +135,29 @@ int main(int argc, char *argv[]) {
 	FT_Bitmap         *bitmap;
 	FT_BitmapGlyphRec *g;
 	GFXglyph          *table;
-	uint8_t            bit;
+	uint8_t            bit, used[256], subset = 0, rle = 0;
+	int                opt, packedSize = 0;
+
+	memset(used, 0, sizeof(used));
+	while((opt = getopt(argc, argv, "rs:f:")) != -1) {
+		switch(opt) {
+		  case 'r' :
+			rle = 1;
+			break;
+		  case 's' :
+			for(ptr=optarg; *ptr; ptr++) used[(uint8_t)*ptr] = 1;
+			subset = 1;
+			break;
+		  case 'f' :
+			if(scanLiterals(optarg, used)) return 1;
+			subset = 1;
+			break;
+		  default :
+			argc = 0; // Print usage
+		}
+	}
+	argc -= optind - 1; // Leave the positional args in argv[1..]
+	argv += optind - 1;
 
 	// Parse command line.  Valid syntaxes are:
 	//   fontconvert [filename] [size]
@@ -66,8 +167,8 @@ int main(int argc, char *argv[]) {
 	// ' ' (space) and '~', respectively
 
 	if(argc < 3) {
-		fprintf(stderr, "Usage: %s fontfile size [first] [last]\n",
-		  argv[0]);
+		fprintf(stderr, "Usage: %s [-r] [-s chars] [-f file]... "
+		  "fontfile size [first] [last]\n", argv[0]);
 		return 1;
 	}
 
@@ -86,6 +187,17 @@ int main(int argc, char *argv[]) {
 		last  = i;
 	}
 
+	if(subset) { // Shrink range to the chars used
+		for(i=first; (i <= last) && !used[i]; i++);
+		for(j=last; (j >= i) && !used[j]; j--);
+		if(i > j) {
+			fprintf(stderr, "No chars of the subset in range\n");
+			return 1;
+		}
+		first = i;
+		last  = j;
+	}
+
 	ptr = strrchr(argv[1], '/'); // Find last slash in filename
 	if(ptr) ptr++;         // First character of filename (path stripped)
 	else    ptr = argv[1]; // No path; font in local dir.
@@ -174,6 +286,41 @@ int main(int argc, char *argv[]) {
 		table[j].xOffset      = g->left;
 		table[j].yOffset      = 1 - g->top;
 
+		if(subset && !used[i]) { // Keep the metrics, drop the bitmap
+			table[j].width = table[j].height = 0;
+			FT_Done_Glyph(glyph);
+			continue;
+		}
+		packedSize += (bitmap->width * bitmap->rows + 7) / 8;
+
+		if(rle) {
+			// XOR each row with the one above it, code the bits
+			// as alternating runs starting with 0s
+			int run = 0, nibbles = 0;
+			uint8_t cur = 0, d;
+			for(y=0; y < bitmap->rows; y++) {
+				for(x=0;x < bitmap->width; x++) {
+					byte = x / 8;
+					bit  = 0x80 >> (x & 7);
+					d = !!(bitmap->buffer[y * bitmap->pitch + byte] & bit);
+					if(y) d ^= !!(bitmap->buffer[
+					  (y - 1) * bitmap->pitch + byte] & bit);
+					if(d == cur) {
+						run++;
+					} else {
+						nibbles += enrun(run);
+						cur ^= 1;
+						run  = 1;
+					}
+				}
+			}
+			if(run) nibbles += enrun(run);
+			if(nibbles & 1) enbit(0), enbit(0), enbit(0), enbit(0);
+			bitmapOffset += (nibbles + 1) / 2;
+			FT_Done_Glyph(glyph);
+			continue;
+		}
+
 		for(y=0; y < bitmap->rows; y++) {
 			for(x=0;x < bitmap->width; x++) {
 				byte = x / 8;
@@ -224,14 +371,22 @@ int main(int argc, char *argv[]) {
 	printf("  (GFXglyph *)%sGlyphs,\n", fontName);
 	if (face->size->metrics.height == 0) {
       // No face height info, assume fixed width and get from a glyph.
-		printf("  0x%02X, 0x%02X, %d };\n\n",
-			first, last, table[0].height);
+		printf("  0x%02X, 0x%02X, %d%s };\n\n",
+			first, last, table[0].height, rle ? ", GFX_FONT_RLE" : "");
 	} else {
-		printf("  0x%02X, 0x%02X, %ld };\n\n",
-			first, last, face->size->metrics.height >> 6);
+		printf("  0x%02X, 0x%02X, %ld%s };\n\n",
+			first, last, face->size->metrics.height >> 6,
+			rle ? ", GFX_FONT_RLE" : "");
 	}
 	printf("// Approx. %d bytes\n",
-	  bitmapOffset + (last - first + 1) * 7 + 7);
+	  bitmapOffset + (last - first + 1) * 7 + 8);
+	if(rle) {
+		printf("// Bitmaps %d bytes, %d packed\n", bitmapOffset, packedSize);
+		if(bitmapOffset >= packedSize) {
+			fprintf(stderr, "Run-length coding doesn't pay off for "
+			  "this font, leave out -r\n");
+		}
+	}
 	// Size estimate is based on AVR struct and pointer sizes;
 	// actual size may vary.
 
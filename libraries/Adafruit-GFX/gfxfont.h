@@ -19,6 +19,16 @@ typedef struct { // Data stored for FONT AS A WHOLE:
 	GFXglyph *glyph;       // Glyph array
 	uint8_t   first, last; // ASCII extents
 	uint8_t   yAdvance;    // Newline distance (y axis)
+	uint8_t   flags;       // GFX_FONT_* below, 0 (left out) for packed bitmaps
 } GFXfont;
 
+// Glyph bitmaps are run-length coded row deltas (fontconvert -r).  Each
+// glyph starts on a byte boundary at bitmapOffset.  Every row is XORed with
+// the row above it (the first with an empty row), the resulting width*height
+// bits are coded as alternating runs of 0s and 1s, starting with 0s.  Runs
+// are 4-bit values, high nibble first: 0-14 as is, 15 followed by two more
+// nibbles holding the length - 15 (15-270).  Longer runs are split with
+// empty runs of the other kind in between.
+#define GFX_FONT_RLE 0x01
+
 #endif // _GFXFONT_H_
@@ -108,37 +108,68 @@ static uint8_t buffer[SSD1306_LCDHEIGHT * SSD1306_LCDWIDTH / 8] = {
 #endif
 };
 
+// front buffer for the async flush: the dirty window copied out of the framebuffer
+// in bus segments, each preceded by one byte of headroom for the transport
+#define SSD1306_FRONT_BYTES (1 + 6 + SSD1306_DMA_SEGMENTS + SSD1306_LCDWIDTH * SSD1306_LCDPAGES)
+
 #define ssd1306_swap(a, b) { int16_t t = a; a = b; b = t; }
 
+// data bytes per Wire transaction on the blocking path: whatever the Wire
+// buffer holds next to the control byte
+#if defined(BUFFER_LENGTH)
+  #define SSD1306_WIRE_CHUNK (BUFFER_LENGTH - 1)
+#else
+  #define SSD1306_WIRE_CHUNK 16
+#endif
+
+// grow the dirty column span of a page so the next display() sends it
+inline void Adafruit_SSD1306::markDirty(uint8_t page, uint8_t x0, uint8_t x1) {
+  if (x0 < _dirtyMin[page]) _dirtyMin[page] = x0;
+  if (x1 > _dirtyMax[page]) _dirtyMax[page] = x1;
+}
+
 // the most basic function, set a single pixel
 void Adafruit_SSD1306::drawPixel(int16_t x, int16_t y, uint16_t color) {
-  if ((x < 0) || (x >= width()) || (y < 0) || (y >= height()))
-    return;
+  (this->*_pixelFn)(x, y, color);
+}
+
+// Rotation specialized writers: ROT is a template constant so the rotation
+// transform compiles down to the one case needed, setRotation() picks the
+// instances once instead of switching on the rotation for every pixel.
+template<uint8_t ROT>
+void Adafruit_SSD1306::drawPixelRot(int16_t x, int16_t y, uint16_t color) {
+  if (ROT & 1) {
+    if ((x < 0) || (x >= SSD1306_LCDHEIGHT) || (y < 0) || (y >= SSD1306_LCDWIDTH))
+      return;
+  } else {
+    if ((x < 0) || (x >= SSD1306_LCDWIDTH) || (y < 0) || (y >= SSD1306_LCDHEIGHT))
+      return;
+  }
 
-  // check rotation, move pixel around if necessary
-  switch (getRotation()) {
-  case 1:
+  // move pixel around for the rotation
+  if (ROT == 1) {
     ssd1306_swap(x, y);
-    x = WIDTH - x - 1;
-    break;
-  case 2:
-    x = WIDTH - x - 1;
-    y = HEIGHT - y - 1;
-    break;
-  case 3:
+    x = SSD1306_LCDWIDTH - x - 1;
+  } else if (ROT == 2) {
+    x = SSD1306_LCDWIDTH - x - 1;
+    y = SSD1306_LCDHEIGHT - y - 1;
+  } else if (ROT == 3) {
     ssd1306_swap(x, y);
-    y = HEIGHT - y - 1;
-    break;
+    y = SSD1306_LCDHEIGHT - y - 1;
   }
 
   // x is which column
+  uint8_t *pBuf = &_buffer[x+ (y/8)*SSD1306_LCDWIDTH];
+  uint8_t old = *pBuf;
     switch (color)
     {
-      case WHITE:   buffer[x+ (y/8)*SSD1306_LCDWIDTH] |=  (1 << (y&7)); break;
-      case BLACK:   buffer[x+ (y/8)*SSD1306_LCDWIDTH] &= ~(1 << (y&7)); break;
-      case INVERSE: buffer[x+ (y/8)*SSD1306_LCDWIDTH] ^=  (1 << (y&7)); break;
+      case WHITE:   *pBuf |=  (1 << (y&7)); break;
+      case BLACK:   *pBuf &= ~(1 << (y&7)); break;
+      case INVERSE: *pBuf ^=  (1 << (y&7)); break;
     }
 
+  // only a pixel that actually changed needs to go out on the bus
+  if (*pBuf != old) markDirty(y/8, x, x);
 }
 
 Adafruit_SSD1306::Adafruit_SSD1306(int8_t SID, int8_t SCLK, int8_t DC, int8_t RST, int8_t CS) : Adafruit_GFX(SSD1306_LCDWIDTH, SSD1306_LCDHEIGHT) {
@@ -148,6 +179,8 @@ Adafruit_SSD1306::Adafruit_SSD1306(int8_t SID, int8_t SCLK, int8_t DC, int8_t RS
   sclk = SCLK;
   sid = SID;
   hwSPI = false;
+  setRotation(0);
+  initFrame();
 }
 
 // constructor for hardware SPI - we indicate DataCommand, ChipSelect, Reset
@@ -156,6 +189,8 @@ Adafruit_SSD1306::Adafruit_SSD1306(int8_t DC, int8_t RST, int8_t CS) : Adafruit_
   rst = RST;
   cs = CS;
   hwSPI = true;
+  setRotation(0);
+  initFrame();
 }
 
 // initializer for I2C - we only indicate the reset pin!
@@ -163,6 +198,8 @@ Adafruit_SSD1306::Adafruit_SSD1306(int8_t reset) :
 Adafruit_GFX(SSD1306_LCDWIDTH, SSD1306_LCDHEIGHT) {
   sclk = dc = cs = sid = -1;
   rst = reset;
+  setRotation(0);
+  initFrame();
 }
 
 
@@ -283,8 +320,12 @@ void Adafruit_SSD1306::begin(uint8_t vccstate, uint8_t i2caddr, bool reset) {
   ssd1306_command(SSD1306_NORMALDISPLAY);                 // 0xA6
 
   ssd1306_command(SSD1306_DEACTIVATE_SCROLL);
+  _scrolling = false;
 
   ssd1306_command(SSD1306_DISPLAYON);//--turn on oled panel
+
+  // panel RAM content is unknown after init, next display() sends everything
+  invalidate();
 }
 
 
@@ -297,6 +338,9 @@ void Adafruit_SSD1306::invertDisplay(uint8_t i) {
 }
 
 void Adafruit_SSD1306::ssd1306_command(uint8_t c) {
+  // don't interleave with an async flush on the same bus
+  if (_bus) waitFlush();
+
   if (sid != -1)
   {
     // SPI
@@ -331,30 +375,32 @@ void Adafruit_SSD1306::ssd1306_command(uint8_t c) {
 // Activate a right handed scroll for rows start through stop
 // Hint, the display is 16 rows tall. To scroll the whole display, run:
 // display.scrollright(0x00, 0x0F)
-void Adafruit_SSD1306::startscrollright(uint8_t start, uint8_t stop){
-  ssd1306_command(SSD1306_RIGHT_HORIZONTAL_SCROLL);
-  ssd1306_command(0X00);
-  ssd1306_command(start);
-  ssd1306_command(0X00);
-  ssd1306_command(stop);
-  ssd1306_command(0X00);
-  ssd1306_command(0XFF);
-  ssd1306_command(SSD1306_ACTIVATE_SCROLL);
+void Adafruit_SSD1306::startscrollright(uint8_t start, uint8_t stop, uint8_t interval){
+  startScroll(SSD1306_RIGHT_HORIZONTAL_SCROLL, start, stop, interval);
 }
 
 // startscrollleft
 // Activate a right handed scroll for rows start through stop
 // Hint, the display is 16 rows tall. To scroll the whole display, run:
 // display.scrollright(0x00, 0x0F)
-void Adafruit_SSD1306::startscrollleft(uint8_t start, uint8_t stop){
-  ssd1306_command(SSD1306_LEFT_HORIZONTAL_SCROLL);
+void Adafruit_SSD1306::startscrollleft(uint8_t start, uint8_t stop, uint8_t interval){
+  startScroll(SSD1306_LEFT_HORIZONTAL_SCROLL, start, stop, interval);
+}
+
+void Adafruit_SSD1306::startScroll(uint8_t cmd, uint8_t start, uint8_t stop, uint8_t interval){
+  // commands go out over the blocking path, let a flush finish first
+  waitFlush();
+  ssd1306_command(cmd);
   ssd1306_command(0X00);
   ssd1306_command(start);
-  ssd1306_command(0X00);
+  ssd1306_command(interval);
   ssd1306_command(stop);
   ssd1306_command(0X00);
   ssd1306_command(0XFF);
   ssd1306_command(SSD1306_ACTIVATE_SCROLL);
+  _scrolling = true;
+  _scrollStart = start;
+  _scrollStop = stop;
 }
 
 // startscrolldiagright
@@ -362,6 +408,7 @@ void Adafruit_SSD1306::startscrollleft(uint8_t start, uint8_t stop){
 // Hint, the display is 16 rows tall. To scroll the whole display, run:
 // display.scrollright(0x00, 0x0F)
 void Adafruit_SSD1306::startscrolldiagright(uint8_t start, uint8_t stop){
+  waitFlush();
   ssd1306_command(SSD1306_SET_VERTICAL_SCROLL_AREA);
   ssd1306_command(0X00);
   ssd1306_command(SSD1306_LCDHEIGHT);
@@ -372,6 +419,10 @@ void Adafruit_SSD1306::startscrolldiagright(uint8_t start, uint8_t stop){
   ssd1306_command(stop);
   ssd1306_command(0X01);
   ssd1306_command(SSD1306_ACTIVATE_SCROLL);
+  // the vertical offset moves every page
+  _scrolling = true;
+  _scrollStart = 0;
+  _scrollStop = SSD1306_LCDPAGES-1;
 }
 
 // startscrolldiagleft
@@ -379,6 +430,7 @@ void Adafruit_SSD1306::startscrolldiagright(uint8_t start, uint8_t stop){
 // Hint, the display is 16 rows tall. To scroll the whole display, run:
 // display.scrollright(0x00, 0x0F)
 void Adafruit_SSD1306::startscrolldiagleft(uint8_t start, uint8_t stop){
+  waitFlush();
   ssd1306_command(SSD1306_SET_VERTICAL_SCROLL_AREA);
   ssd1306_command(0X00);
   ssd1306_command(SSD1306_LCDHEIGHT);
@@ -389,10 +441,29 @@ void Adafruit_SSD1306::startscrolldiagleft(uint8_t start, uint8_t stop){
   ssd1306_command(stop);
   ssd1306_command(0X01);
   ssd1306_command(SSD1306_ACTIVATE_SCROLL);
+  _scrolling = true;
+  _scrollStart = 0;
+  _scrollStop = SSD1306_LCDPAGES-1;
 }
 
 void Adafruit_SSD1306::stopscroll(void){
+  waitFlush();
   ssd1306_command(SSD1306_DEACTIVATE_SCROLL);
+  // scrolling moved the panel RAM of these pages, it no longer matches our
+  // buffer (without a known scroll, everything)
+  if (!_scrolling) {
+    invalidate();
+    return;
+  }
+  _scrolling = false;
+  _hashValid = false;
+  for (uint8_t p=_scrollStart; p<=_scrollStop && p<SSD1306_LCDPAGES; p++) {
+    markDirty(p, 0, SSD1306_LCDWIDTH-1);
+  }
+}
+
+boolean Adafruit_SSD1306::isScrolling(void) const {
+  return _scrolling;
 }
 
 // Dim the display
@@ -416,22 +487,186 @@ void Adafruit_SSD1306::dim(boolean dim) {
   ssd1306_command(contrast);
 }
 
+void Adafruit_SSD1306::invalidate(void) {
+  _hashValid = false;
+  for (uint8_t p=0; p<SSD1306_LCDPAGES; p++) {
+    _dirtyMin[p] = 0;
+    _dirtyMax[p] = SSD1306_LCDWIDTH-1;
+  }
+}
+
+void Adafruit_SSD1306::invalidate(int16_t x, int16_t y, int16_t w, int16_t h) {
+  if (x < 0) { w += x; x = 0; }
+  if (y < 0) { h += y; y = 0; }
+  if (x + w > SSD1306_LCDWIDTH) w = SSD1306_LCDWIDTH - x;
+  if (y + h > SSD1306_LCDHEIGHT) h = SSD1306_LCDHEIGHT - y;
+  if ((w <= 0) || (h <= 0)) return;
+
+  _hashValid = false;
+  for (uint8_t p=y/8; p<=(y+h-1)/8; p++) markDirty(p, x, x+w-1);
+}
+
+uint16_t Adafruit_SSD1306::getFrameBytes(void) const {
+  return _frameBytes;
+}
+
+void Adafruit_SSD1306::initFrame(void) {
+  _frameBytes = 0;
+  _frameDepth = 0;
+  _frameInterval = 0;
+  _fpsCount = _fps = 0;
+  _framePending = false;
+  _skipUnchanged = true;
+  _frameHash = _lastCommit = _busMicros = _fpsWindowStart = 0;
+  _buffer = buffer;
+  _bus = NULL;
+  _busIrq = false;
+  _front = NULL;
+  _flushCb = NULL;
+  _flushing = false;
+  _segCount = _segNext = 0;
+  _flushStart = 0;
+  _scrolling = false;
+  _scrollStart = _scrollStop = 0;
+  invalidate();
+}
+
+void Adafruit_SSD1306::beginFrame(void) {
+  _frameDepth++;
+}
+
+bool Adafruit_SSD1306::endFrame(void) {
+  if (!_frameDepth) return false;
+  // nested frame, the outermost endFrame() commits
+  if (--_frameDepth) return false;
+
+  _framePending = true;
+  return update();
+}
+
+// send a pending frame once the frame rate limit allows it
+bool Adafruit_SSD1306::update(void) {
+  if (_bus) flushBusy();
+  if (!_framePending || _frameDepth) return false;
+  if (_frameInterval && (millis() - _lastCommit) < _frameInterval) return false;
+
+  return commitFrame();
+}
+
+void Adafruit_SSD1306::setFrameRateLimit(uint8_t fps) {
+  _frameInterval = fps ? (1000 / fps) : 0;
+}
+
+void Adafruit_SSD1306::setSkipUnchanged(boolean skip) {
+  _skipUnchanged = skip;
+  _hashValid = false;
+}
+
+uint16_t Adafruit_SSD1306::getFrameRate(void) const {
+  return _fps;
+}
+
+uint32_t Adafruit_SSD1306::getFrameBusTime(void) const {
+  return _busMicros;
+}
+
+// FNV-1a over the framebuffer
+uint32_t Adafruit_SSD1306::bufferHash(void) const {
+  uint32_t h = 2166136261UL;
+  for (uint16_t i=0; i<(SSD1306_LCDWIDTH*SSD1306_LCDHEIGHT/8); i++) {
+    h = (h ^ _buffer[i]) * 16777619UL;
+  }
+  return h;
+}
+
+bool Adafruit_SSD1306::commitFrame(void) {
+  _framePending = false;
+
+  if (_skipUnchanged) {
+    uint32_t h = bufferHash();
+    if (_hashValid && (h == _frameHash)) {
+      // same picture as the panel already shows, drop the dirty spans
+      for (uint8_t p=0; p<SSD1306_LCDPAGES; p++) {
+        _dirtyMin[p] = 0xFF;
+        _dirtyMax[p] = 0;
+      }
+      _frameBytes = 0;
+      return false;
+    }
+    _frameHash = h;
+    _hashValid = true;
+  }
+
+  uint32_t start = micros();
+  sendDirty();
+  // the async path records the bus time once the transfer completes
+  if (!_bus) _busMicros = micros() - start;
+  _lastCommit = millis();
+
+  _fpsCount++;
+  uint32_t elapsed = _lastCommit - _fpsWindowStart;
+  if (elapsed >= 1000) {
+    _fps = (uint32_t)_fpsCount * 1000 / elapsed;
+    _fpsCount = 0;
+    _fpsWindowStart = _lastCommit;
+  }
+  return true;
+}
+
 void Adafruit_SSD1306::display(void) {
+  // inside a frame the buffer is committed by endFrame()
+  if (_frameDepth) return;
+
+  // panel content no longer matches the last frame hash
+  _hashValid = false;
+  sendDirty();
+}
+
+void Adafruit_SSD1306::sendDirty(void) {
+  // no RAM writes while the panel scrolls, stopping it dirties the
+  // scrolled pages so they go out with the rest
+  if (_scrolling) {
+    for (uint8_t p=0; p<SSD1306_LCDPAGES; p++) {
+      if (_dirtyMin[p] <= _dirtyMax[p]) {
+        stopscroll();
+        break;
+      }
+    }
+  }
+
+  // bounding window of everything drawn since the last display()
+  uint8_t page0 = SSD1306_LCDPAGES, page1 = 0;
+  uint8_t col0 = SSD1306_LCDWIDTH-1, col1 = 0;
+  for (uint8_t p=0; p<SSD1306_LCDPAGES; p++) {
+    if (_dirtyMin[p] > _dirtyMax[p]) continue;
+    if (page0 == SSD1306_LCDPAGES) page0 = p;
+    page1 = p;
+    if (_dirtyMin[p] < col0) col0 = _dirtyMin[p];
+    if (_dirtyMax[p] > col1) col1 = _dirtyMax[p];
+    // mark clean, we are about to send it
+    _dirtyMin[p] = 0xFF;
+    _dirtyMax[p] = 0;
+  }
+
+  // nothing changed, the panel is already up to date
+  if (page0 == SSD1306_LCDPAGES) {
+    _frameBytes = 0;
+    return;
+  }
+  _frameBytes = (uint16_t)(page1 - page0 + 1) * (col1 - col0 + 1);
+
+  if (_bus) {
+    startFlush(page0, page1, col0, col1);
+    return;
+  }
+
   ssd1306_command(SSD1306_COLUMNADDR);
-  ssd1306_command(0);   // Column start address (0 = reset)
-  ssd1306_command(SSD1306_LCDWIDTH-1); // Column end address (127 = reset)
+  ssd1306_command(col0); // Column start address (0 = reset)
+  ssd1306_command(col1); // Column end address (127 = reset)
 
   ssd1306_command(SSD1306_PAGEADDR);
-  ssd1306_command(0); // Page start address (0 = reset)
-  #if SSD1306_LCDHEIGHT == 64
-    ssd1306_command(7); // Page end address
-  #endif
-  #if SSD1306_LCDHEIGHT == 32
-    ssd1306_command(3); // Page end address
-  #endif
-  #if SSD1306_LCDHEIGHT == 16
-    ssd1306_command(1); // Page end address
-  #endif
+  ssd1306_command(page0); // Page start address (0 = reset)
+  ssd1306_command(page1); // Page end address
 
   if (sid != -1)
   {
@@ -446,8 +681,10 @@ void Adafruit_SSD1306::display(void) {
     digitalWrite(cs, LOW);
 #endif
 
-    for (uint16_t i=0; i<(SSD1306_LCDWIDTH*SSD1306_LCDHEIGHT/8); i++) {
-      fastSPIwrite(buffer[i]);
+    for (uint8_t p=page0; p<=page1; p++) {
+      for (uint8_t c=col0; c<=col1; c++) {
+        fastSPIwrite(_buffer[p*SSD1306_LCDWIDTH + c]);
+      }
     }
 #ifdef HAVE_PORTREG
     *csport |= cspinmask;
@@ -466,27 +703,239 @@ void Adafruit_SSD1306::display(void) {
     //Serial.println(TWBR, DEC);
     //Serial.println(TWSR & 0x3, DEC);
 
-    // I2C
-    for (uint16_t i=0; i<(SSD1306_LCDWIDTH*SSD1306_LCDHEIGHT/8); i++) {
-      // send a bunch of data in one xmission
-      Wire.beginTransmission(_i2caddr);
-      WIRE_WRITE(0x40);
-      for (uint8_t x=0; x<16; x++) {
-        WIRE_WRITE(buffer[i]);
-        i++;
+    // I2C, the window auto-wraps so the bytes go out page after page
+    uint8_t n = 0;
+    for (uint8_t p=page0; p<=page1; p++) {
+      for (uint8_t c=col0; c<=col1; c++) {
+        // send a bunch of data in one xmission
+        if (n == 0) {
+          Wire.beginTransmission(_i2caddr);
+          WIRE_WRITE(0x40);
+        }
+        WIRE_WRITE(_buffer[p*SSD1306_LCDWIDTH + c]);
+        if (++n == SSD1306_WIRE_CHUNK) {
+          Wire.endTransmission();
+          n = 0;
+        }
       }
-      i--;
-      Wire.endTransmission();
     }
+    if (n) Wire.endTransmission();
 #ifdef TWBR
     TWBR = twbrbackup;
 #endif
   }
 }
 
+Adafruit_SSD1306::~Adafruit_SSD1306() {
+  setAsyncBus(NULL);
+}
+
+bool Adafruit_SSD1306::setAsyncBus(SSD1306_Bus *bus) {
+  waitFlush();
+  if (_bus && _busIrq) _bus->setDoneCallback(NULL, NULL);
+  _bus = bus;
+  _busIrq = false;
+
+  if (!_bus) {
+    free(_front);
+    _front = NULL;
+    return true;
+  }
+  if (!_front) _front = (uint8_t *)malloc(SSD1306_FRONT_BYTES);
+  if (!_front) {
+    // no memory for the front buffer, stay blocking
+    _bus = NULL;
+    return false;
+  }
+  _busIrq = _bus->setDoneCallback(busDone, this);
+  return true;
+}
+
+// segment done, from the bus interrupt
+void Adafruit_SSD1306::busDone(void *arg) {
+  ((Adafruit_SSD1306 *)arg)->nextSegment();
+}
+
+// start the next segment, or finish the flush: false once it is over
+boolean Adafruit_SSD1306::nextSegment(void) {
+  if (_segNext < _segCount) {
+    // count it before starting, the interrupt may be back before start() returns
+    uint8_t s = _segNext++;
+    _bus->start(&_front[_segOff[s]], _segLen[s], s != 0);
+    return true;
+  }
+
+  _busMicros = micros() - _flushStart;
+  _flushing = false;
+  if (_flushCb) _flushCb();
+  return false;
+}
+
+void Adafruit_SSD1306::setFlushCallback(void (*cb)(void)) {
+  _flushCb = cb;
+}
+
+uint8_t *Adafruit_SSD1306::getBuffer(void) {
+  return _buffer;
+}
+
+// copy the window into the front buffer and start sending it, the back
+// buffer is free for drawing again as soon as this returns
+void Adafruit_SSD1306::startFlush(uint8_t page0, uint8_t page1, uint8_t col0, uint8_t col1) {
+  // the front buffer is still owned by the previous transfer
+  waitFlush();
+
+  uint8_t *p = _front;
+  _segOff[0] = 0;
+  _segLen[0] = 6;
+  p[1] = SSD1306_COLUMNADDR;
+  p[2] = col0;
+  p[3] = col1;
+  p[4] = SSD1306_PAGEADDR;
+  p[5] = page0;
+  p[6] = page1;
+  p += 7;
+  _segCount = 1;
+
+  // one data segment per bus transaction the transport can do
+  // (_segOff/_segLen are sized for SSD1306_DMA_CHUNK)
+  uint16_t chunk = _bus->maxSegment();
+  if (chunk < SSD1306_DMA_CHUNK) chunk = SSD1306_DMA_CHUNK;
+  uint16_t n = 0;
+  for (uint8_t pg=page0; pg<=page1; pg++) {
+    for (uint8_t c=col0; c<=col1; c++) {
+      if (n == 0) {
+        _segOff[_segCount] = p - _front;
+        p++; // headroom
+      }
+      *p++ = _buffer[pg*SSD1306_LCDWIDTH + c];
+      if (++n == chunk) {
+        _segLen[_segCount++] = n;
+        n = 0;
+      }
+    }
+  }
+  if (n) _segLen[_segCount++] = n;
+
+  _segNext = 0;
+  _flushing = true;
+  _flushStart = micros();
+  nextSegment();
+}
+
+boolean Adafruit_SSD1306::flushBusy(void) {
+  if (!_flushing) return false;
+  if (_busIrq) return true;       // the bus interrupt chains the segments
+  if (_bus->busy()) return true;
+  return nextSegment();
+}
+
+void Adafruit_SSD1306::waitFlush(void) {
+  while (flushBusy()) {
+    yield();
+  }
+}
+
 // clear everything
 void Adafruit_SSD1306::clearDisplay(void) {
-  memset(buffer, 0, (SSD1306_LCDWIDTH*SSD1306_LCDHEIGHT/8));
+  // only columns that currently hold pixels change on the panel
+  for (uint8_t p=0; p<SSD1306_LCDPAGES; p++) {
+    uint8_t *pBuf = &_buffer[p*SSD1306_LCDWIDTH];
+    int16_t x0 = 0, x1 = SSD1306_LCDWIDTH-1;
+    while (x0 <= x1 && !pBuf[x0]) x0++;
+    while (x1 > x0 && !pBuf[x1]) x1--;
+    if (x0 <= x1) markDirty(p, x0, x1);
+  }
+  memset(_buffer, 0, (SSD1306_LCDWIDTH*SSD1306_LCDHEIGHT/8));
+}
+
+// 32-bit view of the framebuffer, gcc is told it aliases the bytes
+typedef uint32_t __attribute__((__may_alias__)) ssd1306_word_t;
+
+// apply one page mask to the bytes p..end-1, whole words in the middle
+template<uint8_t COLOR>
+static inline void ssd1306_fillSpan(uint8_t *p, uint8_t *end, uint8_t mask) {
+  uint32_t wmask = mask * 0x01010101UL;
+
+  while ((p < end) && ((uintptr_t)p & 3)) {
+    if (COLOR == WHITE)      *p++ |=  mask;
+    else if (COLOR == BLACK) *p++ &= ~mask;
+    else                     *p++ ^=  mask;
+  }
+  for (; end - p >= 4; p += 4) {
+    if (COLOR == WHITE)      *(ssd1306_word_t *)p |=  wmask;
+    else if (COLOR == BLACK) *(ssd1306_word_t *)p &= ~wmask;
+    else                     *(ssd1306_word_t *)p ^=  wmask;
+  }
+  while (p < end) {
+    if (COLOR == WHITE)      *p++ |=  mask;
+    else if (COLOR == BLACK) *p++ &= ~mask;
+    else                     *p++ ^=  mask;
+  }
+}
+
+// fill a rectangle page by page: the row mask of each page is computed once
+// and applied to the whole column span
+void Adafruit_SSD1306::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  if ((w <= 0) || (h <= 0))
+    return;
+
+  // map the rectangle to panel coordinates
+  int16_t t;
+  switch (rotation) {
+    case 1:
+      t = x;
+      x = WIDTH - y - h;
+      y = t;
+      ssd1306_swap(w, h);
+      break;
+    case 2:
+      x = WIDTH - x - w;
+      y = HEIGHT - y - h;
+      break;
+    case 3:
+      t = y;
+      y = HEIGHT - x - w;
+      x = t;
+      ssd1306_swap(w, h);
+      break;
+  }
+
+  // clip
+  if (x < 0) { w += x; x = 0; }
+  if (y < 0) { h += y; y = 0; }
+  if (x + w > WIDTH)  w = WIDTH - x;
+  if (y + h > HEIGHT) h = HEIGHT - y;
+  if ((w <= 0) || (h <= 0))
+    return;
+
+  uint8_t x0 = x, x1 = x + w - 1;
+  uint8_t page0 = y / 8, page1 = (y + h - 1) / 8;
+  for (uint8_t page=page0; page<=page1; page++) {
+    uint8_t mask = 0xFF;
+    if (page == page0) mask &= 0xFF << (y & 7);
+    if (page == page1) mask &= 0xFF >> (7 - ((y + h - 1) & 7));
+
+    uint8_t *p = &_buffer[page*SSD1306_LCDWIDTH];
+    switch (color)
+    {
+      case WHITE:   ssd1306_fillSpan<WHITE>(p + x0, p + x1 + 1, mask);   break;
+      case BLACK:   ssd1306_fillSpan<BLACK>(p + x0, p + x1 + 1, mask);   break;
+      case INVERSE: ssd1306_fillSpan<INVERSE>(p + x0, p + x1 + 1, mask); break;
+      default: return;
+    }
+    markDirty(page, x0, x1);
+  }
+}
+
+void Adafruit_SSD1306::fillScreen(uint16_t color) {
+  // clearDisplay() only marks the columns that were lit
+  if (color == BLACK) clearDisplay();
+  else fillRect(0, 0, _width, _height, color);
+}
+
+void Adafruit_SSD1306::invertRect(int16_t x, int16_t y, int16_t w, int16_t h) {
+  fillRect(x, y, w, h, INVERSE);
 }
 
 
@@ -512,33 +961,28 @@ inline void Adafruit_SSD1306::fastSPIwrite(uint8_t d) {
 }
 
 void Adafruit_SSD1306::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
-  boolean bSwap = false;
-  switch(rotation) {
-    case 0:
-      // 0 degree rotation, do nothing
-      break;
-    case 1:
-      // 90 degree rotation, swap x & y for rotation, then invert x
-      bSwap = true;
-      ssd1306_swap(x, y);
-      x = WIDTH - x - 1;
-      break;
-    case 2:
-      // 180 degree rotation, invert x and y - then shift y around for height.
-      x = WIDTH - x - 1;
-      y = HEIGHT - y - 1;
-      x -= (w-1);
-      break;
-    case 3:
-      // 270 degree rotation, swap x & y for rotation, then invert y  and adjust y for w (not to become h)
-      bSwap = true;
-      ssd1306_swap(x, y);
-      y = HEIGHT - y - 1;
-      y -= (w-1);
-      break;
+  (this->*_hLineFn)(x, y, w, color);
+}
+
+template<uint8_t ROT>
+void Adafruit_SSD1306::drawFastHLineRot(int16_t x, int16_t y, int16_t w, uint16_t color) {
+  if (ROT == 1) {
+    // 90 degree rotation, swap x & y for rotation, then invert x
+    ssd1306_swap(x, y);
+    x = SSD1306_LCDWIDTH - x - 1;
+  } else if (ROT == 2) {
+    // 180 degree rotation, invert x and y - then shift y around for height.
+    x = SSD1306_LCDWIDTH - x - 1;
+    y = SSD1306_LCDHEIGHT - y - 1;
+    x -= (w-1);
+  } else if (ROT == 3) {
+    // 270 degree rotation, swap x & y for rotation, then invert y  and adjust y for w (not to become h)
+    ssd1306_swap(x, y);
+    y = SSD1306_LCDHEIGHT - y - 1;
+    y -= (w-1);
   }
 
-  if(bSwap) {
+  if(ROT & 1) {
     drawFastVLineInternal(x, y, w, color);
   } else {
     drawFastHLineInternal(x, y, w, color);
@@ -563,8 +1007,10 @@ void Adafruit_SSD1306::drawFastHLineInternal(int16_t x, int16_t y, int16_t w, ui
   // if our width is now negative, punt
   if(w <= 0) { return; }
 
+  markDirty(y/8, x, x+w-1);
+
   // set up the pointer for  movement through the buffer
-  register uint8_t *pBuf = buffer;
+  register uint8_t *pBuf = _buffer;
   // adjust the buffer pointer for the current row
   pBuf += ((y/8) * SSD1306_LCDWIDTH);
   // and offset x columns in
@@ -581,38 +1027,54 @@ void Adafruit_SSD1306::drawFastHLineInternal(int16_t x, int16_t y, int16_t w, ui
 }
 
 void Adafruit_SSD1306::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
-  bool bSwap = false;
-  switch(rotation) {
-    case 0:
-      break;
-    case 1:
-      // 90 degree rotation, swap x & y for rotation, then invert x and adjust x for h (now to become w)
-      bSwap = true;
-      ssd1306_swap(x, y);
-      x = WIDTH - x - 1;
-      x -= (h-1);
-      break;
-    case 2:
-      // 180 degree rotation, invert x and y - then shift y around for height.
-      x = WIDTH - x - 1;
-      y = HEIGHT - y - 1;
-      y -= (h-1);
-      break;
-    case 3:
-      // 270 degree rotation, swap x & y for rotation, then invert y
-      bSwap = true;
-      ssd1306_swap(x, y);
-      y = HEIGHT - y - 1;
-      break;
+  (this->*_vLineFn)(x, y, h, color);
+}
+
+template<uint8_t ROT>
+void Adafruit_SSD1306::drawFastVLineRot(int16_t x, int16_t y, int16_t h, uint16_t color) {
+  if (ROT == 1) {
+    // 90 degree rotation, swap x & y for rotation, then invert x and adjust x for h (now to become w)
+    ssd1306_swap(x, y);
+    x = SSD1306_LCDWIDTH - x - 1;
+    x -= (h-1);
+  } else if (ROT == 2) {
+    // 180 degree rotation, invert x and y - then shift y around for height.
+    x = SSD1306_LCDWIDTH - x - 1;
+    y = SSD1306_LCDHEIGHT - y - 1;
+    y -= (h-1);
+  } else if (ROT == 3) {
+    // 270 degree rotation, swap x & y for rotation, then invert y
+    ssd1306_swap(x, y);
+    y = SSD1306_LCDHEIGHT - y - 1;
   }
 
-  if(bSwap) {
+  if(ROT & 1) {
     drawFastHLineInternal(x, y, h, color);
   } else {
     drawFastVLineInternal(x, y, h, color);
   }
 }
 
+void Adafruit_SSD1306::setRotation(uint8_t r) {
+  static const PixelFn pixelFns[4] = {
+    &Adafruit_SSD1306::drawPixelRot<0>, &Adafruit_SSD1306::drawPixelRot<1>,
+    &Adafruit_SSD1306::drawPixelRot<2>, &Adafruit_SSD1306::drawPixelRot<3>
+  };
+  static const LineFn hLineFns[4] = {
+    &Adafruit_SSD1306::drawFastHLineRot<0>, &Adafruit_SSD1306::drawFastHLineRot<1>,
+    &Adafruit_SSD1306::drawFastHLineRot<2>, &Adafruit_SSD1306::drawFastHLineRot<3>
+  };
+  static const LineFn vLineFns[4] = {
+    &Adafruit_SSD1306::drawFastVLineRot<0>, &Adafruit_SSD1306::drawFastVLineRot<1>,
+    &Adafruit_SSD1306::drawFastVLineRot<2>, &Adafruit_SSD1306::drawFastVLineRot<3>
+  };
+
+  Adafruit_GFX::setRotation(r);
+  _pixelFn = pixelFns[rotation];
+  _hLineFn = hLineFns[rotation];
+  _vLineFn = vLineFns[rotation];
+}
+
 
 void Adafruit_SSD1306::drawFastVLineInternal(int16_t x, int16_t __y, int16_t __h, uint16_t color) {
 
@@ -641,9 +1103,13 @@ void Adafruit_SSD1306::drawFastVLineInternal(int16_t x, int16_t __y, int16_t __h
   register uint8_t y = __y;
   register uint8_t h = __h;
 
+  for (uint8_t p=y/8; p<=(y+h-1)/8; p++) {
+    markDirty(p, x, x);
+  }
+
 
   // set up the pointer for fast movement through the buffer
-  register uint8_t *pBuf = buffer;
+  register uint8_t *pBuf = _buffer;
   // adjust the buffer pointer for the current row
   pBuf += ((y/8) * SSD1306_LCDWIDTH);
   // and offset x columns in
@@ -727,3 +1193,95 @@ void Adafruit_SSD1306::drawFastVLineInternal(int16_t x, int16_t __y, int16_t __h
     }
   }
 }
+
+// apply one color to the pixels selected by mask, returns true on a change
+static inline bool ssd1306_maskWrite(uint8_t *pBuf, uint8_t mask, uint16_t color) {
+  uint8_t old = *pBuf;
+  switch (color)
+  {
+    case WHITE:   *pBuf |=  mask; break;
+    case BLACK:   *pBuf &= ~mask; break;
+    case INVERSE: *pBuf ^=  mask; break;
+  }
+  return *pBuf != old;
+}
+
+// one glyph/bitmap column: the byte straddles at most two pages, shift it to
+// y&7 and merge the halves in with masks instead of going pixel by pixel
+void Adafruit_SSD1306::writeColumn8(int16_t x, int16_t y, uint8_t bits, uint8_t h, uint16_t color, uint16_t bg) {
+  if (rotation != 0) {
+    Adafruit_GFX::writeColumn8(x, y, bits, h, color, bg);
+    return;
+  }
+  if ((x < 0) || (x >= WIDTH) || (y >= HEIGHT) || (y + (int16_t)h <= 0) || !h)
+    return;
+
+  uint8_t  shift = y & 7;
+  int16_t  page  = (y - shift) / 8;      // floor, y may be negative
+  uint16_t area  = (uint16_t)((h >= 8) ? 0xFF : ((1 << h) - 1)) << shift;
+  uint16_t set   = ((uint16_t)bits << shift) & area;
+  uint16_t clr   = area & ~set;
+
+  for (uint8_t half=0; half<2; half++, page++, set >>= 8, clr >>= 8) {
+    if ((page < 0) || (page >= SSD1306_LCDPAGES) || !(uint8_t)(set | clr))
+      continue;
+    uint8_t *pBuf = &_buffer[x + page*SSD1306_LCDWIDTH];
+    bool changed = ssd1306_maskWrite(pBuf, set, color);
+    if (bg != color)
+      changed |= ssd1306_maskWrite(pBuf, clr, bg);
+    if (changed) markDirty(page, x, x);
+  }
+}
+
+// row-major bitmaps: transpose 8 rows x 8 columns at a time into column
+// bytes and hand those to writeColumn8().  Like Adafruit_GFX, the variants
+// taking a bg are opaque even if bg == color.
+void Adafruit_SSD1306::blitBitmap(int16_t x, int16_t y, const uint8_t *bitmap, bool progmem,
+    int16_t w, int16_t h, uint16_t color, uint16_t bg, bool opaque) {
+  int16_t byteWidth = (w + 7) / 8;
+  uint8_t rows[8];
+
+  startWrite();
+  for (int16_t j=0; j<h; j+=8) {
+    uint8_t rh = (h - j < 8) ? (h - j) : 8;
+    for (int16_t b=0; b<byteWidth; b++) {
+      for (uint8_t r=0; r<rh; r++) {
+        const uint8_t *p = &bitmap[(j + r) * byteWidth + b];
+        rows[r] = progmem ? pgm_read_byte(p) : *p;
+      }
+      for (uint8_t k=0; (k<8) && (b*8 + k < w); k++) {
+        uint8_t col = 0, bit = 0x80 >> k;
+        for (uint8_t r=0; r<rh; r++) {
+          if (rows[r] & bit) col |= (1 << r);
+        }
+        if (opaque && (bg == color)) col = 0xFF;
+        writeColumn8(x + b*8 + k, y + j, col, rh, color, bg);
+      }
+    }
+  }
+  endWrite();
+}
+
+void Adafruit_SSD1306::drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[],
+    int16_t w, int16_t h, uint16_t color) {
+  if (rotation != 0) Adafruit_GFX::drawBitmap(x, y, bitmap, w, h, color);
+  else blitBitmap(x, y, bitmap, true, w, h, color, color, false);
+}
+
+void Adafruit_SSD1306::drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[],
+    int16_t w, int16_t h, uint16_t color, uint16_t bg) {
+  if (rotation != 0) Adafruit_GFX::drawBitmap(x, y, bitmap, w, h, color, bg);
+  else blitBitmap(x, y, bitmap, true, w, h, color, bg, true);
+}
+
+void Adafruit_SSD1306::drawBitmap(int16_t x, int16_t y, uint8_t *bitmap,
+    int16_t w, int16_t h, uint16_t color) {
+  if (rotation != 0) Adafruit_GFX::drawBitmap(x, y, bitmap, w, h, color);
+  else blitBitmap(x, y, bitmap, false, w, h, color, color, false);
+}
+
+void Adafruit_SSD1306::drawBitmap(int16_t x, int16_t y, uint8_t *bitmap,
+    int16_t w, int16_t h, uint16_t color, uint16_t bg) {
+  if (rotation != 0) Adafruit_GFX::drawBitmap(x, y, bitmap, w, h, color, bg);
+  else blitBitmap(x, y, bitmap, false, w, h, color, bg, true);
+}
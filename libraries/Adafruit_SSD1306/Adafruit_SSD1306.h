@@ -47,6 +47,7 @@ All text above, and the splash screen must be included in any redistribution
 
 #include <SPI.h>
 #include <Adafruit_GFX.h>
+#include "SSD1306_Bus.h"
 
 #define BLACK 0
 #define WHITE 1
@@ -95,6 +96,13 @@ All text above, and the splash screen must be included in any redistribution
   #define SSD1306_LCDHEIGHT                 16
 #endif
 
+// Each page is one 8-pixel-tall band of the GDDRAM (one buffer byte per column)
+#define SSD1306_LCDPAGES                    (SSD1306_LCDHEIGHT / 8)
+
+// Async flush: segments of a full frame (window commands + data chunks of
+// SSD1306_DMA_CHUNK bytes, see SSD1306_Bus.h)
+#define SSD1306_DMA_SEGMENTS                (1 + (SSD1306_LCDWIDTH * SSD1306_LCDPAGES + SSD1306_DMA_CHUNK - 1) / SSD1306_DMA_CHUNK)
+
 #define SSD1306_SETCONTRAST 0x81
 #define SSD1306_DISPLAYALLON_RESUME 0xA4
 #define SSD1306_DISPLAYALLON 0xA5
@@ -141,11 +149,22 @@ All text above, and the splash screen must be included in any redistribution
 #define SSD1306_VERTICAL_AND_RIGHT_HORIZONTAL_SCROLL 0x29
 #define SSD1306_VERTICAL_AND_LEFT_HORIZONTAL_SCROLL 0x2A
 
+// Horizontal scroll step interval in frames (byte C of 26h/27h)
+#define SSD1306_SCROLL_2FRAMES   0x07
+#define SSD1306_SCROLL_3FRAMES   0x04
+#define SSD1306_SCROLL_4FRAMES   0x05
+#define SSD1306_SCROLL_5FRAMES   0x00
+#define SSD1306_SCROLL_25FRAMES  0x06
+#define SSD1306_SCROLL_64FRAMES  0x01
+#define SSD1306_SCROLL_128FRAMES 0x02
+#define SSD1306_SCROLL_256FRAMES 0x03
+
 class Adafruit_SSD1306 : public Adafruit_GFX {
  public:
   Adafruit_SSD1306(int8_t SID, int8_t SCLK, int8_t DC, int8_t RST, int8_t CS);
   Adafruit_SSD1306(int8_t DC, int8_t RST, int8_t CS);
   Adafruit_SSD1306(int8_t RST = -1);
+  ~Adafruit_SSD1306();
 
   void begin(uint8_t switchvcc = SSD1306_SWITCHCAPVCC, uint8_t i2caddr = SSD1306_I2C_ADDRESS, bool reset=true);
   void ssd1306_command(uint8_t c);
@@ -154,12 +173,57 @@ class Adafruit_SSD1306 : public Adafruit_GFX {
   void invertDisplay(uint8_t i);
   void display();
 
-  void startscrollright(uint8_t start, uint8_t stop);
-  void startscrollleft(uint8_t start, uint8_t stop);
+  // Dirty-region tracking: display() only pushes the columns/pages touched
+  // since the previous display() call.  invalidate() forces a full refresh
+  // (e.g. after the panel RAM was changed behind our back by a scroll).
+  void invalidate(void);
+  // same for a rectangle in panel coordinates (rotation not applied), after
+  // writing to getBuffer() directly
+  void invalidate(int16_t x, int16_t y, int16_t w, int16_t h);
+  // Number of GDDRAM data bytes sent by the last display() call
+  uint16_t getFrameBytes(void) const;
+
+  // Frame API: between beginFrame() and endFrame() drawing only touches the
+  // RAM buffer and display() calls are ignored, endFrame() commits once.
+  // Frames may nest, the outermost endFrame() commits.  With a frame rate
+  // limit a frame ending too early stays pending until update() sends it.
+  // Both return true if the frame was actually sent to the panel.
+  void beginFrame(void);
+  bool endFrame(void);
+  bool update(void);
+  void setFrameRateLimit(uint8_t fps);   // 0 = unlimited (default)
+  void setSkipUnchanged(boolean skip);   // skip frames whose buffer hash did not change (default on)
+  uint16_t getFrameRate(void) const;     // committed frames per second
+  uint32_t getFrameBusTime(void) const;  // microseconds spent sending the last frame
+
+  // Async flush: with a bus set, display()/endFrame() copy the dirty window
+  // into a front (DMA) buffer and return while the bus sends it, drawing
+  // into the back buffer can go on meanwhile.  The front buffer is
+  // allocated per display by setAsyncBus(), pass NULL to free it and go
+  // back to blocking display().  Returns false if there is no memory for
+  // the front buffer, display() then stays blocking.
+  // If the bus has a completion interrupt (nRF52 TWIM/SPIM) the segments
+  // are chained from it and the flush callback runs in interrupt context:
+  // keep it short, e.g. give a semaphore with xSemaphoreGiveFromISR().
+  // Otherwise flushBusy() advances the transfer and fires the callback,
+  // update() and waitFlush() call it too.
+  bool setAsyncBus(SSD1306_Bus *bus);
+  void setFlushCallback(void (*cb)(void));
+  boolean flushBusy(void);
+  void waitFlush(void);
+
+  uint8_t *getBuffer(void);
+
+  // The panel RAM must not be written while it scrolls: display() stops a
+  // running scroll first if there is anything to send, and the pages that
+  // scrolled are sent again.
+  void startscrollright(uint8_t start, uint8_t stop, uint8_t interval = SSD1306_SCROLL_5FRAMES);
+  void startscrollleft(uint8_t start, uint8_t stop, uint8_t interval = SSD1306_SCROLL_5FRAMES);
 
   void startscrolldiagright(uint8_t start, uint8_t stop);
   void startscrolldiagleft(uint8_t start, uint8_t stop);
   void stopscroll(void);
+  boolean isScrolling(void) const;
 
   void dim(boolean dim);
 
@@ -167,6 +231,24 @@ class Adafruit_SSD1306 : public Adafruit_GFX {
 
   virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
   virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+  virtual void setRotation(uint8_t r);
+
+  // Fills work on whole pages: one mask per page, applied a word at a time
+  virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  virtual void fillScreen(uint16_t color);
+  void invertRect(int16_t x, int16_t y, int16_t w, int16_t h);
+
+  // Page-native blitting (rotation 0): classic font glyphs and 1-bit bitmaps
+  // are merged into the buffer a column byte at a time
+  virtual void writeColumn8(int16_t x, int16_t y, uint8_t bits, uint8_t h, uint16_t color, uint16_t bg);
+  virtual void drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color);
+  virtual void drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color, uint16_t bg);
+  virtual void drawBitmap(int16_t x, int16_t y, uint8_t *bitmap, int16_t w, int16_t h, uint16_t color);
+  virtual void drawBitmap(int16_t x, int16_t y, uint8_t *bitmap, int16_t w, int16_t h, uint16_t color, uint16_t bg);
+
+ protected:
+  // framebuffer, the driver's static one unless a subclass brings its own
+  uint8_t *_buffer;
 
  private:
   int8_t _i2caddr, _vccstate, sid, sclk, dc, rst, cs;
@@ -178,8 +260,53 @@ class Adafruit_SSD1306 : public Adafruit_GFX {
   PortMask mosipinmask, clkpinmask, cspinmask, dcpinmask;
 #endif
 
+  // per rotation pixel/line writers, selected by setRotation()
+  typedef void (Adafruit_SSD1306::*PixelFn)(int16_t x, int16_t y, uint16_t color);
+  typedef void (Adafruit_SSD1306::*LineFn)(int16_t x, int16_t y, int16_t len, uint16_t color);
+  PixelFn _pixelFn;
+  LineFn _hLineFn, _vLineFn;
+  template<uint8_t ROT> void drawPixelRot(int16_t x, int16_t y, uint16_t color);
+  template<uint8_t ROT> void drawFastHLineRot(int16_t x, int16_t y, int16_t w, uint16_t color);
+  template<uint8_t ROT> void drawFastVLineRot(int16_t x, int16_t y, int16_t h, uint16_t color);
+
   inline void drawFastVLineInternal(int16_t x, int16_t y, int16_t h, uint16_t color) __attribute__((always_inline));
   inline void drawFastHLineInternal(int16_t x, int16_t y, int16_t w, uint16_t color) __attribute__((always_inline));
+  void blitBitmap(int16_t x, int16_t y, const uint8_t *bitmap, bool progmem,
+    int16_t w, int16_t h, uint16_t color, uint16_t bg, bool opaque);
+
+  // Per page dirty column span, clean when _dirtyMin > _dirtyMax
+  uint8_t _dirtyMin[SSD1306_LCDPAGES], _dirtyMax[SSD1306_LCDPAGES];
+  uint16_t _frameBytes;
+  inline void markDirty(uint8_t page, uint8_t x0, uint8_t x1) __attribute__((always_inline));
+  void sendDirty(void);
+
+  // hardware scroll running over pages _scrollStart.._scrollStop
+  boolean _scrolling;
+  uint8_t _scrollStart, _scrollStop;
+  void startScroll(uint8_t cmd, uint8_t start, uint8_t stop, uint8_t interval);
+
+  // frame compositor state
+  uint8_t _frameDepth;
+  uint16_t _frameInterval, _fpsCount, _fps;
+  boolean _framePending, _skipUnchanged, _hashValid;
+  uint32_t _frameHash, _lastCommit, _busMicros, _fpsWindowStart;
+  void initFrame(void);
+  bool commitFrame(void);
+  uint32_t bufferHash(void) const;
+
+  // async flush state, segment 0 is the window command segment
+  SSD1306_Bus *_bus;
+  boolean _busIrq;
+  uint8_t *_front;
+  void (*_flushCb)(void);
+  volatile boolean _flushing;
+  uint8_t _segCount;
+  volatile uint8_t _segNext;
+  uint16_t _segOff[SSD1306_DMA_SEGMENTS], _segLen[SSD1306_DMA_SEGMENTS];
+  uint32_t _flushStart;
+  void startFlush(uint8_t page0, uint8_t page1, uint8_t col0, uint8_t col1);
+  boolean nextSegment(void);
+  static void busDone(void *arg);
 
 };
 
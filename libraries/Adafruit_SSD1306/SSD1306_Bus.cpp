@@ -0,0 +1,364 @@
+/*********************************************************************
+Asynchronous transports for the Adafruit_SSD1306 framebuffer flush.
+
+BSD license, check license.txt for more information
+*********************************************************************/
+
+#include <stdlib.h>
+#include "SSD1306_Bus.h"
+#include "Adafruit_SSD1306.h"
+
+#if defined(ARDUINO_ARCH_NRF52)
+
+#include <nrf_soc.h>
+#include <nrf_sdm.h>
+
+/*------------------------------------------------------------------*/
+/* Completion interrupt
+ *------------------------------------------------------------------*/
+SSD1306_IrqBus *SSD1306_IrqBus::_owner = NULL;
+
+// PPI goes through the SoftDevice while it is enabled
+static void ppiAssign(uint8_t ch, volatile uint32_t *eep, volatile uint32_t *tep) {
+  uint8_t sd = 0;
+  sd_softdevice_is_enabled(&sd);
+  if (sd) {
+    sd_ppi_channel_assign(ch, (const volatile void *)eep, (const volatile void *)tep);
+  } else {
+    NRF_PPI->CH[ch].EEP = (uint32_t)eep;
+    NRF_PPI->CH[ch].TEP = (uint32_t)tep;
+  }
+}
+
+static void ppiEnable(uint32_t mask, bool enable) {
+  uint8_t sd = 0;
+  sd_softdevice_is_enabled(&sd);
+  if (sd) {
+    if (enable) sd_ppi_channel_enable_set(mask);
+    else        sd_ppi_channel_enable_clr(mask);
+  } else {
+    if (enable) NRF_PPI->CHENSET = mask;
+    else        NRF_PPI->CHENCLR = mask;
+  }
+}
+
+SSD1306_IrqBus::SSD1306_IrqBus(void) {
+  _doneCb = NULL;
+  _doneArg = NULL;
+  _active = false;
+}
+
+SSD1306_IrqBus::~SSD1306_IrqBus() {
+  if (_owner == this) attachIrq(NULL, NULL, NULL, 0);
+}
+
+SSD1306_IrqBus *SSD1306_IrqBus::getOwner(void) {
+  return _owner;
+}
+
+bool SSD1306_IrqBus::attachIrq(void (*cb)(void *arg), void *arg, volatile uint32_t *const events[], uint8_t count) {
+  uint32_t mask = ((1UL << SSD1306_BUS_PPI_COUNT) - 1) << SSD1306_BUS_PPI_CH;
+
+  if (!cb) {
+    if (_owner != this) return true;
+    NVIC_DisableIRQ(SSD1306_BUS_EGU_IRQn);
+    ppiEnable(mask, false);
+    SSD1306_BUS_EGU->INTENCLR = EGU_INTENCLR_TRIGGERED0_Msk;
+    _owner = NULL;
+    _doneCb = NULL;
+    _doneArg = NULL;
+    return true;
+  }
+  if (_owner && (_owner != this)) return false;
+  if (count > SSD1306_BUS_PPI_COUNT) return false;
+
+  NVIC_DisableIRQ(SSD1306_BUS_EGU_IRQn);
+  _doneCb = cb;
+  _doneArg = arg;
+  _owner = this;
+
+  // every event of the peripheral lands on the same EGU trigger; the
+  // channels stay enabled, events of Wire/SPI transfers just find the
+  // transport idle
+  ppiEnable(mask, false);
+  mask = 0;
+  for (uint8_t i=0; i<count; i++) {
+    ppiAssign(SSD1306_BUS_PPI_CH + i, events[i], &SSD1306_BUS_EGU->TASKS_TRIGGER[0]);
+    mask |= 1UL << (SSD1306_BUS_PPI_CH + i);
+  }
+
+  SSD1306_BUS_EGU->EVENTS_TRIGGERED[0] = 0;
+  SSD1306_BUS_EGU->INTENSET = EGU_INTENSET_TRIGGERED0_Msk;
+  NVIC_ClearPendingIRQ(SSD1306_BUS_EGU_IRQn);
+  NVIC_SetPriority(SSD1306_BUS_EGU_IRQn, SSD1306_BUS_IRQ_PRIORITY);
+  NVIC_EnableIRQ(SSD1306_BUS_EGU_IRQn);
+  ppiEnable(mask, true);
+  return true;
+}
+
+extern "C" void SSD1306_BUS_EGU_IRQHandler(void) {
+  SSD1306_BUS_EGU->EVENTS_TRIGGERED[0] = 0;
+  (void)SSD1306_BUS_EGU->EVENTS_TRIGGERED[0];   // let the clear land before returning
+
+  SSD1306_IrqBus *bus = SSD1306_IrqBus::getOwner();
+  if (bus) bus->onInterrupt();
+}
+
+/*------------------------------------------------------------------*/
+/* TWIM
+ *------------------------------------------------------------------*/
+SSD1306_TWIMBus::SSD1306_TWIMBus(NRF_TWIM_Type *twim, uint8_t i2caddr, uint32_t clockHz) {
+  _twim = twim;
+  _i2caddr = i2caddr;
+  _wireFrequency = 0;
+  _next = NULL;
+  _left = 0;
+  setClock(clockHz);
+}
+
+void SSD1306_TWIMBus::setClock(uint32_t clockHz) {
+  if (clockHz == 0)            _frequency = 0;
+  else if (clockHz >= 1000000) _frequency = 0x0A000000UL;   // 1 MHz, not in the product spec
+  else if (clockHz >= 400000)  _frequency = TWIM_FREQUENCY_FREQUENCY_K400;
+  else if (clockHz >= 250000)  _frequency = TWIM_FREQUENCY_FREQUENCY_K250;
+  else                         _frequency = TWIM_FREQUENCY_FREQUENCY_K100;
+}
+
+uint16_t SSD1306_TWIMBus::maxSegment(void) {
+#if SSD1306_TWIM_STREAM
+  return 0xFFFF;
+#else
+  return SSD1306_DMA_CHUNK;
+#endif
+}
+
+// hand the next piece of the segment to EasyDMA, the last one ends the
+// transaction with a STOP, the others suspend to wait for the next piece
+void SSD1306_TWIMBus::startPiece(void) {
+  uint16_t n = (_left > TWIM_TXD_MAXCNT_MAXCNT_Msk) ? TWIM_TXD_MAXCNT_MAXCNT_Msk : _left;
+  _twim->TXD.PTR = (uint32_t)_next;
+  _twim->TXD.MAXCNT = n;
+  _next += n;
+  _left -= n;
+  _twim->SHORTS = _left ? TWIM_SHORTS_LASTTX_SUSPEND_Msk : TWIM_SHORTS_LASTTX_STOP_Msk;
+}
+
+bool SSD1306_TWIMBus::start(uint8_t *buf, uint16_t len, bool data) {
+  if (busy()) return false;
+
+  buf[0] = data ? 0x40 : 0x00;   // Co = 0, D/C selects data or commands
+  _twim->ADDRESS = _i2caddr;
+  if (_frequency) {
+    _wireFrequency = _twim->FREQUENCY;
+    _twim->FREQUENCY = _frequency;
+  }
+  _next = buf;
+  _left = len + 1;
+  startPiece();
+
+  _twim->EVENTS_ERROR = 0;
+  _twim->EVENTS_SUSPENDED = 0;
+  _twim->EVENTS_STOPPED = 0;
+  _active = true;                // before STARTTX, the interrupt may come right away
+  _twim->TASKS_RESUME = 1;
+  _twim->TASKS_STARTTX = 1;
+  return true;
+}
+
+bool SSD1306_TWIMBus::setDoneCallback(void (*cb)(void *arg), void *arg) {
+  volatile uint32_t *const events[] = {
+    &_twim->EVENTS_STOPPED, &_twim->EVENTS_ERROR, &_twim->EVENTS_SUSPENDED
+  };
+  return attachIrq(cb, arg, events, 3);
+}
+
+// advance the transfer, true once it is over
+bool SSD1306_TWIMBus::service(void) {
+  // NACK etc: stop the transfer, STOPPED follows
+  if (_twim->EVENTS_ERROR) {
+    _twim->EVENTS_ERROR = 0;
+    _left = 0;
+    _twim->TASKS_STOP = 1;
+  }
+
+  // piece done, carry on in the same transaction: the new buffer only
+  // goes out with STARTTX, RESUME then releases the suspended bus
+  if (_twim->EVENTS_SUSPENDED) {
+    _twim->EVENTS_SUSPENDED = 0;
+    if (_left) {
+      startPiece();
+      _twim->TASKS_STARTTX = 1;
+      _twim->TASKS_RESUME = 1;
+    } else {
+      _twim->TASKS_RESUME = 1;
+      _twim->TASKS_STOP = 1;
+    }
+  }
+  if (!_twim->EVENTS_STOPPED) return false;
+
+  _twim->EVENTS_STOPPED = 0;
+  _twim->SHORTS = 0;
+  if (_frequency) _twim->FREQUENCY = _wireFrequency;
+  _active = false;
+  return true;
+}
+
+bool SSD1306_TWIMBus::busy(void) {
+  if (!_active) return false;
+  if (_doneCb) return true;      // the interrupt finishes it
+  return !service();
+}
+
+void SSD1306_TWIMBus::onInterrupt(void) {
+  if (_active && service() && _doneCb) _doneCb(_doneArg);
+}
+
+/*------------------------------------------------------------------*/
+/* SPIM
+ *------------------------------------------------------------------*/
+SSD1306_SPIMBus::SSD1306_SPIMBus(NRF_SPIM_Type *spim, int8_t dc, int8_t cs) {
+  _spim = spim;
+  _dc = dc;
+  _cs = cs;
+  _enable = 0;
+}
+
+bool SSD1306_SPIMBus::start(uint8_t *buf, uint16_t len, bool data) {
+  if (busy()) return false;
+
+  // SPI.begin() may run the peripheral in legacy (non DMA) mode, the
+  // PSEL/FREQUENCY/CONFIG registers are shared so just flip ENABLE
+  _enable = _spim->ENABLE;
+  _spim->ENABLE = SPIM_ENABLE_ENABLE_Enabled << SPIM_ENABLE_ENABLE_Pos;
+
+  digitalWrite(_cs, HIGH);
+  digitalWrite(_dc, data ? HIGH : LOW);
+  digitalWrite(_cs, LOW);
+
+  _spim->TXD.PTR = (uint32_t)(buf + 1);
+  _spim->TXD.MAXCNT = len;
+  _spim->RXD.MAXCNT = 0;
+  _spim->EVENTS_END = 0;
+  _active = true;
+  _spim->TASKS_START = 1;
+  return true;
+}
+
+bool SSD1306_SPIMBus::setDoneCallback(void (*cb)(void *arg), void *arg) {
+  volatile uint32_t *const events[] = { &_spim->EVENTS_END };
+  return attachIrq(cb, arg, events, 1);
+}
+
+bool SSD1306_SPIMBus::service(void) {
+  if (!_spim->EVENTS_END) return false;
+
+  _spim->EVENTS_END = 0;
+  digitalWrite(_cs, HIGH);
+  _spim->ENABLE = _enable;
+  _active = false;
+  return true;
+}
+
+bool SSD1306_SPIMBus::busy(void) {
+  if (!_active) return false;
+  if (_doneCb) return true;
+  return !service();
+}
+
+void SSD1306_SPIMBus::onInterrupt(void) {
+  if (_active && service() && _doneCb) _doneCb(_doneArg);
+}
+
+#endif // ARDUINO_ARCH_NRF52
+
+SSD1306_SimBus::SSD1306_SimBus(uint16_t width, uint16_t height, uint32_t clockHz, bool i2c,
+                               uint16_t maxSegment) {
+  _width = width;
+  _pages = (height + 7) / 8;
+  _ram = (uint8_t *)calloc(_width * _pages, 1);
+  _col0 = _col = 0;
+  _col1 = _width - 1;
+  _page0 = _page = 0;
+  _page1 = _pages - 1;
+  _clock = clockHz;
+  _i2c = i2c;
+  _maxSegment = (maxSegment < SSD1306_DMA_CHUNK) ? SSD1306_DMA_CHUNK : maxSegment;
+  _doneAt = _busyMicros = _segments = _flushes = _dataBytes = 0;
+  _active = false;
+}
+
+SSD1306_SimBus::~SSD1306_SimBus() {
+  free(_ram);
+}
+
+uint16_t SSD1306_SimBus::maxSegment(void) {
+  return _maxSegment;
+}
+
+bool SSD1306_SimBus::start(uint8_t *buf, uint16_t len, bool data) {
+  if (busy()) return false;
+
+  uint8_t *p = buf + 1;
+  if (data) {
+    _dataBytes += len;
+    // horizontal addressing, wraps inside the COLUMNADDR/PAGEADDR window
+    for (uint16_t i=0; i<len; i++) {
+      if (_ram) _ram[_page * _width + _col] = *p;
+      p++;
+      if (++_col > _col1) {
+        _col = _col0;
+        if (++_page > _page1) _page = _page0;
+      }
+    }
+  } else {
+    // only the window commands matter to the mirror, everything else is
+    // treated as a single byte command
+    _flushes++;
+    uint8_t *end = p + len;
+    while (p < end) {
+      uint8_t c = *p++;
+      if ((c == SSD1306_COLUMNADDR) && (end - p >= 2)) {
+        _col0 = _col = p[0];
+        _col1 = p[1];
+        p += 2;
+      } else if ((c == SSD1306_PAGEADDR) && (end - p >= 2)) {
+        _page0 = _page = p[0];
+        _page1 = p[1];
+        p += 2;
+      }
+    }
+  }
+
+  uint32_t bits = _i2c ? ((uint32_t)(len + 2) * 9 + 2) : ((uint32_t)len * 8);
+  uint32_t us = (uint32_t)(((uint64_t)bits * 1000000UL + _clock - 1) / _clock);
+  _busyMicros += us;
+  _segments++;
+  _doneAt = micros() + us;
+  _active = true;
+  return true;
+}
+
+bool SSD1306_SimBus::busy(void) {
+  if (_active && ((int32_t)(micros() - _doneAt) >= 0)) _active = false;
+  return _active;
+}
+
+uint32_t SSD1306_SimBus::getBusyMicros(void) const {
+  return _busyMicros;
+}
+
+uint32_t SSD1306_SimBus::getSegments(void) const {
+  return _segments;
+}
+
+uint32_t SSD1306_SimBus::getFlushes(void) const {
+  return _flushes;
+}
+
+uint32_t SSD1306_SimBus::getDataBytes(void) const {
+  return _dataBytes;
+}
+
+const uint8_t *SSD1306_SimBus::getPanelRAM(void) const {
+  return _ram;
+}
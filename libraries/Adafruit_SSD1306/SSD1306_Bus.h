@@ -0,0 +1,184 @@
+/*********************************************************************
+Asynchronous transports for the Adafruit_SSD1306 framebuffer flush.
+
+Adafruit_SSD1306::setAsyncBus() hands the dirty window to one of these
+instead of pushing it byte by byte through Wire/SPI.  The driver splits a
+flush into segments (one command segment followed by data chunks) and
+starts them one after the other as the bus becomes idle: from the bus
+interrupt where the transport has one, from flushBusy() polling otherwise.
+
+BSD license, check license.txt for more information
+*********************************************************************/
+#ifndef _SSD1306_BUS_H_
+#define _SSD1306_BUS_H_
+
+#if ARDUINO >= 100
+ #include "Arduino.h"
+#else
+ #include "WProgram.h"
+#endif
+
+// Default data bytes per segment: fits the 8-bit EasyDMA MAXCNT of the
+// nRF52832 together with the I2C control byte
+#define SSD1306_DMA_CHUNK 254
+
+class SSD1306_Bus {
+ public:
+  virtual ~SSD1306_Bus() {}
+
+  // Most data bytes start() takes in one segment, the flush is cut into
+  // segments of this size.  Must be at least SSD1306_DMA_CHUNK.
+  virtual uint16_t maxSegment(void) { return SSD1306_DMA_CHUNK; }
+
+  // Start sending one segment and return without waiting.  buf[0] is free
+  // headroom for the transport's framing byte (I2C control byte), the
+  // payload is buf[1]..buf[len].  data selects GDDRAM data (true) or a
+  // command stream (false).  buf must stay untouched until busy() is false.
+  // Returns false if the bus is still busy with the previous segment.
+  virtual bool start(uint8_t *buf, uint16_t len, bool data) = 0;
+
+  // true while a segment is still being sent
+  virtual bool busy(void) = 0;
+
+  // Completion interrupt: cb(arg) is called from the transport's interrupt
+  // each time a segment is done, start() may be called from there.  NULL
+  // detaches.  Returns false if the transport has no interrupt, busy() has
+  // to be polled then.
+  virtual bool setDoneCallback(void (*cb)(void *arg), void *arg) { (void)cb; (void)arg; return false; }
+};
+
+#if defined(ARDUINO_ARCH_NRF52)
+
+// The TWIM/SPIM interrupt vectors belong to Wire and SPI, so the EasyDMA
+// transports route their transfer events through PPI to an EGU and take
+// its interrupt instead.  One transport at a time can be attached, the
+// PPI channels stay assigned until it detaches.  The priority is below the
+// SoftDevice and allows the FreeRTOS FromISR calls.
+#ifndef SSD1306_BUS_EGU
+  #define SSD1306_BUS_EGU            NRF_EGU3
+  #define SSD1306_BUS_EGU_IRQn       SWI3_EGU3_IRQn
+  #define SSD1306_BUS_EGU_IRQHandler SWI3_EGU3_IRQHandler
+#endif
+#ifndef SSD1306_BUS_PPI_CH
+  #define SSD1306_BUS_PPI_CH         10   // first of SSD1306_BUS_PPI_COUNT channels
+#endif
+#define SSD1306_BUS_PPI_COUNT        3
+#ifndef SSD1306_BUS_IRQ_PRIORITY
+  #define SSD1306_BUS_IRQ_PRIORITY   6
+#endif
+
+class SSD1306_IrqBus : public SSD1306_Bus {
+ public:
+  SSD1306_IrqBus(void);
+  virtual ~SSD1306_IrqBus();
+
+  // one step of the transfer from the EGU interrupt
+  virtual void onInterrupt(void) = 0;
+  static SSD1306_IrqBus *getOwner(void);
+
+ protected:
+  void (*_doneCb)(void *arg);
+  void *_doneArg;
+  volatile bool _active;
+
+  // route up to SSD1306_BUS_PPI_COUNT peripheral events to the interrupt,
+  // false if another transport has it
+  bool attachIrq(void (*cb)(void *arg), void *arg, volatile uint32_t *const events[], uint8_t count);
+
+ private:
+  static SSD1306_IrqBus *_owner;
+};
+
+// EasyDMA I2C master.  Reuses the TWIM instance already set up (pins,
+// enabled) by Wire.begin(); nothing else may use Wire while a segment is in
+// flight.
+// With SSD1306_TWIM_STREAM set to 1 a whole flush goes out in one I2C
+// transaction, EasyDMA pieces chained with SUSPEND/STARTTX/RESUME.  Not yet
+// verified on hardware, so by default each SSD1306_DMA_CHUNK is its own
+// transaction.
+#ifndef SSD1306_TWIM_STREAM
+  #define SSD1306_TWIM_STREAM 0
+#endif
+//
+// By default every SSD1306_DMA_CHUNK of a flush is its own I2C transaction
+// (address and control byte each).  With SSD1306_TWIM_STREAM 1 a flush is
+// one transaction: the segment is fed to EasyDMA in MAXCNT sized pieces, the
+// TWIM suspends after each piece (holding SCL low) and resumes on the next.
+// clockHz selects the bus speed while the display is being written and is
+// put back to Wire's setting afterwards: 100000, 250000, 400000 or 1000000
+// (undocumented TWIM setting, beyond the SSD1306 spec, works on most modules),
+// 0 leaves the speed alone.
+class SSD1306_TWIMBus : public SSD1306_IrqBus {
+ public:
+  SSD1306_TWIMBus(NRF_TWIM_Type *twim = NRF_TWIM1, uint8_t i2caddr = 0x3C, uint32_t clockHz = 400000);
+
+  uint16_t maxSegment(void);
+  bool start(uint8_t *buf, uint16_t len, bool data);
+  bool busy(void);
+  bool setDoneCallback(void (*cb)(void *arg), void *arg);
+  void onInterrupt(void);
+  void setClock(uint32_t clockHz);
+
+ private:
+  NRF_TWIM_Type *_twim;
+  uint8_t _i2caddr;
+  uint32_t _frequency, _wireFrequency;
+  uint8_t *_next;       // rest of the segment not handed to EasyDMA yet
+  uint16_t _left;
+  void startPiece(void);
+  bool service(void);
+};
+
+// EasyDMA SPI master.  Reuses the pins/frequency configured by SPI.begin()
+// on the same peripheral and switches it to SPIM mode for the transfer.
+class SSD1306_SPIMBus : public SSD1306_IrqBus {
+ public:
+  SSD1306_SPIMBus(NRF_SPIM_Type *spim, int8_t dc, int8_t cs);
+
+  bool start(uint8_t *buf, uint16_t len, bool data);
+  bool busy(void);
+  bool setDoneCallback(void (*cb)(void *arg), void *arg);
+  void onInterrupt(void);
+
+ private:
+  NRF_SPIM_Type *_spim;
+  int8_t _dc, _cs;
+  uint32_t _enable;
+  bool service(void);
+};
+
+#endif // ARDUINO_ARCH_NRF52
+
+// Bus simulator: takes as long as the real bus would (I2C: 9 clocks per byte
+// plus address byte and start/stop per segment, SPI: 8 clocks per byte) and
+// decodes the command/data stream into a mirror of the panel GDDRAM.
+// Lets the double buffering be checked and timed without a panel attached.
+// maxSegment models the transport: SSD1306_DMA_CHUNK for one transaction
+// per DMA chunk, 0xFFFF for a flush streamed in a single transaction.
+class SSD1306_SimBus : public SSD1306_Bus {
+ public:
+  SSD1306_SimBus(uint16_t width, uint16_t height, uint32_t clockHz = 400000, bool i2c = true,
+                 uint16_t maxSegment = SSD1306_DMA_CHUNK);
+  ~SSD1306_SimBus();
+
+  uint16_t maxSegment(void);
+
+  bool start(uint8_t *buf, uint16_t len, bool data);
+  bool busy(void);
+
+  uint32_t getBusyMicros(void) const;   // total simulated bus time
+  uint32_t getSegments(void) const;     // segments sent so far
+  uint32_t getFlushes(void) const;      // command segments, one per flush
+  uint32_t getDataBytes(void) const;    // GDDRAM data bytes sent so far
+  const uint8_t *getPanelRAM(void) const;
+
+ private:
+  uint8_t *_ram;
+  uint16_t _width, _pages;
+  uint8_t _col0, _col1, _page0, _page1, _col, _page;
+  uint32_t _clock, _doneAt, _busyMicros, _segments, _flushes, _dataBytes;
+  uint16_t _maxSegment;
+  bool _i2c, _active;
+};
+
+#endif // _SSD1306_BUS_H_
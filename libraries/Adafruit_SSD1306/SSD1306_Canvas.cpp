@@ -0,0 +1,180 @@
+/*********************************************************************
+Off-screen Adafruit_SSD1306 for rendering without a panel attached.
+
+BSD license, check license.txt for more information
+*********************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "SSD1306_Canvas.h"
+
+#define SSD1306_CANVAS_BYTES (SSD1306_LCDWIDTH * SSD1306_LCDPAGES)
+
+SSD1306_Canvas::SSD1306_Canvas(uint32_t clockHz) :
+  Adafruit_SSD1306(-1), _sim(SSD1306_LCDWIDTH, SSD1306_LCDHEIGHT, clockHz) {
+  // no framebuffer until begin(), never the driver's shared one
+  _buffer = NULL;
+  resetCounters();
+}
+
+bool SSD1306_Canvas::begin(void) {
+  if (!_buffer) {
+    // start out blank rather than on the driver's splash screen
+    _buffer = (uint8_t *)calloc(SSD1306_CANVAS_BYTES, 1);
+    if (!_buffer) return false;
+  }
+  // without its front buffer display() would go out on Wire
+  if (!setAsyncBus(&_sim)) {
+    free(_buffer);
+    _buffer = NULL;
+    return false;
+  }
+  invalidate();
+  return true;
+}
+
+SSD1306_Canvas::~SSD1306_Canvas() {
+  waitFlush();
+  setAsyncBus(NULL);
+  free(_buffer);
+}
+
+const SSD1306_Canvas::Counters &SSD1306_Canvas::getCounters(void) const {
+  return _counters;
+}
+
+void SSD1306_Canvas::resetCounters(void) {
+  memset(&_counters, 0, sizeof(_counters));
+}
+
+uint32_t SSD1306_Canvas::getBusFrames(void) const {
+  return _sim.getFlushes();
+}
+
+uint32_t SSD1306_Canvas::getBusBytes(void) const {
+  return _sim.getDataBytes();
+}
+
+uint32_t SSD1306_Canvas::getBusMicros(void) const {
+  return _sim.getBusyMicros();
+}
+
+boolean SSD1306_Canvas::getPixel(int16_t x, int16_t y) const {
+  if (!_buffer || (x < 0) || (x >= WIDTH) || (y < 0) || (y >= HEIGHT))
+    return false;
+  return (_buffer[x + (y/8)*SSD1306_LCDWIDTH] >> (y&7)) & 1;
+}
+
+size_t SSD1306_Canvas::writePBM(Print &out) const {
+  size_t n = out.print("P4\n");
+  n += out.print(WIDTH);
+  n += out.print(' ');
+  n += out.print(HEIGHT);
+  n += out.print('\n');
+
+  // P4 rows are MSB first, 1 = black: lit OLED pixels come out black
+  for (int16_t y=0; y<HEIGHT; y++) {
+    for (int16_t x=0; x<WIDTH; x+=8) {
+      uint8_t b = 0;
+      for (uint8_t k=0; k<8; k++) {
+        if (getPixel(x + k, y)) b |= 0x80 >> k;
+      }
+      n += out.write(b);
+    }
+  }
+  return n;
+}
+
+// whitespace separated decimal field of a PBM header, skipping # comments
+static int32_t pbmField(const uint8_t *pbm, size_t len, size_t *pos) {
+  while (*pos < len) {
+    uint8_t c = pbm[*pos];
+    if (c == '#') {
+      while ((*pos < len) && (pbm[*pos] != '\n')) (*pos)++;
+    } else if ((c == ' ') || (c == '\t') || (c == '\r') || (c == '\n')) {
+      (*pos)++;
+    } else {
+      break;
+    }
+  }
+  int32_t v = -1;
+  while ((*pos < len) && (pbm[*pos] >= '0') && (pbm[*pos] <= '9')) {
+    v = ((v < 0) ? 0 : v*10) + (pbm[*pos] - '0');
+    (*pos)++;
+  }
+  return v;
+}
+
+int32_t SSD1306_Canvas::comparePBM(const uint8_t *pbm, size_t len) const {
+  if ((len < 2) || (pbm[0] != 'P') || (pbm[1] != '4'))
+    return -1;
+
+  size_t pos = 2;
+  if ((pbmField(pbm, len, &pos) != WIDTH) || (pbmField(pbm, len, &pos) != HEIGHT))
+    return -1;
+  pos++;    // single whitespace before the raster
+
+  size_t rowBytes = (WIDTH + 7) / 8;
+  if (len - pos < rowBytes * HEIGHT)
+    return -1;
+
+  int32_t diff = 0;
+  for (int16_t y=0; y<HEIGHT; y++) {
+    const uint8_t *row = &pbm[pos + y*rowBytes];
+    for (int16_t x=0; x<WIDTH; x++) {
+      boolean golden = (row[x/8] >> (7 - (x&7))) & 1;
+      if (golden != getPixel(x, y)) diff++;
+    }
+  }
+  return diff;
+}
+
+void SSD1306_Canvas::drawPixel(int16_t x, int16_t y, uint16_t color) {
+  _counters.pixels++;
+  Adafruit_SSD1306::drawPixel(x, y, color);
+}
+
+void SSD1306_Canvas::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+  _counters.vLines++;
+  Adafruit_SSD1306::drawFastVLine(x, y, h, color);
+}
+
+void SSD1306_Canvas::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+  _counters.hLines++;
+  Adafruit_SSD1306::drawFastHLine(x, y, w, color);
+}
+
+void SSD1306_Canvas::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  _counters.fillRects++;
+  Adafruit_SSD1306::fillRect(x, y, w, h, color);
+}
+
+void SSD1306_Canvas::fillScreen(uint16_t color) {
+  _counters.fillScreens++;
+  Adafruit_SSD1306::fillScreen(color);
+}
+
+void SSD1306_Canvas::writeColumn8(int16_t x, int16_t y, uint8_t bits, uint8_t h, uint16_t color, uint16_t bg) {
+  _counters.columns++;
+  Adafruit_SSD1306::writeColumn8(x, y, bits, h, color, bg);
+}
+
+void SSD1306_Canvas::drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color) {
+  _counters.bitmaps++;
+  Adafruit_SSD1306::drawBitmap(x, y, bitmap, w, h, color);
+}
+
+void SSD1306_Canvas::drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color, uint16_t bg) {
+  _counters.bitmaps++;
+  Adafruit_SSD1306::drawBitmap(x, y, bitmap, w, h, color, bg);
+}
+
+void SSD1306_Canvas::drawBitmap(int16_t x, int16_t y, uint8_t *bitmap, int16_t w, int16_t h, uint16_t color) {
+  _counters.bitmaps++;
+  Adafruit_SSD1306::drawBitmap(x, y, bitmap, w, h, color);
+}
+
+void SSD1306_Canvas::drawBitmap(int16_t x, int16_t y, uint8_t *bitmap, int16_t w, int16_t h, uint16_t color, uint16_t bg) {
+  _counters.bitmaps++;
+  Adafruit_SSD1306::drawBitmap(x, y, bitmap, w, h, color, bg);
+}
@@ -0,0 +1,68 @@
+/*********************************************************************
+Off-screen Adafruit_SSD1306 for rendering without a panel attached.
+
+SSD1306_Canvas has its own framebuffer (same page layout as the driver)
+and flushes into an SSD1306_SimBus instead of Wire/SPI, so display() and
+endFrame() work as on the device and report what would have been sent.
+It counts the calls into the drawing primitives and dumps or compares
+the framebuffer as a binary PBM (P4) image, for checking screens against
+golden images and spotting rendering regressions on a PC or over Serial.
+
+Like any display on setAsyncBus(), it carries its own front buffer next
+to the framebuffer, so canvases can flush alongside a real panel.
+
+BSD license, check license.txt for more information
+*********************************************************************/
+#ifndef _SSD1306_CANVAS_H_
+#define _SSD1306_CANVAS_H_
+
+#include "Adafruit_SSD1306.h"
+
+class SSD1306_Canvas : public Adafruit_SSD1306 {
+ public:
+  SSD1306_Canvas(uint32_t clockHz = 400000);
+  ~SSD1306_Canvas();
+
+  // allocates the framebuffer (blank) and the front buffer, call it before
+  // drawing.  false if there is no memory for them, the canvas can't be used.
+  bool begin(void);
+
+  // calls into each primitive since resetCounters(), nested calls count
+  // too (a fillRect() shows up in vLines as well)
+  struct Counters {
+    uint32_t pixels, hLines, vLines, fillRects, fillScreens, columns, bitmaps;
+  };
+  const Counters &getCounters(void) const;
+  void resetCounters(void);
+
+  // what the frames committed so far would have cost on the bus
+  uint32_t getBusFrames(void) const;
+  uint32_t getBusBytes(void) const;     // GDDRAM data bytes
+  uint32_t getBusMicros(void) const;    // at the clock given to the constructor
+
+  // framebuffer pixel in panel coordinates (rotation not applied)
+  boolean getPixel(int16_t x, int16_t y) const;
+
+  // binary PBM of the framebuffer, returns the bytes written
+  size_t writePBM(Print &out) const;
+  // number of pixels that differ from a P4 image in RAM, -1 if it is not
+  // a P4 image of the panel size
+  int32_t comparePBM(const uint8_t *pbm, size_t len) const;
+
+  void drawPixel(int16_t x, int16_t y, uint16_t color);
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  void fillScreen(uint16_t color);
+  void writeColumn8(int16_t x, int16_t y, uint8_t bits, uint8_t h, uint16_t color, uint16_t bg);
+  void drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color);
+  void drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color, uint16_t bg);
+  void drawBitmap(int16_t x, int16_t y, uint8_t *bitmap, int16_t w, int16_t h, uint16_t color);
+  void drawBitmap(int16_t x, int16_t y, uint8_t *bitmap, int16_t w, int16_t h, uint16_t color, uint16_t bg);
+
+ private:
+  SSD1306_SimBus _sim;
+  Counters _counters;
+};
+
+#endif // _SSD1306_CANVAS_H_
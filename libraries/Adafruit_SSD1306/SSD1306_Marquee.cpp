@@ -0,0 +1,199 @@
+/*********************************************************************
+Scrolling text box (marquee) for Adafruit_SSD1306.
+
+BSD license, check license.txt for more information
+*********************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "SSD1306_Marquee.h"
+
+// Adafruit_GFX target drawing into a strip in the SSD1306 page layout,
+// measures only if there is no buffer
+class SSD1306_MarqueeStrip : public Adafruit_GFX {
+ public:
+  SSD1306_MarqueeStrip(int16_t w, int16_t h, uint8_t *buf) : Adafruit_GFX(w, h), _buf(buf) {
+    setTextWrap(false);
+  }
+  void drawPixel(int16_t x, int16_t y, uint16_t color) {
+    if (!_buf || (x < 0) || (y < 0) || (x >= WIDTH) || (y >= HEIGHT)) return;
+    uint8_t *b = &_buf[(y / 8) * WIDTH + x], bit = 1 << (y & 7);
+    switch (color) {
+      case WHITE:   *b |=  bit; break;
+      case BLACK:   *b &= ~bit; break;
+      case INVERSE: *b ^=  bit; break;
+    }
+  }
+ private:
+  uint8_t *_buf;
+};
+
+// step interval codes by frames per step, see SSD1306_SCROLL_*
+static const uint16_t scrollFrames[8] = { 5, 64, 128, 256, 3, 4, 25, 2 };
+
+SSD1306_Marquee::SSD1306_Marquee(void) {
+  _display = NULL;
+  _strip = NULL;
+  _stripW = _textW = _offset = 0;
+  _x = _y = _w = 0;
+  _pages = 0;
+  _gap = 24;
+  _color = WHITE;
+  _bg = BLACK;
+  _hardware = false;
+  _lastStep = 0;
+  setSpeed(30);
+}
+
+SSD1306_Marquee::~SSD1306_Marquee() {
+  end();
+}
+
+void SSD1306_Marquee::setSpeed(uint16_t columnsPerSecond) {
+  if (!columnsPerSecond) columnsPerSecond = 1;
+  _stepMs = 1000 / columnsPerSecond;
+  if (!_stepMs) _stepMs = 1;
+
+  // nearest interval the controller offers
+  uint32_t frames = SSD1306_MARQUEE_FRAME_HZ / columnsPerSecond;
+  uint32_t best = 0xFFFF;
+  for (uint8_t i=0; i<8; i++) {
+    uint32_t d = (scrollFrames[i] > frames) ? (scrollFrames[i] - frames) : (frames - scrollFrames[i]);
+    if (d < best) {
+      best = d;
+      _interval = i;
+    }
+  }
+  // a running hardware scroll picks the new speed up on restart
+  if (_hardware && _display && _display->isScrolling()) _display->stopscroll();
+}
+
+void SSD1306_Marquee::setGap(uint8_t columns) {
+  _gap = columns;
+}
+
+void SSD1306_Marquee::setTextColor(uint16_t color, uint16_t bg) {
+  _color = color;
+  _bg = bg;
+}
+
+boolean SSD1306_Marquee::isActive(void) const {
+  return _strip != NULL;
+}
+
+boolean SSD1306_Marquee::isHardware(void) const {
+  return _hardware;
+}
+
+uint16_t SSD1306_Marquee::getTextWidth(void) const {
+  return _textW;
+}
+
+bool SSD1306_Marquee::begin(Adafruit_SSD1306 &d, const char *text, int16_t x, int16_t y, int16_t w,
+                            const GFXfont *font, uint8_t size) {
+  end();
+  if (w <= 0) w = d.width() - x;
+  if (w <= 0) return false;
+
+  // measure: band height in pages and advance width of the text
+  SSD1306_MarqueeStrip m(0x7FFF, 0x7FFF, NULL);
+  int16_t x1, y1;
+  uint16_t tw, th;
+  m.setFont(font);
+  m.setTextSize(size);
+  m.getTextBounds((char *)text, 0, 0, &x1, &y1, &tw, &th);
+  m.setCursor(0, -y1);
+  m.print(text);
+  _textW = m.getCursorX();
+  _pages = (th + 7) / 8;
+  if (!_pages) _pages = 1;
+
+  // the controller scrolls whole pages across the whole panel width
+  _hardware = (d.getRotation() == 0) && (x == 0) && (w == SSD1306_LCDWIDTH) &&
+              ((y & 7) == 0) && (y + _pages * 8 <= SSD1306_LCDHEIGHT) &&
+              (_textW + _gap <= SSD1306_LCDWIDTH) && !d.isScrolling();
+  _stripW = _textW + _gap;
+  if (_hardware || (_stripW < w)) _stripW = _hardware ? SSD1306_LCDWIDTH : w;
+
+  if (!(_strip = (uint8_t *)malloc((uint32_t)_stripW * _pages))) {
+    _hardware = false;
+    return false;
+  }
+  memset(_strip, (_bg == BLACK) ? 0x00 : 0xFF, (uint32_t)_stripW * _pages);
+  SSD1306_MarqueeStrip s(_stripW, _pages * 8, _strip);
+  s.setFont(font);
+  s.setTextSize(size);
+  s.setTextColor(_color);
+  s.setCursor(0, -y1);
+  s.print(text);
+
+  _display = &d;
+  _x = x;
+  _y = y;
+  _w = w;
+  _offset = 0;
+  _lastStep = millis();
+  paint();
+  // the hardware scroll starts on the first update()
+  if (!_hardware) _display->display();
+  return true;
+}
+
+void SSD1306_Marquee::end(void) {
+  if (_hardware && _display && _display->isScrolling()) _display->stopscroll();
+  free(_strip);
+  _strip = NULL;
+  _hardware = false;
+  _display = NULL;
+}
+
+// draw the box at the current offset, in whole
+void SSD1306_Marquee::paint(void) {
+  for (int16_t i=0; i<_w; i++) {
+    uint16_t src = (_offset + i) % _stripW;
+    for (uint8_t p=0; p<_pages; p++) {
+      _display->writeColumn8(_x + i, _y + p * 8, _strip[p * _stripW + src], 8, WHITE, BLACK);
+    }
+  }
+}
+
+bool SSD1306_Marquee::update(void) {
+  if (!_strip) return false;
+
+  if (_hardware) {
+    // scrolling on its own, nothing to do
+    if (_display->isScrolling()) return false;
+    // (re)start from the beginning: the band in the buffer is the unscrolled
+    // strip, get it onto the panel and let the controller take over
+    _offset = 0;
+    paint();
+    _display->display();
+    _display->startscrollleft(_y / 8, _y / 8 + _pages - 1, _interval);
+    return true;
+  }
+
+  uint32_t now = millis();
+  uint32_t steps = (now - _lastStep) / _stepMs;
+  if (!steps) return false;
+  _lastStep += steps * _stepMs;
+  if (steps >= _stripW) steps %= _stripW;
+  _offset = (_offset + steps) % _stripW;
+
+  if ((_display->getRotation() == 0) && ((_y & 7) == 0) && (steps < (uint32_t)_w) &&
+      (_x >= 0) && (_x + _w <= SSD1306_LCDWIDTH) && (_y + _pages * 8 <= SSD1306_LCDHEIGHT)) {
+    // shift the box left in the framebuffer and bring in the new columns
+    for (uint8_t p=0; p<_pages; p++) {
+      uint8_t page = _y / 8 + p;
+      uint8_t *row = &_display->getBuffer()[page * SSD1306_LCDWIDTH + _x];
+      memmove(row, row + steps, _w - steps);
+      for (int16_t i=_w - steps; i<_w; i++) {
+        row[i] = _strip[p * _stripW + (_offset + i) % _stripW];
+      }
+    }
+    _display->invalidate(_x, _y, _w, _pages * 8);
+  } else {
+    paint();
+  }
+  _display->display();
+  return true;
+}
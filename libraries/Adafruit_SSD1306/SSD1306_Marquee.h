@@ -0,0 +1,68 @@
+/*********************************************************************
+Scrolling text box (marquee) for Adafruit_SSD1306.
+
+The text is rendered once into an off-screen strip in the panel's page
+layout and scrolled through a box on the display, repeating with a gap.
+
+When the box is a full width band on page boundaries (rotation 0) and
+the text plus gap fits on the panel, the controller's horizontal scroll
+rotates the band by itself: no bus traffic at all per step.  Everything
+else on the screen has to stay put meanwhile, the panel RAM can't be
+written while it scrolls.  Drawing and display() elsewhere stop the
+scroll (the band jumps back to its start) and update() starts it again.
+
+Any other box is scrolled in software: update() shifts the box one
+column per step in the framebuffer and display() sends only the box.
+
+BSD license, check license.txt for more information
+*********************************************************************/
+#ifndef _SSD1306_MARQUEE_H_
+#define _SSD1306_MARQUEE_H_
+
+#include "Adafruit_SSD1306.h"
+
+// Approximate panel frame rate with the settings begin() uses, to map a
+// scroll speed to the controller's step interval
+#ifndef SSD1306_MARQUEE_FRAME_HZ
+  #define SSD1306_MARQUEE_FRAME_HZ (5600 / SSD1306_LCDHEIGHT)
+#endif
+
+class SSD1306_Marquee {
+ public:
+  SSD1306_Marquee(void);
+  ~SSD1306_Marquee();
+
+  // Scroll text through the box at x,y (top left), w pixels wide (0: to
+  // the right edge) on d.  The box covers whole pages, as many as the
+  // text needs.  Returns false if the strip can't be allocated.
+  bool begin(Adafruit_SSD1306 &d, const char *text, int16_t x, int16_t y, int16_t w = 0,
+             const GFXfont *font = NULL, uint8_t size = 1);
+  // stop scrolling, the box keeps its current content
+  void end(void);
+
+  // next step(s) when due, call it from loop().  Returns true if the
+  // framebuffer changed (display() has been called).
+  bool update(void);
+
+  void setSpeed(uint16_t columnsPerSecond);     // default 30
+  void setGap(uint8_t columns);                 // between repeats, default 24, takes effect on begin()
+  void setTextColor(uint16_t color, uint16_t bg); // default WHITE on BLACK, takes effect on begin()
+
+  boolean isActive(void) const;
+  boolean isHardware(void) const;
+  uint16_t getTextWidth(void) const;
+
+ private:
+  Adafruit_SSD1306 *_display;
+  uint8_t *_strip;               // _pages rows of _stripW column bytes
+  uint16_t _stripW, _textW, _offset;
+  int16_t _x, _y, _w;
+  uint8_t _pages, _gap, _interval;
+  uint16_t _color, _bg, _stepMs;
+  uint32_t _lastStep;
+  boolean _hardware;
+
+  void paint(void);
+};
+
+#endif /* _SSD1306_MARQUEE_H_ */
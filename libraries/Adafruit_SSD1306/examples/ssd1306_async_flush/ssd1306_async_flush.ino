@@ -0,0 +1,99 @@
+/*********************************************************************
+Asynchronous (double buffered) framebuffer flush for SSD1306 OLEDs.
+
+Renders the same animation twice: once waiting for every frame to reach
+the panel, once drawing the next frame while the previous one is still
+on the bus.  Prints the time of both runs and checks that the panel
+contents match the framebuffer afterwards.
+
+By default the transfers go to SSD1306_SimBus, which takes as long as a
+400 kHz I2C bus would but needs no panel.  On nRF52 boards define
+USE_TWIM to send them to the real display with EasyDMA instead.
+
+BSD license, check license.txt for more information
+*********************************************************************/
+
+#include <SPI.h>
+#include <Wire.h>
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1306.h>
+
+//#define USE_TWIM
+
+#define FRAMES 50
+
+Adafruit_SSD1306 display = Adafruit_SSD1306();
+
+#if defined(USE_TWIM) && defined(ARDUINO_ARCH_NRF52)
+SSD1306_TWIMBus bus(NRF_TWIM1, 0x3C);
+#else
+SSD1306_SimBus bus(SSD1306_LCDWIDTH, SSD1306_LCDHEIGHT, 400000);
+#endif
+
+volatile uint16_t flushes = 0;
+
+// with USE_TWIM this runs in the bus interrupt
+void flushDone(void) {
+  flushes++;
+}
+
+// stand-in for the application's own work (input, BLE, ...), a loop that
+// calls display.update() regularly keeps the async flush moving on the
+// simulated bus (the TWIM one chains its segments from its interrupt)
+void appWork(uint32_t us) {
+  uint32_t start = micros();
+  while ((micros() - start) < us) {
+    display.update();
+  }
+}
+
+void renderFrame(int f, bool overlap) {
+  display.beginFrame();
+  display.clearDisplay();
+  display.setCursor(f % 64, 0);
+  display.print("Frame ");
+  display.print(f);
+  display.fillRect(0, SSD1306_LCDHEIGHT - 4, (f * 5) % SSD1306_LCDWIDTH, 4, WHITE);
+  display.drawCircle(96, 12, 2 + f % 8, WHITE);
+  display.endFrame();
+  if (!overlap) display.waitFlush();
+  appWork(8000);
+}
+
+uint32_t run(bool overlap) {
+  uint32_t start = micros();
+  for (int f=0; f<FRAMES; f++) {
+    renderFrame(f, overlap);
+  }
+  display.waitFlush();
+  return micros() - start;
+}
+
+void setup() {
+  Serial.begin(9600);
+
+  display.begin(SSD1306_SWITCHCAPVCC, 0x3C);
+  display.setTextSize(1);
+  display.setTextColor(WHITE);
+  display.setAsyncBus(&bus);
+  display.setFlushCallback(flushDone);
+
+  uint32_t blocking = run(false);
+  uint32_t overlapped = run(true);
+
+  Serial.print("Frames: ");          Serial.println(FRAMES);
+  Serial.print("Completed flushes: "); Serial.println(flushes);
+  Serial.print("Wait per frame (us): "); Serial.println(blocking);
+  Serial.print("Overlapped (us): ");   Serial.println(overlapped);
+  Serial.print("Last frame bus time (us): "); Serial.println(display.getFrameBusTime());
+
+#if !(defined(USE_TWIM) && defined(ARDUINO_ARCH_NRF52))
+  Serial.print("Simulated bus time (us): "); Serial.println(bus.getBusyMicros());
+  bool match = memcmp(bus.getPanelRAM(), display.getBuffer(),
+                      SSD1306_LCDWIDTH * SSD1306_LCDHEIGHT / 8) == 0;
+  Serial.println(match ? "Panel RAM matches framebuffer" : "Panel RAM MISMATCH");
+#endif
+}
+
+void loop() {
+}
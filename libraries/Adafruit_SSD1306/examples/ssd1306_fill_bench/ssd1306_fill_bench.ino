@@ -0,0 +1,83 @@
+/*********************************************************************
+Fill benchmark for the SSD1306 driver
+
+Times the fills a menu UI does all the time (clearing the screen,
+highlighting and un-highlighting a text row, boxes) into the
+framebuffer with the page/word-wide fills against the generic
+Adafruit_GFX fillRect(), which loops over vertical lines.
+No bus traffic, no panel needed.  Results on Serial.
+
+BSD license, check license.txt for more information
+*********************************************************************/
+
+#include <SPI.h>
+#include <Wire.h>
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1306.h>
+
+// Same display, but fills take the generic Adafruit_GFX path
+class GenericSSD1306 : public Adafruit_SSD1306 {
+ public:
+  GenericSSD1306(int8_t rst) : Adafruit_SSD1306(rst) {}
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    Adafruit_GFX::fillRect(x, y, w, h, color);
+  }
+  void fillScreen(uint16_t color) {
+    Adafruit_GFX::fillScreen(color);
+  }
+};
+
+#define OLED_RESET 4
+Adafruit_SSD1306 display(OLED_RESET);
+GenericSSD1306 generic(OLED_RESET);
+
+#define PASSES 1000
+
+// Runs one kind of fill PASSES times, returns the total microseconds
+uint32_t bench(Adafruit_SSD1306 &d, uint8_t kind) {
+  uint32_t start = micros();
+  for (uint16_t n=0; n<PASSES; n++) {
+    switch (kind) {
+      case 0: d.fillScreen(BLACK); break;
+      case 1: d.fillScreen(WHITE); break;
+      case 2: d.invertRect(0, 8, d.width(), 8); break;      // row on a page
+      case 3: d.invertRect(0, 11, d.width(), 11); break;    // 11 px row, unaligned
+      case 4: d.fillRect(0, 22, d.width(), 10, BLACK); break;
+      case 5: d.fillRect(100, 2, 20, 12, WHITE); break;     // icon box
+    }
+  }
+  return micros() - start;
+}
+
+const char *kinds[] = {
+  "fillScreen(BLACK)  ", "fillScreen(WHITE)  ", "invertRect row y=8 ",
+  "invertRect row y=11", "fillRect 128x10    ", "fillRect 20x12     "
+};
+
+void setup() {
+  Serial.begin(115200);
+  // only the framebuffer is exercised, no panel needed
+
+  for (uint8_t k=0; k<6; k++) {
+    uint32_t fast = bench(display, k), slow = bench(generic, k);
+    Serial.print(kinds[k]);
+    Serial.print(": page/word ");
+    Serial.print(fast);
+    Serial.print(", generic ");
+    Serial.print(slow);
+    Serial.print(" us per ");
+    Serial.print(PASSES);
+    Serial.println(" fills");
+  }
+
+  // both paths must have produced the same picture
+  for (uint8_t k=0; k<6; k++) {
+    bench(display, k);
+    bench(generic, k);
+  }
+  Serial.println(memcmp(display.getBuffer(), generic.getBuffer(),
+                        SSD1306_LCDWIDTH * SSD1306_LCDHEIGHT / 8) ? "Framebuffers differ!" : "Framebuffers match");
+}
+
+void loop() {
+}
@@ -0,0 +1,57 @@
+// DejaVu Sans (Bitstream Vera license), digits only, run-length coded:
+//   fontconvert -r -s "0123456789:" DejaVuSans.ttf 18
+
+const uint8_t DejaVuSans18pt7bRLEBitmaps[] PROGMEM = {
+  0x66, 0xA2, 0x62, 0x71, 0xA1, 0x51, 0x44, 0x41, 0x72, 0x42, 0x61, 0xE1,
+  0x51, 0x81, 0xF0, 0x71, 0x21, 0xA1, 0x21, 0xF9, 0x31, 0x21, 0xA1, 0x21,
+  0xF0, 0x71, 0x81, 0x51, 0xE1, 0x62, 0x42, 0x71, 0x44, 0x41, 0x51, 0xA1,
+  0x72, 0x62, 0x40, 0x36, 0x63, 0xF0, 0xF3, 0x93, 0xFF, 0xF0, 0xC6, 0x36,
+  0xF0, 0xF0, 0x29, 0x52, 0x92, 0xF0, 0x11, 0x66, 0x41, 0x23, 0x62, 0x41,
+  0xE1, 0xC1, 0xF3, 0x01, 0x21, 0xB1, 0xF0, 0x31, 0xB1, 0x21, 0xB1, 0xE1,
+  0x31, 0xA1, 0x31, 0xA1, 0x31, 0xA1, 0x31, 0xA1, 0x31, 0xA1, 0x31, 0xA1,
+  0x31, 0x92, 0x31, 0xF0, 0x0B, 0xF1, 0x10, 0x38, 0x72, 0x82, 0xF0, 0x21,
+  0x67, 0x41, 0x32, 0x72, 0x31, 0xD1, 0xF3, 0x41, 0x21, 0xC1, 0x97, 0x31,
+  0xE2, 0xF0, 0x02, 0x77, 0x32, 0xC2, 0xF0, 0x51, 0xD1, 0xF2, 0x31, 0xF0,
+  0x43, 0x92, 0x69, 0x41, 0xF0, 0x01, 0x22, 0x93, 0x30, 0xA5, 0xF1, 0x11,
+  0xF0, 0x21, 0x21, 0xF1, 0x21, 0x21, 0xE1, 0x21, 0xF1, 0x21, 0x21, 0xF1,
+  0x21, 0x21, 0xE1, 0x21, 0xF1, 0x21, 0x21, 0xE1, 0x21, 0xF1, 0x21, 0x21,
+  0xF0, 0x39, 0x34, 0xF1, 0x7C, 0x34, 0xF5, 0x00, 0x1E, 0xF1, 0x9B, 0xF4,
+  0xC7, 0xF0, 0x22, 0xF0, 0x22, 0x57, 0x82, 0x72, 0x31, 0xD1, 0x31, 0xD1,
+  0xF4, 0x51, 0xF0, 0x01, 0x33, 0x82, 0x78, 0x51, 0xE2, 0x22, 0x92, 0x40,
+  0x77, 0x92, 0x72, 0x61, 0xF0, 0x11, 0x46, 0x61, 0x32, 0x62, 0x71, 0xD1,
+  0x21, 0xF1, 0x01, 0xF0, 0x51, 0x27, 0xA1, 0x72, 0x71, 0xA1, 0x51, 0x35,
+  0x41, 0x62, 0x52, 0xF0, 0x61, 0x41, 0x91, 0xF1, 0x81, 0xF1, 0x81, 0x91,
+  0x41, 0xF0, 0x01, 0x52, 0x52, 0x61, 0x45, 0x41, 0x41, 0xB1, 0x62, 0x72,
+  0x30, 0x0F, 0x01, 0xF1, 0x1C, 0x31, 0xF0, 0xC1, 0xF0, 0x31, 0xF0, 0xC1,
+  0x21, 0xF1, 0xC1, 0x21, 0xF0, 0xC1, 0xF0, 0x31, 0xF0, 0xC1, 0xF0, 0x31,
+  0xF0, 0xC1, 0xF0, 0x31, 0xF0, 0xC1, 0x21, 0xF1, 0xC1, 0x21, 0x80, 0x67,
+  0x92, 0x71, 0x62, 0xA2, 0x86, 0x71, 0x31, 0x61, 0x31, 0x51, 0x81, 0xF2,
+  0xC1, 0x21, 0x81, 0x21, 0x61, 0x61, 0x71, 0x36, 0x31, 0x52, 0x82, 0x62,
+  0x82, 0x42, 0x36, 0x32, 0x52, 0x62, 0x41, 0x21, 0xA1, 0x21, 0xF3, 0xC1,
+  0xA1, 0x31, 0x32, 0x62, 0x31, 0x11, 0x46, 0x41, 0x31, 0xC1, 0x52, 0x82,
+  0x30, 0x57, 0x92, 0x72, 0x61, 0xB1, 0x41, 0x45, 0x41, 0x62, 0x52, 0x51,
+  0xF0, 0x01, 0x41, 0x91, 0xF1, 0x81, 0xF1, 0x81, 0x91, 0x41, 0xF0, 0x62,
+  0x52, 0x61, 0x45, 0x31, 0x51, 0xA1, 0x72, 0x71, 0xA7, 0x21, 0xF0, 0x51,
+  0xF1, 0x01, 0x21, 0xD1, 0x72, 0x62, 0x31, 0x66, 0x41, 0xF0, 0x11, 0x62,
+  0x72, 0x50, 0x03, 0x93, 0xF0, 0xC3, 0x90 };
+
+const GFXglyph DejaVuSans18pt7bRLEGlyphs[] PROGMEM = {
+  {     0,  18,  26,  22,    2,  -25 },   // 0x30 '0'
+  {    39,  15,  26,  22,    4,  -25 },   // 0x31 '1'
+  {    50,  16,  26,  22,    3,  -25 },   // 0x32 '2'
+  {    91,  17,  26,  22,    3,  -25 },   // 0x33 '3'
+  {   129,  19,  26,  22,    2,  -25 },   // 0x34 '4'
+  {   164,  17,  26,  22,    3,  -25 },   // 0x35 '5'
+  {   192,  18,  26,  22,    2,  -25 },   // 0x36 '6'
+  {   241,  16,  26,  22,    3,  -25 },   // 0x37 '7'
+  {   275,  18,  26,  22,    2,  -25 },   // 0x38 '8'
+  {   325,  18,  26,  22,    2,  -25 },   // 0x39 '9'
+  {   374,   3,  18,  12,    4,  -17 } }; // 0x3A ':'
+
+const GFXfont DejaVuSans18pt7bRLE PROGMEM = {
+  (uint8_t  *)DejaVuSans18pt7bRLEBitmaps,
+  (GFXglyph *)DejaVuSans18pt7bRLEGlyphs,
+  0x30, 0x3A, 41, GFX_FONT_RLE };
+
+// Approx. 464 bytes
+// Bitmaps 379 bytes, 570 packed
@@ -0,0 +1,74 @@
+/*********************************************************************
+Run-length coded GFX font benchmark for the SSD1306 driver
+
+Draws a clock face with the same 18pt digits once from a packed font
+and once from a run-length coded one (fontconvert -r) into the
+framebuffer (no bus traffic) and prints the draw rate and the bitmap
+size of both.  Packed glyphs go out a pixel at a time, coded ones as
+spans and rects.  Results on Serial.
+
+BSD license, check license.txt for more information
+*********************************************************************/
+
+#include <SPI.h>
+#include <Wire.h>
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1306.h>
+#include "DejaVuSans18pt7b.h"
+#include "DejaVuSans18pt7bRLE.h"
+
+#define OLED_RESET 4
+Adafruit_SSD1306 display(OLED_RESET);
+
+#define PASSES 200
+
+// Draw the time PASSES times, every other pass shifted off the page
+// grid.  Returns characters per second.
+uint32_t benchClock(const GFXfont *font) {
+  char text[9];
+  uint32_t chars = 0;
+  display.setFont(font);
+  display.setTextSize(1);
+  display.setTextColor(WHITE);
+
+  uint32_t start = micros();
+  for (uint16_t n=0; n<PASSES; n++) {
+    sprintf(text, "%02u:%02u:%02u", (n / 3600) % 24, (n / 60) % 60, n % 60);
+    display.setCursor(n & 1, 26 + (n & 3));
+    chars += display.print(text);
+  }
+  uint32_t us = micros() - start;
+  return us ? (uint32_t)((uint64_t)chars * 1000000UL / us) : 0;
+}
+
+void report(const char *what, uint32_t rate, size_t bytes) {
+  Serial.print(what);
+  Serial.print(": ");
+  Serial.print(rate);
+  Serial.print(" chars/s, bitmaps ");
+  Serial.print(bytes);
+  Serial.println(" bytes");
+}
+
+void setup() {
+  Serial.begin(115200);
+  // only the framebuffer is exercised, no panel needed
+  display.clearDisplay();
+
+  report("Packed  ", benchClock(&DejaVuSans18pt7b), sizeof(DejaVuSans18pt7bBitmaps));
+  report("RLE     ", benchClock(&DejaVuSans18pt7bRLE), sizeof(DejaVuSans18pt7bRLEBitmaps));
+
+  // both fonts must draw the same picture
+  static uint8_t packed[SSD1306_LCDWIDTH * SSD1306_LCDHEIGHT / 8];
+  display.clearDisplay();
+  benchClock(&DejaVuSans18pt7b);
+  memcpy(packed, display.getBuffer(), sizeof(packed));
+  display.clearDisplay();
+  benchClock(&DejaVuSans18pt7bRLE);
+  Serial.println(memcmp(packed, display.getBuffer(), sizeof(packed)) ?
+                 "Framebuffers differ!" : "Framebuffers match");
+  display.setFont();
+}
+
+void loop() {
+}
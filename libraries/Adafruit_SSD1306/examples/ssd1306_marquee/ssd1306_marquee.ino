@@ -0,0 +1,65 @@
+/*********************************************************************
+SSD1306_Marquee demo and bus traffic report
+
+The top line is a full width band scrolled by the controller itself,
+the bottom one a box with a label next to it, scrolled in software.
+After ten seconds of each the GDDRAM bytes sent per step are printed
+on Serial: none for the hardware band, the box only for software.
+
+BSD license, check license.txt for more information
+*********************************************************************/
+
+#include <SPI.h>
+#include <Wire.h>
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1306.h>
+#include <SSD1306_Marquee.h>
+
+#define OLED_RESET 4
+Adafruit_SSD1306 display(OLED_RESET);
+
+// the band text plus the gap has to fit on the panel for hardware scrolling
+SSD1306_Marquee band, box;
+
+#define RUN_MS 10000
+
+// let a marquee run for RUN_MS, report steps and bytes per step
+void run(SSD1306_Marquee &m, const char *what) {
+  uint32_t steps = 0, bytes = 0, start = millis();
+  while (millis() - start < RUN_MS) {
+    if (m.update()) {
+      steps++;
+      bytes += display.getFrameBytes();
+    }
+  }
+  Serial.print(what);
+  Serial.print(m.isHardware() ? " (hardware): " : " (software): ");
+  Serial.print(steps);
+  Serial.print(" updates, ");
+  Serial.print(steps ? bytes / steps : 0);
+  Serial.println(" bytes per update");
+}
+
+void setup() {
+  Serial.begin(115200);
+  display.begin(SSD1306_SWITCHCAPVCC, 0x3C);
+  display.clearDisplay();
+  display.setTextColor(WHITE);
+  display.display();
+
+  band.begin(display, "No bus traffic", 0, 0);
+  run(band, "Band");
+  band.end();
+
+  display.clearDisplay();
+  display.setCursor(0, 24);
+  display.print("Now:");
+  display.display();
+  box.setSpeed(40);
+  box.begin(display, "Software scroll, only this box is sent", 30, 24);
+  run(box, "Box ");
+}
+
+void loop() {
+  box.update();
+}
@@ -0,0 +1,70 @@
+/*********************************************************************
+Rotation benchmark for the SSD1306 driver
+
+Runs the same draw list (pixels, lines, rectangles, circles, text)
+into the framebuffer in each of the four rotations and prints the
+time per pass.  No bus traffic, no panel needed.  With the rotation
+specialized writers all four rotations should come out close together.
+
+BSD license, check license.txt for more information
+*********************************************************************/
+
+#include <SPI.h>
+#include <Wire.h>
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1306.h>
+
+#define OLED_RESET 4
+Adafruit_SSD1306 display(OLED_RESET);
+
+#define PASSES 100
+
+// A menu-like screen plus some geometry, sized by the rotated width/height
+void drawList(void) {
+  int16_t w = display.width(), h = display.height();
+
+  display.clearDisplay();
+  for (int16_t i=0; i<w; i+=3) {
+    display.drawPixel(i, (i * 7) % h, WHITE);
+  }
+  display.drawLine(0, 0, w-1, h-1, WHITE);
+  display.drawLine(w-1, 0, 0, h-1, INVERSE);
+  display.drawRect(1, 1, w-2, h-2, WHITE);
+  display.fillRect(4, 4, w/2, h/3, INVERSE);
+  display.drawCircle(w/2, h/2, min(w, h)/2 - 2, WHITE);
+  display.fillRoundRect(w/4, h/2, w/2, h/4, 3, INVERSE);
+
+  display.setTextSize(1);
+  display.setTextColor(BLACK, WHITE);
+  display.setCursor(2, 2);
+  display.print(F("Settings"));
+  display.setTextColor(WHITE);
+  display.setCursor(2, h/2);
+  display.print(F("Brightness 42"));
+  display.setTextSize(2);
+  display.setCursor(0, h - 16);
+  display.print(F("OK"));
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  for (uint8_t r=0; r<4; r++) {
+    display.setRotation(r);
+    uint32_t start = micros();
+    for (uint16_t n=0; n<PASSES; n++) {
+      drawList();
+    }
+    uint32_t us = micros() - start;
+
+    Serial.print("Rotation ");
+    Serial.print(r);
+    Serial.print(": ");
+    Serial.print(us / PASSES);
+    Serial.println(" us per draw list");
+  }
+  display.setRotation(0);
+}
+
+void loop() {
+}
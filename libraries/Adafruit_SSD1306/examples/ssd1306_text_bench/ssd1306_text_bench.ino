@@ -0,0 +1,117 @@
+/*********************************************************************
+Glyph/bitmap blitting benchmark for the SSD1306 driver
+
+Times text and bitmap drawing into the framebuffer (no bus traffic)
+with the page-native blitter against the generic per-pixel path of
+Adafruit_GFX, which a subclass forwards to.  Results on Serial.
+
+BSD license, check license.txt for more information
+*********************************************************************/
+
+#include <SPI.h>
+#include <Wire.h>
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1306.h>
+
+// Same display, but glyph columns and bitmaps take the generic pixel path
+class GenericSSD1306 : public Adafruit_SSD1306 {
+ public:
+  GenericSSD1306(int8_t rst) : Adafruit_SSD1306(rst) {}
+  void writeColumn8(int16_t x, int16_t y, uint8_t bits, uint8_t h, uint16_t color, uint16_t bg) {
+    Adafruit_GFX::writeColumn8(x, y, bits, h, color, bg);
+  }
+  void drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color) {
+    Adafruit_GFX::drawBitmap(x, y, bitmap, w, h, color);
+  }
+};
+
+#define OLED_RESET 4
+Adafruit_SSD1306 display(OLED_RESET);
+GenericSSD1306 generic(OLED_RESET);
+
+#define PASSES 200
+
+static const unsigned char PROGMEM logo16_glcd_bmp[] =
+{ B00000000, B11000000,
+  B00000001, B11000000,
+  B00000001, B11000000,
+  B00000011, B11100000,
+  B11110011, B11100000,
+  B11111110, B11111000,
+  B01111110, B11111111,
+  B00110011, B10011111,
+  B00011111, B11111100,
+  B00001101, B01110000,
+  B00011011, B10100000,
+  B00111111, B11100000,
+  B00111111, B11110000,
+  B01111100, B11110000,
+  B01110000, B01110000,
+  B00000000, B00110000 };
+
+// Fill the screen with text PASSES times, half of the rows on a page
+// boundary and half shifted by 3 pixels.  Returns characters per second.
+uint32_t benchText(Adafruit_SSD1306 &d, bool opaque) {
+  uint32_t chars = 0;
+  d.setTextSize(1);
+  d.setTextWrap(false);
+  if (opaque) d.setTextColor(WHITE, BLACK);
+  else d.setTextColor(WHITE);
+
+  uint32_t start = micros();
+  for (uint16_t n=0; n<PASSES; n++) {
+    for (int16_t y=(n & 1) ? 3 : 0; y<d.height(); y+=8) {
+      d.setCursor(0, y);
+      chars += d.print(F("The quick brown fox "));
+    }
+  }
+  uint32_t us = micros() - start;
+  return us ? (uint32_t)((uint64_t)chars * 1000000UL / us) : 0;
+}
+
+// 16x16 icons across the screen at unaligned y.  Returns bitmaps per second.
+uint32_t benchBitmap(Adafruit_SSD1306 &d) {
+  uint32_t count = 0;
+  uint32_t start = micros();
+  for (uint16_t n=0; n<PASSES; n++) {
+    for (int16_t x=0; x<d.width(); x+=16, count++) {
+      d.drawBitmap(x, (x / 16) % 8 + 5, logo16_glcd_bmp, 16, 16, INVERSE);
+    }
+  }
+  uint32_t us = micros() - start;
+  return us ? (uint32_t)((uint64_t)count * 1000000UL / us) : 0;
+}
+
+void report(const char *what, uint32_t fast, uint32_t slow) {
+  Serial.print(what);
+  Serial.print(": page-native ");
+  Serial.print(fast);
+  Serial.print("/s, generic ");
+  Serial.print(slow);
+  Serial.print("/s, x");
+  Serial.println(slow ? (float)fast / slow : 0.0, 1);
+}
+
+void setup() {
+  Serial.begin(115200);
+  // only the framebuffer is exercised, no panel needed
+  display.clearDisplay();
+  generic.clearDisplay();
+
+  report("Text, transparent", benchText(display, false), benchText(generic, false));
+  report("Text, opaque     ", benchText(display, true), benchText(generic, true));
+  report("Bitmap 16x16     ", benchBitmap(display), benchBitmap(generic));
+
+  // both paths must have produced the same picture
+  display.clearDisplay();
+  generic.clearDisplay();
+  benchText(display, true);
+  benchText(generic, true);
+  benchBitmap(display);
+  benchBitmap(generic);
+  Serial.println(memcmp(display.getBuffer(), generic.getBuffer(),
+                        SSD1306_LCDWIDTH * SSD1306_LCDHEIGHT / 8) ? "Framebuffers differ!" : "Framebuffers match");
+}
+
+void loop() {
+}
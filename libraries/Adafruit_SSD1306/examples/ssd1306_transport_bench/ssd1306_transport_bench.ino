@@ -0,0 +1,83 @@
+/*********************************************************************
+Frame time per transport for the SSD1306 driver (128x32 I2C)
+
+Sends full frames (invalidate() + display()) through each transport
+and prints the time per frame:
+ - blocking Wire, the data split into Wire buffer sized transactions
+ - EasyDMA TWIM, 400 kHz / 1 MHz: one transaction per DMA chunk, or
+   the frame streamed in one transaction with SSD1306_TWIM_STREAM 1
+On boards without the TWIM transport the bus simulator stands in for
+it, modelling one transaction per DMA chunk and a single streamed one.
+
+BSD license, check license.txt for more information
+*********************************************************************/
+
+#include <SPI.h>
+#include <Wire.h>
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1306.h>
+
+#define OLED_RESET 4
+Adafruit_SSD1306 display(OLED_RESET);
+
+#define FRAMES 20
+
+// average microseconds per full frame through the current transport
+uint32_t frameTime(void) {
+  uint32_t start = micros();
+  for (uint8_t n=0; n<FRAMES; n++) {
+    display.invalidate();
+    display.display();
+    display.waitFlush();
+  }
+  return (micros() - start) / FRAMES;
+}
+
+void report(const char *what, uint32_t us) {
+  Serial.print(what);
+  Serial.print(": ");
+  Serial.print(us);
+  Serial.print(" us per frame, ");
+  Serial.print(us ? 1000000UL / us : 0);
+  Serial.println(" fps max");
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  display.begin(SSD1306_SWITCHCAPVCC, 0x3C);
+  display.clearDisplay();
+  display.setTextSize(2);
+  display.setTextColor(WHITE);
+  display.setCursor(0, 8);
+  display.print(F("Transport"));
+
+  Wire.setClock(400000);
+  report("Wire, 400 kHz            ", frameTime());
+
+#if defined(ARDUINO_ARCH_NRF52)
+  SSD1306_TWIMBus twim400(NRF_TWIM1, 0x3C, 400000);
+  SSD1306_TWIMBus twim1M(NRF_TWIM1, 0x3C, 1000000);
+  display.setAsyncBus(&twim400);
+  report("TWIM, 400 kHz            ", frameTime());
+  display.setAsyncBus(&twim1M);
+  report("TWIM, 1 MHz              ", frameTime());
+#else
+  SSD1306_SimBus chunked400(SSD1306_LCDWIDTH, SSD1306_LCDHEIGHT, 400000);
+  SSD1306_SimBus stream400(SSD1306_LCDWIDTH, SSD1306_LCDHEIGHT, 400000, true, 0xFFFF);
+  SSD1306_SimBus chunked1M(SSD1306_LCDWIDTH, SSD1306_LCDHEIGHT, 1000000);
+  SSD1306_SimBus stream1M(SSD1306_LCDWIDTH, SSD1306_LCDHEIGHT, 1000000, true, 0xFFFF);
+  display.setAsyncBus(&chunked400);
+  report("Sim, DMA chunks, 400 kHz ", frameTime());
+  display.setAsyncBus(&stream400);
+  report("Sim, streamed, 400 kHz   ", frameTime());
+  display.setAsyncBus(&chunked1M);
+  report("Sim, DMA chunks, 1 MHz   ", frameTime());
+  display.setAsyncBus(&stream1M);
+  report("Sim, streamed, 1 MHz     ", frameTime());
+#endif
+  display.setAsyncBus(NULL);
+}
+
+void loop() {
+}
@@ -27,11 +27,30 @@
 
 #include "Adafruit_seesaw.h"
 
+/**
+ *****************************************************************************************
+ *  @brief      Create the seesaw driver. Nothing is sent before begin().
+ ****************************************************************************************/
+Adafruit_seesaw::Adafruit_seesaw(void)
+{
+	_i2caddr = SEESAW_ADDRESS;
+	_readyAt = 0;
+	_recovering = false;
+#if defined(ARDUINO_ARCH_NRF52)
+	_busLock = NULL;
+	_devLock = NULL;
+	_queue = NULL;
+	_task = NULL;
+#endif
+}
+
 /**
  *****************************************************************************************
  *  @brief      Start the seesaw
  *
- *				This should be called when your sketch is connecting to the seesaw
+ *				This should be called when your sketch is connecting to the seesaw.
+ *				The seesaw does not answer while it restarts after the software reset,
+ *				its hardware ID is polled until it does (at most SEESAW_RESET_TIMEOUT ms).
  * 
  *  @param      addr the I2C address of the seesaw
  *
@@ -44,13 +63,16 @@ bool Adafruit_seesaw::begin(uint8_t addr)
 	_i2c_init();
 
 	SWReset();
-	delay(500);
 
-	uint8_t c = this->read8(SEESAW_STATUS_BASE, SEESAW_STATUS_HW_ID);
+	uint32_t start = millis();
+	do {
+		uint8_t c;
+		if(this->read(SEESAW_STATUS_BASE, SEESAW_STATUS_HW_ID, &c, 1))
+			return c == SEESAW_HW_ID_CODE;
+		delay(1);
+	} while(millis() - start < SEESAW_RESET_TIMEOUT);
 
-	if(c != SEESAW_HW_ID_CODE) return false;
-	
-	return true;
+	return false;
 }
 
 /**
@@ -176,6 +198,21 @@ void Adafruit_seesaw::setGPIOInterrupts(uint32_t pins, bool enabled)
 		this->write(SEESAW_GPIO_BASE, SEESAW_GPIO_INTENCLR, cmd, 4);
 }
 
+/**
+ *****************************************************************************************
+ *  @brief      Read and clear the GPIO interrupt flags. Reading them releases the
+ *				interrupt line until the next change on a pin with interrupts enabled.
+ *
+ *  @return     a bitmask of the pins that changed since the flags were last read.
+ ****************************************************************************************/
+uint32_t Adafruit_seesaw::getGPIOInterruptFlag()
+{
+	uint8_t buf[4];
+	this->read(SEESAW_GPIO_BASE, SEESAW_GPIO_INTFLAG, buf, 4);
+	uint32_t ret = ((uint32_t)buf[0] << 24) | ((uint32_t)buf[1] << 16) | ((uint32_t)buf[2] << 8) | (uint32_t)buf[3];
+	return ret;
+}
+
 /**
  *****************************************************************************************
  *  @brief      read the analog value on an ADC-enabled pin.
@@ -199,19 +236,27 @@ uint16_t Adafruit_seesaw::analogRead(uint8_t pin)
 			break;
 	}
 
-	this->read(SEESAW_ADC_BASE, SEESAW_ADC_CHANNEL_OFFSET + p, buf, 2, 500);
+	this->read(SEESAW_ADC_BASE, SEESAW_ADC_CHANNEL_OFFSET + p, buf, 2);
 	uint16_t ret = ((uint16_t)buf[0] << 8) | buf[1];
-  	delay(1);
 	return ret;
 }
 
-//TODO: not sure if this is how this is gonna work yet
+/**
+ *****************************************************************************************
+ *  @brief      read the analog values of the first num ADC channels in one transaction.
+ *
+ *  @param      buf receives the values, channel 0 (ADC_INPUT_0_PIN) first. Each is an
+ *				integer between 0 and 1023.
+ *	@param		num the number of channels to read.
+ *
+ *  @return     none
+ ****************************************************************************************/
 void Adafruit_seesaw::analogReadBulk(uint16_t *buf, uint8_t num)
 {
 	uint8_t rawbuf[num * 2];
 	this->read(SEESAW_ADC_BASE, SEESAW_ADC_CHANNEL_OFFSET, rawbuf, num * 2);
 	for(int i=0; i<num; i++){
-		buf[i] = ((uint16_t)rawbuf[i * 2] << 8) | buf[i * 2 + 1];
+		buf[i] = ((uint16_t)rawbuf[i * 2] << 8) | rawbuf[i * 2 + 1];
 	}
 }
 
@@ -509,43 +554,160 @@ void Adafruit_seesaw::_i2c_init()
   Wire.begin();
 }
 
+/**
+ *****************************************************************************************
+ *  @brief      Microseconds the seesaw needs after a register is selected for reading
+ *				before its reply is ready. The ADC converts the channel on select.
+ * 
+ *  @param      regHigh the module address register (ex. SEESAW_ADC_BASE)
+ *	@param		regLow the function address register (ex. SEESAW_ADC_CHANNEL_OFFSET)
+ *
+ *  @return     the turnaround in microseconds
+ ****************************************************************************************/
+uint16_t Adafruit_seesaw::readTurnaround(uint8_t regHigh, uint8_t regLow)
+{
+	if(regHigh == SEESAW_ADC_BASE && regLow >= SEESAW_ADC_CHANNEL_OFFSET)
+		return SEESAW_ADC_TURNAROUND;
+	return SEESAW_READ_TURNAROUND;
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      Microseconds the seesaw needs after an access to a register before it
+ *				takes the next one. Only an access that comes sooner waits, so these
+ *				cost nothing when the seesaw is used at a lower rate.
+ * 
+ *  @param      regHigh the module address register (ex. SEESAW_STATUS_BASE)
+ *	@param		regLow the function address register (ex. SEESAW_STATUS_SWRST)
+ *	@param		write true for a write, false for a read
+ *
+ *  @return     the recovery time in microseconds
+ ****************************************************************************************/
+uint16_t Adafruit_seesaw::recoveryTime(uint8_t regHigh, uint8_t regLow, bool write)
+{
+	if(!write){
+		if(regHigh == SEESAW_ADC_BASE && regLow >= SEESAW_ADC_CHANNEL_OFFSET)
+			return SEESAW_ADC_RECOVERY;
+		return 0;
+	}
+	if(regHigh == SEESAW_STATUS_BASE && regLow == SEESAW_STATUS_SWRST)
+		return SEESAW_SWRST_RECOVERY;
+	if(regHigh >= SEESAW_SERCOM0_BASE && regHigh < SEESAW_TIMER_BASE && regLow == SEESAW_SERCOM_DATA)
+		return SEESAW_SERCOM_RECOVERY;
+	return 0;
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      Wait until the seesaw takes the next access. The bus is not held
+ *				meanwhile, other devices on it can be used.
+ * 
+ *  @return     none
+ ****************************************************************************************/
+void Adafruit_seesaw::_wait_ready()
+{
+	if(!_recovering) return;
+	int32_t left = (int32_t)(_readyAt - micros());
+#if defined(ARDUINO_ARCH_NRF52)
+	if(left >= 1000){
+		vTaskDelay(ms2tick(left / 1000));
+		left = (int32_t)(_readyAt - micros());
+	}
+#endif
+	if(left > 0) delayMicroseconds(left);
+	_recovering = false;
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      Note that the seesaw takes the next access only after us microseconds.
+ * 
+ *  @param      us the recovery time, 0 for none
+ *
+ *  @return     none
+ ****************************************************************************************/
+void Adafruit_seesaw::_set_recovery(uint32_t us)
+{
+	if(!us) return;
+	_readyAt = micros() + us;
+	_recovering = true;
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      Take and give back the shared bus lock, if one was set with setBusLock().
+ * 
+ *  @return     none
+ ****************************************************************************************/
+void Adafruit_seesaw::_bus_lock()
+{
+#if defined(ARDUINO_ARCH_NRF52)
+	if(_busLock) xSemaphoreTake(_busLock, portMAX_DELAY);
+#endif
+}
+
+void Adafruit_seesaw::_bus_unlock()
+{
+#if defined(ARDUINO_ARCH_NRF52)
+	if(_busLock) xSemaphoreGive(_busLock);
+#endif
+}
+
 /**
  *****************************************************************************************
  *  @brief      Read a specified number of bytes into a buffer from the seesaw.
+ *
+ *				The bus is held only for the register select and for reading the reply,
+ *				not while waiting for the seesaw in between.
  * 
  *  @param      regHigh the module address register (ex. SEESAW_STATUS_BASE)
  *	@param		regLow the function address register (ex. SEESAW_STATUS_VERSION)
  *	@param		buf the buffer to read the bytes into
  *	@param		num the number of bytes to read.
- *	@param		delay an optional delay in between setting the read register and reading
- *				out the data. This is required for some seesaw functions (ex. reading ADC data)
+ *	@param		delay an optional minimum delay in microseconds in between setting the read
+ *				register and reading out the data, on top of readTurnaround()
  *
- *  @return     none
+ *  @return     true on success. On a bus error the bytes not read are set to 0xFF.
  ****************************************************************************************/
-void Adafruit_seesaw::read(uint8_t regHigh, uint8_t regLow, uint8_t *buf, uint8_t num, uint16_t delay)
+bool Adafruit_seesaw::read(uint8_t regHigh, uint8_t regLow, uint8_t *buf, uint8_t num, uint16_t delay)
 {
-	uint8_t value;
 	uint8_t pos = 0;
-	
+	uint16_t turnaround = max(delay, readTurnaround(regHigh, regLow));
+	bool ok = true;
+
+#if defined(ARDUINO_ARCH_NRF52)
+	if(_devLock) xSemaphoreTake(_devLock, portMAX_DELAY);
+#endif
 	//on arduino we need to read in 32 byte chunks
-	while(pos < num){
+	while(ok && pos < num){
 		
 		uint8_t read_now = min(32, num - pos);
+		_wait_ready();
+		_bus_lock();
 		Wire.beginTransmission((uint8_t)_i2caddr);
 		Wire.write((uint8_t)regHigh);
 		Wire.write((uint8_t)regLow);
-		Wire.endTransmission();
+		ok = (Wire.endTransmission() == 0);
+		_bus_unlock();
+		if(!ok) break;
 
-		//TODO: tune this
-		delayMicroseconds(delay);
+		_set_recovery(turnaround);
+		_wait_ready();
 
-		Wire.requestFrom((uint8_t)_i2caddr, read_now);
-		
-		for(int i=0; i<read_now; i++){
+		_bus_lock();
+		ok = (Wire.requestFrom((uint8_t)_i2caddr, read_now) == read_now);
+		for(int i=0; ok && i<read_now; i++){
 			buf[pos] = Wire.read();
 			pos++;
 		}
+		_bus_unlock();
 	}
+	if(ok) _set_recovery(recoveryTime(regHigh, regLow, false));
+	else memset(buf + pos, 0xFF, num - pos);
+#if defined(ARDUINO_ARCH_NRF52)
+	if(_devLock) xSemaphoreGive(_devLock);
+#endif
+	return ok;
 }
 
 /**
@@ -557,15 +719,26 @@ void Adafruit_seesaw::read(uint8_t regHigh, uint8_t regLow, uint8_t *buf, uint8_
  *	@param		buf the buffer the the bytes from
  *	@param		num the number of bytes to write.
  *
- *  @return     none
+ *  @return     true on success
  ****************************************************************************************/
-void Adafruit_seesaw::write(uint8_t regHigh, uint8_t regLow, uint8_t *buf, uint8_t num)
+bool Adafruit_seesaw::write(uint8_t regHigh, uint8_t regLow, uint8_t *buf, uint8_t num)
 { 
+#if defined(ARDUINO_ARCH_NRF52)
+	if(_devLock) xSemaphoreTake(_devLock, portMAX_DELAY);
+#endif
+	_wait_ready();
+	_bus_lock();
 	Wire.beginTransmission((uint8_t)_i2caddr);
 	Wire.write((uint8_t)regHigh);
 	Wire.write((uint8_t)regLow);
-	Wire.write((uint8_t *)buf, num);
-	Wire.endTransmission();
+	if(num) Wire.write((uint8_t *)buf, num);
+	bool ok = (Wire.endTransmission() == 0);
+	_bus_unlock();
+	_set_recovery(recoveryTime(regHigh, regLow, true));
+#if defined(ARDUINO_ARCH_NRF52)
+	if(_devLock) xSemaphoreGive(_devLock);
+#endif
+	return ok;
 }
 
 /**
@@ -583,7 +756,7 @@ void Adafruit_seesaw::write(uint8_t regHigh, uint8_t regLow, uint8_t *buf, uint8
 size_t Adafruit_seesaw::write(uint8_t character) {
 	//TODO: add support for multiple sercoms
 	this->write8(SEESAW_SERCOM0_BASE, SEESAW_SERCOM_DATA, character);
-	delay(1); //TODO: this can be optimized... it's only needed for longer writes
+	return 1;
 }
 
 /**
@@ -618,12 +791,252 @@ size_t Adafruit_seesaw::write(const char *str) {
  *  @param      regHigh the module address register (ex. SEESAW_STATUS_BASE)
  *	@param		regLow the function address register (ex. SEESAW_STATUS_SWRST)
  *
+ *  @return     true on success
+ ****************************************************************************************/
+bool Adafruit_seesaw::writeEmpty(uint8_t regHigh, uint8_t regLow)
+{
+    return this->write(regHigh, regLow, NULL, 0);
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      Execute the register accesses of a transaction back to back in the calling
+ *				task, then call its completion callback.
+ * 
+ *  @param      t the transaction to execute
+ *
+ *  @return     true if all accesses succeeded
+ ****************************************************************************************/
+bool Adafruit_seesaw::run(seesaw_Transaction &t)
+{
+	bool ok = true;
+	for(uint8_t i=0; i<t._num; i++){
+		seesaw_Transaction::op &o = t._ops[i];
+		if(o.write) ok &= this->write(o.regHigh, o.regLow, o.buf, o.num);
+		else ok &= this->read(o.regHigh, o.regLow, o.buf, o.num, o.delay);
+	}
+	t._ok = ok;
+	// done before the callback, so it can submit the transaction again
+	t._pending = false;
+	if(t._cb) t._cb(t, t._arg);
+	return ok;
+}
+
+#if defined(ARDUINO_ARCH_NRF52)
+
+/**
+ *****************************************************************************************
+ *  @brief      Share the I2C bus with other devices. Every transfer to the seesaw takes
+ *				the passed mutex, and so does everything else using the bus. It is held
+ *				per transfer only: the turnaround between a register select and the
+ *				reply leaves the bus free.
+ * 
+ *  @param      lock a FreeRTOS mutex, NULL to stop locking
+ *
  *  @return     none
  ****************************************************************************************/
-void Adafruit_seesaw::writeEmpty(uint8_t regHigh, uint8_t regLow)
+void Adafruit_seesaw::setBusLock(SemaphoreHandle_t lock)
+{
+	_busLock = lock;
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      Start the bus task that executes submitted transactions. From here on the
+ *				seesaw may be used from several tasks.
+ *
+ *  @return     true on success, false if out of memory
+ ****************************************************************************************/
+bool Adafruit_seesaw::beginBusTask()
+{
+	if(_task) return true;
+	if(!_devLock) _devLock = xSemaphoreCreateMutex();
+	if(!_queue) _queue = xQueueCreate(SEESAW_BUS_QUEUE_LEN, sizeof(seesaw_Transaction *));
+	if(!_devLock || !_queue) return false;
+	return xTaskCreate(_bus_task, "seesaw", SEESAW_BUS_TASK_STACK, this, SEESAW_BUS_TASK_PRIO, &_task) == pdPASS;
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      Queue a transaction for the bus task and return right away. Its callback
+ *				runs in the bus task once it is done.
+ * 
+ *  @param      t the transaction, it must not be changed while it is pending
+ *
+ *  @return     true if queued, false if it is still pending or the queue is full
+ ****************************************************************************************/
+bool Adafruit_seesaw::submit(seesaw_Transaction &t)
+{
+	if(!_queue) return false;
+
+	taskENTER_CRITICAL();
+	bool pending = t._pending;
+	t._pending = true;
+	taskEXIT_CRITICAL();
+	if(pending) return false;
+
+	seesaw_Transaction *p = &t;
+	if(xQueueSend(_queue, &p, 0) != pdTRUE){
+		t._pending = false;
+		return false;
+	}
+	return true;
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      submit() for interrupt handlers
+ * 
+ *  @param      t the transaction, it must not be changed while it is pending
+ *	@param		woken set to pdTRUE if the bus task should run when the handler returns,
+ *				pass it to portYIELD_FROM_ISR()
+ *
+ *  @return     true if queued, false if it is still pending or the queue is full
+ ****************************************************************************************/
+bool Adafruit_seesaw::submitFromISR(seesaw_Transaction &t, BaseType_t *woken)
+{
+	if(!_queue) return false;
+
+	UBaseType_t state = taskENTER_CRITICAL_FROM_ISR();
+	bool pending = t._pending;
+	t._pending = true;
+	taskEXIT_CRITICAL_FROM_ISR(state);
+	if(pending) return false;
+
+	seesaw_Transaction *p = &t;
+	if(xQueueSendFromISR(_queue, &p, woken) != pdTRUE){
+		t._pending = false;
+		return false;
+	}
+	return true;
+}
+
+void Adafruit_seesaw::_bus_task(void *arg)
+{
+	Adafruit_seesaw *ss = (Adafruit_seesaw *)arg;
+	seesaw_Transaction *t;
+	for(;;){
+		if(xQueueReceive(ss->_queue, &t, portMAX_DELAY) == pdTRUE) ss->run(*t);
+	}
+}
+
+#endif
+
+/**
+ *****************************************************************************************
+ *  @brief      Create an empty transaction.
+ * 
+ *  @param      cb called when the transaction is done, NULL for none
+ *	@param		arg passed to cb
+ ****************************************************************************************/
+seesaw_Transaction::seesaw_Transaction(callback_t cb, void *arg)
+{
+	_num = 0;
+	_pending = false;
+	_ok = false;
+	_cb = cb;
+	_arg = arg;
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      Add a register read.
+ * 
+ *  @param      regHigh the module address register (ex. SEESAW_GPIO_BASE)
+ *	@param		regLow the function address register (ex. SEESAW_GPIO_BULK)
+ *	@param		buf receives the bytes read
+ *	@param		num the number of bytes to read
+ *	@param		delay an optional minimum delay in microseconds between register select
+ *				and reading out the data
+ *
+ *  @return     false if the transaction is full or pending
+ ****************************************************************************************/
+bool seesaw_Transaction::read(uint8_t regHigh, uint8_t regLow, uint8_t *buf, uint8_t num, uint16_t delay)
+{
+	if(_pending || _num >= SEESAW_TRANSACTION_OPS) return false;
+	op &o = _ops[_num++];
+	o.regHigh = regHigh;
+	o.regLow = regLow;
+	o.buf = buf;
+	o.num = num;
+	o.write = false;
+	o.delay = delay;
+	return true;
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      Add a register write.
+ * 
+ *  @param      regHigh the module address register (ex. SEESAW_GPIO_BASE)
+ *	@param		regLow the function address register (ex. SEESAW_GPIO_BULK_SET)
+ *	@param		buf the bytes to write
+ *	@param		num the number of bytes to write
+ *
+ *  @return     false if the transaction is full or pending
+ ****************************************************************************************/
+bool seesaw_Transaction::write(uint8_t regHigh, uint8_t regLow, uint8_t *buf, uint8_t num)
+{
+	if(_pending || _num >= SEESAW_TRANSACTION_OPS) return false;
+	op &o = _ops[_num++];
+	o.regHigh = regHigh;
+	o.regLow = regLow;
+	o.buf = buf;
+	o.num = num;
+	o.write = true;
+	o.delay = 0;
+	return true;
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      Remove all register accesses, to reuse the transaction.
+ * 
+ *  @return     none
+ ****************************************************************************************/
+void seesaw_Transaction::clear()
+{
+	if(!_pending) _num = 0;
+}
+
+/**
+ *****************************************************************************************
+ *  @brief      Set the completion callback.
+ * 
+ *  @param      cb called when the transaction is done, NULL for none
+ *	@param		arg passed to cb
+ *
+ *  @return     none
+ ****************************************************************************************/
+void seesaw_Transaction::onComplete(callback_t cb, void *arg)
+{
+	_cb = cb;
+	_arg = arg;
+}
+
+/**
+ *****************************************************************************************
+ *  @return     the number of register accesses
+ ****************************************************************************************/
+uint8_t seesaw_Transaction::count() const
+{
+	return _num;
+}
+
+/**
+ *****************************************************************************************
+ *  @return     true from submit() until the transaction is done
+ ****************************************************************************************/
+bool seesaw_Transaction::isPending() const
+{
+	return _pending;
+}
+
+/**
+ *****************************************************************************************
+ *  @return     true if all register accesses of the last run succeeded
+ ****************************************************************************************/
+bool seesaw_Transaction::ok() const
 {
-    Wire.beginTransmission((uint8_t)_i2caddr);
-    Wire.write((uint8_t)regHigh);
-    Wire.write((uint8_t)regLow);
-    Wire.endTransmission();
+	return _ok;
 }
@@ -130,10 +130,34 @@
 #define SEESAW_HW_ID_CODE			0x55
 #define SEESAW_EEPROM_I2C_ADDR 0x3F
 
+/*=========================================================================
+    TURNAROUND TIMES
+    -----------------------------------------------------------------------*/
+    #define SEESAW_READ_TURNAROUND      125     ///< us from register select to the reply being ready
+    #define SEESAW_ADC_TURNAROUND       500     ///< us for an ADC channel, it converts on select
+    #define SEESAW_ADC_RECOVERY         1000    ///< us after an ADC read before the next access
+    #define SEESAW_SERCOM_RECOVERY      1000    ///< us after each byte written to the UART
+    #define SEESAW_SWRST_RECOVERY       10000   ///< us after a software reset before the first poll
+    #define SEESAW_RESET_TIMEOUT        500     ///< ms begin() waits for the seesaw to answer after a reset
+/*=========================================================================*/
+
+#ifndef SEESAW_TRANSACTION_OPS
+  #define SEESAW_TRANSACTION_OPS 4   ///< register accesses one seesaw_Transaction holds
+#endif
+#ifndef SEESAW_BUS_QUEUE_LEN
+  #define SEESAW_BUS_QUEUE_LEN 8     ///< transactions the bus task queues
+#endif
+#ifndef SEESAW_BUS_TASK_PRIO
+  #define SEESAW_BUS_TASK_PRIO TASK_PRIO_LOW
+#endif
+#define SEESAW_BUS_TASK_STACK 256    ///< words
+
+class seesaw_Transaction;
+
 class Adafruit_seesaw : public Print {
 	public:
 		//constructors
-		Adafruit_seesaw(void) {};
+		Adafruit_seesaw(void);
 		~Adafruit_seesaw(void) {};
 		
 		bool begin(uint8_t addr = SEESAW_ADDRESS);
@@ -151,6 +175,7 @@ class Adafruit_seesaw : public Print {
         uint32_t digitalReadBulk(uint32_t pins);
 
         void setGPIOInterrupts(uint32_t pins, bool enabled);
+        uint32_t getGPIOInterruptFlag();
 
         uint16_t analogRead(uint8_t pin);
         void analogReadBulk(uint16_t *buf, uint8_t num);
@@ -174,17 +199,46 @@ class Adafruit_seesaw : public Print {
         virtual size_t write(uint8_t);
         virtual size_t write(const char *str);
 
+        bool run(seesaw_Transaction &t);
+#if defined(ARDUINO_ARCH_NRF52)
+        void setBusLock(SemaphoreHandle_t lock);
+        bool beginBusTask(void);
+        bool submit(seesaw_Transaction &t);
+        bool submitFromISR(seesaw_Transaction &t, BaseType_t *woken);
+#endif
+
 	protected:
 		uint8_t _i2caddr; /*!< The I2C address used to communicate with the seesaw */
 
 		void      write8(byte regHigh, byte regLow, byte value);
         uint8_t   read8(byte regHigh, byte regLow);
 		
-		void read(uint8_t regHigh, uint8_t regLow, uint8_t *buf, uint8_t num, uint16_t delay = 125);
-		void write(uint8_t regHigh, uint8_t regLow, uint8_t *buf, uint8_t num);
-    void writeEmpty(uint8_t regHigh, uint8_t regLow);
+		bool read(uint8_t regHigh, uint8_t regLow, uint8_t *buf, uint8_t num, uint16_t delay = 0);
+		bool write(uint8_t regHigh, uint8_t regLow, uint8_t *buf, uint8_t num);
+    bool writeEmpty(uint8_t regHigh, uint8_t regLow);
 		void _i2c_init();
 
+		virtual uint16_t readTurnaround(uint8_t regHigh, uint8_t regLow);
+		virtual uint16_t recoveryTime(uint8_t regHigh, uint8_t regLow, bool write);
+
+	private:
+		uint32_t _readyAt; /*!< micros() at which the seesaw takes the next access, if _recovering */
+		bool _recovering;
+
+		void _wait_ready();
+		void _set_recovery(uint32_t us);
+		void _bus_lock();
+		void _bus_unlock();
+
+#if defined(ARDUINO_ARCH_NRF52)
+		SemaphoreHandle_t _busLock;  /*!< shared with the other devices on the bus, held per I2C transfer */
+		SemaphoreHandle_t _devLock;  /*!< held per register access, keeps select and reply together */
+		QueueHandle_t _queue;
+		TaskHandle_t _task;
+
+		static void _bus_task(void *arg);
+#endif
+
 /*=========================================================================
 	REGISTER BITFIELDS
     -----------------------------------------------------------------------*/
@@ -216,4 +270,45 @@ class Adafruit_seesaw : public Print {
 /*=========================================================================*/
 };
 
+/**************************************************************************/
+/*!
+    @brief  A batch of seesaw register accesses, executed back to back by
+            Adafruit_seesaw::run() or the bus task (Adafruit_seesaw::submit()).
+            The buffers passed to read() and write() have to stay valid until
+            the transaction completes, the callback then runs in the task that
+            executed it.
+*/
+/**************************************************************************/
+class seesaw_Transaction {
+	public:
+		typedef void (*callback_t)(seesaw_Transaction &t, void *arg);
+
+		seesaw_Transaction(callback_t cb = NULL, void *arg = NULL);
+
+		bool read(uint8_t regHigh, uint8_t regLow, uint8_t *buf, uint8_t num, uint16_t delay = 0);
+		bool write(uint8_t regHigh, uint8_t regLow, uint8_t *buf, uint8_t num);
+		void clear();
+		void onComplete(callback_t cb, void *arg = NULL);
+
+		uint8_t count() const;
+		bool isPending() const;
+		bool ok() const;
+
+	private:
+		friend class Adafruit_seesaw;
+
+		struct op {
+			uint8_t regHigh, regLow, num;
+			bool write;
+			uint16_t delay;
+			uint8_t *buf;
+		};
+		op _ops[SEESAW_TRANSACTION_OPS];
+		uint8_t _num;
+		volatile bool _pending;
+		bool _ok;
+		callback_t _cb;
+		void *_arg;
+};
+
 #endif
\ No newline at end of file
@@ -15,6 +15,8 @@ MenuComponent::MenuComponent(const char* name, SelectFnPtr select_fn)
 : _name(name),
   _has_focus(false),
   _is_current(false),
+  _is_dirty(true),
+  _p_container(nullptr),
   _select_fn(select_fn) {
 }
 
@@ -24,6 +26,7 @@ const char* MenuComponent::get_name() const {
 
 void MenuComponent::set_name(const char* name) {
     _name = name;
+    set_dirty();
 }
 
 bool MenuComponent::has_focus() const {
@@ -35,9 +38,25 @@ bool MenuComponent::is_current() const {
 }
 
 void MenuComponent::set_current(bool is_current) {
+    if (_is_current != is_current)
+        set_dirty();
     _is_current = is_current;
 }
 
+bool MenuComponent::is_dirty() const {
+    return _is_dirty;
+}
+
+void MenuComponent::set_dirty() {
+    _is_dirty = true;
+    if (_p_container != nullptr)
+        _p_container->_has_dirty_components = true;
+}
+
+void MenuComponent::clear_dirty() const {
+    _is_dirty = false;
+}
+
 Menu* MenuComponent::select() {
     if (_select_fn != nullptr)
         _select_fn(this);
@@ -60,7 +79,8 @@ Menu::Menu(const char* name, SelectFnPtr select_fn)
   _p_parent(nullptr),
   _num_components(0),
   _current_component_num(0),
-  _previous_component_num(0) {
+  _previous_component_num(0),
+  _has_dirty_components(false) {
 }
 
 bool Menu::next(bool loop) {
@@ -159,6 +179,9 @@ void Menu::add_component(MenuComponent* p_component) {
       return;
 
     _menu_components[_num_components] = p_component;
+    p_component->_p_container = this;
+    if (p_component->is_dirty())
+        _has_dirty_components = true;
 
     if (_num_components == 0) {
         _p_current_component = p_component;
@@ -196,6 +219,18 @@ uint8_t Menu::get_previous_component_num() const {
     return _previous_component_num;
 }
 
+bool Menu::has_dirty_components() const {
+    return _has_dirty_components;
+}
+
+void Menu::clear_dirty() const {
+    for (int i = 0; i < _num_components; ++i)
+        _menu_components[i]->clear_dirty();
+
+    _has_dirty_components = false;
+    MenuComponent::clear_dirty();
+}
+
 void Menu::render(MenuComponentRenderer const& renderer) const {
     renderer.render_menu(*this);
 }
@@ -260,6 +295,7 @@ bool MenuItem::prev(bool loop) {
 ConfigMenuItem::ConfigMenuItem(char* configVal, const char* name, SelectFnPtr select_fn)
 : MenuItem(name, select_fn){
     _config_value = (char*)malloc(1);
+    *_config_value = '\0';
     set_value(configVal);
 }
 
@@ -288,6 +324,11 @@ char* ConfigMenuItem::get_value() const{
     return _config_value;
 }
 void ConfigMenuItem::set_value(char* value){
+    // Same text, nothing to redraw
+    if (strcmp(_config_value, value) == 0)
+        return;
+
+    set_dirty();
     free(_config_value);
     int len = strlen(value);
     //Serial.println(len);
@@ -323,10 +364,12 @@ NumericMenuItem::NumericMenuItem(const char* basename, SelectFnPtr select_fn,
 
 void NumericMenuItem::set_number_formatter(FormatValueFnPtr format_value_fn) {
     _format_value_fn = format_value_fn;
+    set_dirty();
 }
 
 Menu* NumericMenuItem::select() {
     _has_focus = !_has_focus;
+    set_dirty();
 
     // Only run _select_fn when the user is done editing the value
     if (!_has_focus && _select_fn != nullptr)
@@ -360,6 +403,8 @@ String NumericMenuItem::get_formatted_value() const {
 }
 
 void NumericMenuItem::set_value(float value) {
+    if (_value != value)
+        set_dirty();
     _value = value;
 }
 
@@ -372,27 +417,234 @@ void NumericMenuItem::set_max_value(float value) {
 }
 
 bool NumericMenuItem::next(bool loop) {
-    _value += _increment;
-    if (_value > _max_value) {
+    float value = _value + _increment;
+    if (value > _max_value) {
         if (loop)
-            _value = _min_value;
+            value = _min_value;
         else
-            _value = _max_value;
+            value = _max_value;
     }
+    set_value(value);
     return true;
 }
 
 bool NumericMenuItem::prev(bool loop) {
-    _value -= _increment;
-    if (_value < _min_value) {
+    float value = _value - _increment;
+    if (value < _min_value) {
         if (loop)
-            _value = _max_value;
+            value = _max_value;
         else
-            _value = _min_value;
+            value = _min_value;
     }
+    set_value(value);
     return true;
 }
 
+// *********************************************************
+// ValueMenuItem
+// *********************************************************
+
+ValueMenuItem::ValueMenuItem(const char* name, SelectFnPtr select_fn)
+: MenuItem(name, select_fn) {
+}
+
+void ValueMenuItem::render(MenuComponentRenderer const& renderer) const {
+    renderer.render_value_menu_item(*this);
+}
+
+uint8_t ValueMenuItem::copy_value(char* buffer, uint8_t size, const char* text) {
+    if (!size)
+        return 0;
+
+    uint8_t len = 0;
+    while (text[len] != '\0' && len < size - 1) {
+        buffer[len] = text[len];
+        len++;
+    }
+    buffer[len] = '\0';
+    return len;
+}
+
+// *********************************************************
+// BoolMenuItem
+// *********************************************************
+
+BoolMenuItem::BoolMenuItem(const char* name, SelectFnPtr select_fn, bool value,
+                           const char* false_label, const char* true_label)
+: ValueMenuItem(name, select_fn),
+  _false_label(false_label),
+  _true_label(true_label),
+  _value(value) {
+}
+
+bool BoolMenuItem::get_value() const {
+    return _value;
+}
+
+void BoolMenuItem::set_value(bool value) {
+    if (_value != value)
+        set_dirty();
+    _value = value;
+}
+
+uint8_t BoolMenuItem::format_value(char* buffer, uint8_t size) const {
+    return copy_value(buffer, size, _value ? _true_label : _false_label);
+}
+
+Menu* BoolMenuItem::select() {
+    set_value(!_value);
+    MenuComponent::select();
+    return nullptr;
+}
+
+// *********************************************************
+// EnumMenuItem
+// *********************************************************
+
+EnumMenuItem::EnumMenuItem(const char* name, SelectFnPtr select_fn,
+                           const char* const* labels, uint8_t num_labels,
+                           uint8_t value)
+: ValueMenuItem(name, select_fn),
+  _labels(labels),
+  _num_labels(num_labels),
+  _value(value < num_labels ? value : 0) {
+}
+
+uint8_t EnumMenuItem::get_value() const {
+    return _value;
+}
+
+void EnumMenuItem::set_value(uint8_t value) {
+    if (value >= _num_labels)
+        return;
+
+    if (_value != value)
+        set_dirty();
+    _value = value;
+}
+
+const char* EnumMenuItem::get_label() const {
+    return _num_labels ? _labels[_value] : "";
+}
+
+uint8_t EnumMenuItem::format_value(char* buffer, uint8_t size) const {
+    return copy_value(buffer, size, get_label());
+}
+
+Menu* EnumMenuItem::select() {
+    if (_num_labels)
+        set_value((_value + 1) % _num_labels);
+    MenuComponent::select();
+    return nullptr;
+}
+
+// *********************************************************
+// FixedPointMenuItem
+// *********************************************************
+
+FixedPointMenuItem::FixedPointMenuItem(const char* name, SelectFnPtr select_fn,
+                                       int32_t value, int32_t min_value,
+                                       int32_t max_value, int32_t increment,
+                                       uint8_t decimals)
+: ValueMenuItem(name, select_fn),
+  _value(value),
+  _min_value(min_value),
+  _max_value(max_value),
+  _increment(increment),
+  _decimals(decimals > 9 ? 9 : decimals) {
+    if (_increment < 0) _increment = -_increment;
+    if (_min_value > _max_value) {
+        int32_t tmp = _max_value;
+        _max_value = _min_value;
+        _min_value = tmp;
+    }
+    set_value(_value);
+}
+
+int32_t FixedPointMenuItem::get_value() const {
+    return _value;
+}
+
+int32_t FixedPointMenuItem::get_min_value() const {
+    return _min_value;
+}
+
+int32_t FixedPointMenuItem::get_max_value() const {
+    return _max_value;
+}
+
+uint8_t FixedPointMenuItem::get_decimals() const {
+    return _decimals;
+}
+
+void FixedPointMenuItem::set_value(int32_t value) {
+    if (value < _min_value)
+        value = _min_value;
+    else if (value > _max_value)
+        value = _max_value;
+
+    if (_value != value)
+        set_dirty();
+    _value = value;
+}
+
+uint8_t FixedPointMenuItem::format_value(char* buffer, uint8_t size) const {
+    // Digits backwards, at least one before the decimal point
+    char digits[12];
+    uint8_t n = 0;
+    uint32_t magnitude = _value < 0 ? 0u - (uint32_t)_value : (uint32_t)_value;
+    do {
+        digits[n++] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude || n <= _decimals);
+
+    char text[14];
+    uint8_t len = 0;
+    if (_value < 0)
+        text[len++] = '-';
+    while (n) {
+        if (n == _decimals)
+            text[len++] = '.';
+        text[len++] = digits[--n];
+    }
+    text[len] = '\0';
+    return copy_value(buffer, size, text);
+}
+
+bool FixedPointMenuItem::next(bool loop) {
+    if (_value > _max_value - _increment)
+        set_value(loop ? _min_value : _max_value);
+    else
+        set_value(_value + _increment);
+    return true;
+}
+
+bool FixedPointMenuItem::prev(bool loop) {
+    if (_value < _min_value + _increment)
+        set_value(loop ? _max_value : _min_value);
+    else
+        set_value(_value - _increment);
+    return true;
+}
+
+Menu* FixedPointMenuItem::select() {
+    _has_focus = !_has_focus;
+    set_dirty();
+
+    // Only run _select_fn when the user is done editing the value
+    if (!_has_focus && _select_fn != nullptr)
+        _select_fn(this);
+    return nullptr;
+}
+
+// *********************************************************
+// MenuComponentRenderer
+// *********************************************************
+
+void MenuComponentRenderer::render_value_menu_item(ValueMenuItem const& menu_item) const {
+    render_menu_item(menu_item);
+}
+
 // *********************************************************
 // MenuSystem
 // *********************************************************
@@ -420,14 +672,16 @@ bool MenuSystem::prev(bool loop) {
 void MenuSystem::reset() {
     _p_curr_menu = _p_root_menu;
     _p_root_menu->reset();
+    _p_curr_menu->set_dirty();
 }
 
 void MenuSystem::select(bool reset) {
     Menu* pMenu = _p_curr_menu->activate();
 
-    if (pMenu != nullptr)
+    if (pMenu != nullptr) {
         _p_curr_menu = pMenu;
-    else
+        _p_curr_menu->set_dirty();
+    } else
         if (reset)
             this->reset();
 }
@@ -435,6 +689,7 @@ void MenuSystem::select(bool reset) {
 bool MenuSystem::back() {
     if (_p_curr_menu != _p_root_menu) {
         _p_curr_menu = const_cast<Menu*>(_p_curr_menu->get_parent());
+        _p_curr_menu->set_dirty();
         return true;
     }
 
@@ -454,3 +709,159 @@ void MenuSystem::display() const {
     if (_p_curr_menu != nullptr)
         _renderer.render(*_p_curr_menu);
 }
+
+bool MenuSystem::is_dirty() const {
+    return _p_curr_menu->is_dirty() || _p_curr_menu->has_dirty_components();
+}
+
+void MenuSystem::invalidate() {
+    _p_curr_menu->set_dirty();
+}
+
+// *********************************************************
+// MenuNode
+// *********************************************************
+
+uint8_t MenuNode::format_value(char* buffer, uint8_t size) const {
+    if (format_value_fn != nullptr)
+        return format_value_fn(buffer, size);
+
+    if (size)
+        buffer[0] = '\0';
+    return 0;
+}
+
+// *********************************************************
+// FlashMenuSystem
+// *********************************************************
+
+FlashMenuSystem::FlashMenuSystem(MenuNode const& root,
+                                 FlashMenuRenderer const& renderer)
+: _root(root),
+  _p_curr_menu(&root),
+  _renderer(renderer),
+  _depth(0),
+  _current_component_num(0),
+  _previous_component_num(0),
+  _dirty(DIRTY_MENU) {
+}
+
+void FlashMenuSystem::enter(MenuNode const* p_menu, uint8_t num) {
+    _p_curr_menu = p_menu;
+    _current_component_num = num;
+    _previous_component_num = num;
+    _dirty = DIRTY_MENU;
+}
+
+bool FlashMenuSystem::next(bool loop) {
+    _previous_component_num = _current_component_num;
+
+    if (_current_component_num != _p_curr_menu->num_children - 1)
+        _current_component_num++;
+    else if (loop && _p_curr_menu->num_children > 1)
+        _current_component_num = 0;
+    else
+        return false;
+
+    _dirty |= DIRTY_CURRENT | DIRTY_PREVIOUS;
+    return true;
+}
+
+bool FlashMenuSystem::prev(bool loop) {
+    _previous_component_num = _current_component_num;
+
+    if (_current_component_num != 0)
+        _current_component_num--;
+    else if (loop && _p_curr_menu->num_children > 1)
+        _current_component_num = _p_curr_menu->num_children - 1;
+    else
+        return false;
+
+    _dirty |= DIRTY_CURRENT | DIRTY_PREVIOUS;
+    return true;
+}
+
+void FlashMenuSystem::reset() {
+    _depth = 0;
+    enter(&_root, 0);
+}
+
+void FlashMenuSystem::select(bool reset) {
+    MenuNode const& node = get_current_component();
+
+    if (node.select_fn != nullptr)
+        node.select_fn(node);
+
+    switch (node.kind) {
+    case MenuNode::MENU:
+        // Too deep to come back: stay where we are
+        if (_depth == FLASH_MENU_MAX_DEPTH)
+            return;
+        _path[_depth++] = _current_component_num;
+        enter(&node, 0);
+        break;
+    case MenuNode::BACK:
+        back();
+        break;
+    default:
+        _dirty |= DIRTY_CURRENT;
+        if (reset)
+            this->reset();
+        break;
+    }
+}
+
+bool FlashMenuSystem::back() {
+    if (!_depth)
+        return false;
+
+    // Walk down from the root again instead of keeping parent pointers
+    uint8_t num = _path[--_depth];
+    MenuNode const* p_menu = &_root;
+    for (uint8_t i = 0; i < _depth; ++i)
+        p_menu = &p_menu->children[_path[i]];
+    enter(p_menu, num);
+    return true;
+}
+
+bool FlashMenuSystem::is_dirty() const {
+    return _dirty != 0;
+}
+
+void FlashMenuSystem::set_dirty() {
+    _dirty |= DIRTY_CURRENT;
+}
+
+void FlashMenuSystem::invalidate() {
+    _dirty |= DIRTY_MENU;
+}
+
+MenuNode const& FlashMenuSystem::get_root_menu() const {
+    return _root;
+}
+
+MenuNode const& FlashMenuSystem::get_current_menu() const {
+    return *_p_curr_menu;
+}
+
+MenuNode const& FlashMenuSystem::get_current_component() const {
+    return _p_curr_menu->children[_current_component_num];
+}
+
+uint8_t FlashMenuSystem::get_current_component_num() const {
+    return _current_component_num;
+}
+
+uint8_t FlashMenuSystem::get_previous_component_num() const {
+    return _previous_component_num;
+}
+
+uint8_t FlashMenuSystem::get_depth() const {
+    return _depth;
+}
+
+void FlashMenuSystem::display() const {
+    _renderer.render(*_p_curr_menu, _current_component_num,
+                     _previous_component_num, _dirty);
+    _dirty = 0;
+}
@@ -15,6 +15,12 @@
 class Menu;
 class MenuComponentRenderer;
 class MenuSystem;
+class FlashMenuRenderer;
+
+//! \brief Deepest submenu nesting FlashMenuSystem can track
+#ifndef FLASH_MENU_MAX_DEPTH
+  #define FLASH_MENU_MAX_DEPTH 4
+#endif
 
 //! \brief Abstract base class that represents a component in the menu
 //!
@@ -96,6 +102,30 @@ public:
     //! \see MenuComponent::set_current
     bool is_current() const;
 
+    //! \brief Returns true if the component changed since it was last drawn
+    //!
+    //! A component becomes dirty when it becomes or stops being the current
+    //! component, gains or loses focus or when its name or value changes.
+    //! The Menu containing it is told as well (see
+    //! Menu::has_dirty_components), so renderers can redraw only the
+    //! components that changed. Components start out dirty.
+    //!
+    //! \returns true if the component needs to be redrawn, false otherwise.
+    //!
+    //! \see MenuComponent::clear_dirty
+    bool is_dirty() const;
+
+    //! \brief Marks the component as changed
+    //!
+    //! For state kept outside of the component that changes the way it is
+    //! rendered.
+    void set_dirty();
+
+    //! \brief Marks the component as drawn
+    //!
+    //! Renderers call this once the component is on screen.
+    virtual void clear_dirty() const;
+
     //! \brief Sets the function to call when the MenuItem is selected
     //! \param[in] select_fn The function to call when the MenuItem is
     //!                      selected.
@@ -173,6 +203,8 @@ protected:
     const char* _name;
     bool _has_focus;
     bool _is_current;
+    mutable bool _is_dirty;
+    Menu* _p_container; //!< The Menu this component was added to
     SelectFnPtr _select_fn;
 };
 
@@ -329,6 +361,156 @@ protected:
 };
 
 
+//! \brief Abstract base class for menu items that show a value
+//!
+//! The value is kept in the item itself and formatted into a buffer
+//! supplied by the caller, so neither changing nor rendering it uses the
+//! heap. Renderers draw these items in
+//! MenuComponentRenderer::render_value_menu_item.
+//!
+//! \see BoolMenuItem
+//! \see EnumMenuItem
+//! \see FixedPointMenuItem
+class ValueMenuItem : public MenuItem {
+public:
+    //! \brief Construct a ValueMenuItem
+    //! \param[in] name The name of the menu component that is displayed in
+    //!                 clients.
+    //! \param[in] select_fn The function to call when the MenuItem is
+    //!                      selected.
+    ValueMenuItem(const char* name, SelectFnPtr select_fn);
+
+    //! \brief Formats the value
+    //!
+    //! \param[out] buffer Receives the value as a nul terminated string,
+    //!                    cut short if it doesn't fit.
+    //! \param[in] size The size of buffer in bytes.
+    //! \returns The length of the string written to buffer.
+    virtual uint8_t format_value(char* buffer, uint8_t size) const = 0;
+
+    //! \copydoc MenuComponent::render
+    virtual void render(MenuComponentRenderer const& renderer) const;
+
+protected:
+    //! \brief Copies text into buffer as format_value does
+    static uint8_t copy_value(char* buffer, uint8_t size, const char* text);
+};
+
+
+//! \brief A ValueMenuItem holding an on/off value
+//!
+//! Selecting the item toggles the value before select_fn is called, so the
+//! callback sees the new value.
+class BoolMenuItem : public ValueMenuItem {
+public:
+    //! \brief Construct a BoolMenuItem
+    //! \param[in] name The name of the menu item.
+    //! \param[in] select_fn The function to call after the value toggled.
+    //! \param[in] value Initial value.
+    //! \param[in] false_label Shown when the value is false.
+    //! \param[in] true_label Shown when the value is true.
+    BoolMenuItem(const char* name, SelectFnPtr select_fn, bool value=false,
+                 const char* false_label="Off", const char* true_label="On");
+
+    bool get_value() const;
+    void set_value(bool value);
+
+    //! \copydoc ValueMenuItem::format_value
+    virtual uint8_t format_value(char* buffer, uint8_t size) const;
+
+protected:
+    //! \copydoc MenuComponent:select
+    virtual Menu* select();
+
+protected:
+    const char* _false_label;
+    const char* _true_label;
+    bool _value;
+};
+
+
+//! \brief A ValueMenuItem holding one of a fixed set of values
+//!
+//! The value is an index into a table of labels, which is not copied and
+//! can stay in flash. Selecting the item moves to the next value (wrapping
+//! around) before select_fn is called.
+class EnumMenuItem : public ValueMenuItem {
+public:
+    //! \brief Construct an EnumMenuItem
+    //! \param[in] name The name of the menu item.
+    //! \param[in] select_fn The function to call after the value changed.
+    //! \param[in] labels The label of each value.
+    //! \param[in] num_labels The number of values.
+    //! \param[in] value Initial value, an index into labels.
+    EnumMenuItem(const char* name, SelectFnPtr select_fn,
+                 const char* const* labels, uint8_t num_labels,
+                 uint8_t value=0);
+
+    uint8_t get_value() const;
+    //! \brief Sets the value, out of range values are ignored
+    void set_value(uint8_t value);
+    const char* get_label() const;
+
+    //! \copydoc ValueMenuItem::format_value
+    virtual uint8_t format_value(char* buffer, uint8_t size) const;
+
+protected:
+    //! \copydoc MenuComponent:select
+    virtual Menu* select();
+
+protected:
+    const char* const* _labels;
+    uint8_t _num_labels;
+    uint8_t _value;
+};
+
+
+//! \brief A ValueMenuItem holding a fixed-point number
+//!
+//! Works like NumericMenuItem without floats or Strings: the value is an
+//! integer count of 10^-decimals units. Selecting the item toggles focus,
+//! next and prev step the value while it has focus and select_fn is called
+//! when editing is done.
+class FixedPointMenuItem : public ValueMenuItem {
+public:
+    //! \brief Construct a FixedPointMenuItem
+    //! \param[in] name The name of the menu item.
+    //! \param[in] select_fn The function to call when editing is done.
+    //! \param[in] value Initial value, in units of 10^-decimals.
+    //! \param[in] min_value The minimum value.
+    //! \param[in] max_value The maximum value.
+    //! \param[in] increment How much next/prev change the value by.
+    //! \param[in] decimals Digits after the decimal point (0-9).
+    FixedPointMenuItem(const char* name, SelectFnPtr select_fn,
+                       int32_t value, int32_t min_value, int32_t max_value,
+                       int32_t increment=1, uint8_t decimals=0);
+
+    int32_t get_value() const;
+    int32_t get_min_value() const;
+    int32_t get_max_value() const;
+    uint8_t get_decimals() const;
+
+    //! \brief Sets the value, clamped to the range
+    void set_value(int32_t value);
+
+    //! \copydoc ValueMenuItem::format_value
+    virtual uint8_t format_value(char* buffer, uint8_t size) const;
+
+protected:
+    virtual bool next(bool loop=false);
+    virtual bool prev(bool loop=false);
+
+    virtual Menu* select();
+
+protected:
+    int32_t _value;
+    int32_t _min_value;
+    int32_t _max_value;
+    int32_t _increment;
+    uint8_t _decimals;
+};
+
+
 //! \brief A MenuComponent that can contain other MenuComponents.
 //!
 //! Menu represents the branch in the composite design pattern (see:
@@ -339,6 +521,7 @@ protected:
 //! \see MenuItem
 class Menu : public MenuComponent {
     friend class MenuSystem;
+    friend class MenuComponent;
 public:
     Menu(const char* name, SelectFnPtr select_fn=nullptr);
 
@@ -355,6 +538,19 @@ public:
     uint8_t get_current_component_num() const;
     uint8_t get_previous_component_num() const;
 
+    //! \brief Returns true if any of the menu's components is dirty
+    //!
+    //! The menu itself being dirty (MenuComponent::is_dirty) means it has to
+    //! be redrawn as a whole, e.g. because it has just been entered.
+    //!
+    //! \see MenuComponent::is_dirty
+    bool has_dirty_components() const;
+
+    //! \copydoc MenuComponent::clear_dirty
+    //!
+    //! The menu's components are marked as drawn too.
+    virtual void clear_dirty() const;
+
     //! \copydoc MenuComponent::render
     void render(MenuComponentRenderer const& renderer) const;
 
@@ -389,6 +585,7 @@ private:
     uint8_t _num_components;
     uint8_t _current_component_num;
     uint8_t _previous_component_num;
+    mutable bool _has_dirty_components;
 };
 
 
@@ -397,6 +594,18 @@ public:
     MenuSystem(MenuComponentRenderer const& renderer);
 
     void display() const;
+
+    //! \brief Returns true if display() would draw anything new
+    //!
+    //! That is if the current menu has been entered or invalidated, or any
+    //! of its components changed since it was last displayed.
+    bool is_dirty() const;
+
+    //! \brief Makes the next display() redraw the current menu as a whole
+    //!
+    //! For when something else has been drawn over the menu.
+    void invalidate();
+
     bool next(bool loop=false);
     bool prev(bool loop=false);
     void reset();
@@ -422,6 +631,152 @@ public:
     virtual void render_back_menu_item(BackMenuItem const& menu_item) const = 0;
     virtual void render_numeric_menu_item(NumericMenuItem const& menu_item) const = 0;
     virtual void render_menu(Menu const& menu) const = 0;
+
+    //! \brief Renders a BoolMenuItem, EnumMenuItem or FixedPointMenuItem
+    //!
+    //! Get the value with ValueMenuItem::format_value. The default
+    //! implementation renders it like a MenuItem (name only).
+    virtual void render_value_menu_item(ValueMenuItem const& menu_item) const;
+};
+
+
+//! \brief An entry of a menu tree that is fixed at compile time
+//!
+//! Trees are built from constexpr arrays of nodes, which the compiler keeps
+//! in flash on ARM targets (on AVR constant data is copied to RAM). The
+//! tree itself never changes; FlashMenuSystem keeps the little state
+//! navigation needs.
+//!
+//! \code
+//! constexpr MenuNode settings[] = {
+//!     MenuNode::item("Bonding", &on_bonding, &format_bonding),
+//!     MenuNode::back("Back"),
+//! };
+//! constexpr MenuNode main_menu[] = {
+//!     MenuNode::item("LED", &on_led),
+//!     MenuNode::menu("Settings", settings),
+//! };
+//! constexpr MenuNode root = MenuNode::menu("", main_menu);
+//! \endcode
+//!
+//! \see FlashMenuSystem
+struct MenuNode {
+    //! \brief Callback for when the node is selected
+    using SelectFnPtr = void (*)(MenuNode const& node);
+
+    //! \brief Callback formatting a value to show next to the name
+    //!
+    //! Works like ValueMenuItem::format_value, the value lives wherever the
+    //! application keeps it.
+    using FormatValueFnPtr = uint8_t (*)(char* buffer, uint8_t size);
+
+    enum Kind : uint8_t { ITEM, MENU, BACK };
+
+    const char* name;
+    SelectFnPtr select_fn;
+    FormatValueFnPtr format_value_fn;
+    const MenuNode* children;
+    uint8_t num_children;
+    Kind kind;
+
+    //! \brief An item calling select_fn when selected
+    static constexpr MenuNode item(const char* name, SelectFnPtr select_fn,
+                                   FormatValueFnPtr format_value_fn=nullptr) {
+        return MenuNode{name, select_fn, format_value_fn, nullptr, 0, ITEM};
+    }
+
+    //! \brief A submenu with the given entries
+    template <size_t N>
+    static constexpr MenuNode menu(const char* name, const MenuNode (&children)[N],
+                                   SelectFnPtr select_fn=nullptr) {
+        static_assert(N > 0 && N < 256, "a menu has 1 to 255 entries");
+        return MenuNode{name, select_fn, nullptr, children, (uint8_t)N, MENU};
+    }
+
+    //! \brief An item going back to the parent menu when selected
+    static constexpr MenuNode back(const char* name, SelectFnPtr select_fn=nullptr) {
+        return MenuNode{name, select_fn, nullptr, nullptr, 0, BACK};
+    }
+
+    //! \brief Formats the node's value, an empty string if it has none
+    uint8_t format_value(char* buffer, uint8_t size) const;
+};
+
+
+//! \brief Navigates a MenuNode tree
+//!
+//! The counterpart of MenuSystem for trees fixed at compile time: nothing
+//! is built in setup() and the only RAM used is this object, the current
+//! menu and the position in each menu on the way down to it.
+//!
+//! Changes are tracked like MenuComponent::is_dirty: moving to another
+//! entry dirties the old and the new one, selecting an item dirties it
+//! (its callback may have changed the value) and entering or leaving a
+//! menu dirties the whole menu.
+class FlashMenuSystem {
+public:
+    //! \brief Flags passed to FlashMenuRenderer::render
+    enum Dirty : uint8_t {
+        DIRTY_MENU = 0x01,      //!< Everything
+        DIRTY_CURRENT = 0x02,   //!< The current entry
+        DIRTY_PREVIOUS = 0x04   //!< The entry that was current before
+    };
+
+    FlashMenuSystem(MenuNode const& root, FlashMenuRenderer const& renderer);
+
+    //! \brief Renders the current menu and marks it as drawn
+    void display() const;
+    bool next(bool loop=false);
+    bool prev(bool loop=false);
+    void reset();
+    void select(bool reset=false);
+    bool back();
+
+    //! \brief Returns true if display() would draw anything new
+    bool is_dirty() const;
+
+    //! \brief Marks the current entry as changed
+    //!
+    //! For values changed outside of the menu.
+    void set_dirty();
+
+    //! \brief Makes the next display() redraw the current menu as a whole
+    void invalidate();
+
+    MenuNode const& get_root_menu() const;
+    MenuNode const& get_current_menu() const;
+    MenuNode const& get_current_component() const;
+    uint8_t get_current_component_num() const;
+    uint8_t get_previous_component_num() const;
+
+    //! \brief Nesting of the current menu, 0 for the root
+    uint8_t get_depth() const;
+
+private:
+    void enter(MenuNode const* p_menu, uint8_t num);
+
+    MenuNode const& _root;
+    MenuNode const* _p_curr_menu;
+    FlashMenuRenderer const& _renderer;
+    uint8_t _path[FLASH_MENU_MAX_DEPTH]; // Entry chosen in each parent menu
+    uint8_t _depth;
+    uint8_t _current_component_num;
+    uint8_t _previous_component_num;
+    mutable uint8_t _dirty;
+};
+
+
+class FlashMenuRenderer {
+public:
+    //! \brief Renders a menu of a MenuNode tree
+    //!
+    //! \param[in] menu The menu to render.
+    //! \param[in] current The index of the current entry.
+    //! \param[in] previous The index of the entry that was current before.
+    //! \param[in] dirty What changed since the last render, a combination
+    //!                  of FlashMenuSystem::Dirty flags.
+    virtual void render(MenuNode const& menu, uint8_t current, uint8_t previous,
+                        uint8_t dirty) const = 0;
 };
 
 
@@ -0,0 +1,117 @@
+/*
+ * flash_menu.ino - Example code using the menu system library.
+ *
+ * This example builds the menu at compile time from MenuNode arrays and
+ * only prints what changed between two renders.
+ *
+ * Copyright (c) 2015 arduino-menusystem
+ * Licensed under the MIT license (see LICENSE)
+ */
+
+#include <MenuSystem.h>
+
+// values shown in the menu
+
+bool led = false;
+uint8_t volume = 5;
+
+uint8_t format_led(char* buffer, uint8_t size) {
+    return snprintf(buffer, size, "%s", led ? "On" : "Off");
+}
+
+uint8_t format_volume(char* buffer, uint8_t size) {
+    return snprintf(buffer, size, "%u", volume);
+}
+
+// Menu callback functions
+
+bool done = false;
+
+void on_led_selected(MenuNode const& node) {
+    led = !led;
+}
+
+void on_volume_selected(MenuNode const& node) {
+    volume = (volume + 1) % 11;
+}
+
+void on_done_selected(MenuNode const& node) {
+    Serial.println("Done Selected");
+    done = true;
+}
+
+// Menu tree, nothing of it is built at runtime
+
+constexpr MenuNode sound_menu[] = {
+    MenuNode::item("Volume", &on_volume_selected, &format_volume),
+    MenuNode::back("Back"),
+};
+
+constexpr MenuNode main_menu[] = {
+    MenuNode::item("LED", &on_led_selected, &format_led),
+    MenuNode::menu("Sound", sound_menu),
+    MenuNode::item("Done", &on_done_selected),
+};
+
+constexpr MenuNode root = MenuNode::menu("Main", main_menu);
+
+// renderer
+
+class MyRenderer : public FlashMenuRenderer {
+public:
+    void render(MenuNode const& menu, uint8_t current, uint8_t previous,
+                uint8_t dirty) const {
+        if (dirty & FlashMenuSystem::DIRTY_MENU) {
+            Serial.println("");
+            Serial.println(menu.name);
+            for (int i = 0; i < menu.num_children; ++i)
+                render_entry(menu, i, current);
+            return;
+        }
+        if (dirty & FlashMenuSystem::DIRTY_PREVIOUS)
+            render_entry(menu, previous, current);
+        if (dirty & FlashMenuSystem::DIRTY_CURRENT)
+            render_entry(menu, current, current);
+    }
+
+    void render_entry(MenuNode const& menu, uint8_t i, uint8_t current) const {
+        char value[8];
+        MenuNode const& node = menu.children[i];
+
+        Serial.print(i);
+        Serial.print(": ");
+        Serial.print(node.name);
+        if (node.format_value(value, sizeof(value))) {
+            Serial.print(" = ");
+            Serial.print(value);
+        }
+        if (i == current)
+            Serial.print(" <<<");
+        Serial.println("");
+    }
+};
+MyRenderer my_renderer;
+
+FlashMenuSystem ms(root, my_renderer);
+
+// Standard arduino functions
+
+void setup() {
+    Serial.begin(9600);
+}
+
+void loop() {
+    if (ms.is_dirty())
+        ms.display();
+
+    // Simulate using the menu by walking over the entire structure.
+    ms.select();
+    ms.next();
+
+    if (done) {
+        ms.reset();
+        done = false;
+    }
+
+    delay(2000);
+}